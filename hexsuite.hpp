@@ -4,4 +4,24 @@
 #include "hexsuite/components.hpp"
 #include "hexsuite/ranges.hpp"
 #include "hexsuite/print.hpp"
-#include "hexsuite/architecture.hpp"
\ No newline at end of file
+#include "hexsuite/architecture.hpp"
+#include "hexsuite/bitset.hpp"
+#include "hexsuite/events.hpp"
+#include "hexsuite/expressions.hpp"
+#include "hexsuite/patterns.hpp"
+#include "hexsuite/hash.hpp"
+#include "hexsuite/profiling.hpp"
+#include "hexsuite/dataflow.hpp"
+#include "hexsuite/dominators.hpp"
+#include "hexsuite/use_def.hpp"
+#include "hexsuite/evaluator.hpp"
+#include "hexsuite/opcodes.hpp"
+#include "hexsuite/types.hpp"
+#include "hexsuite/snapshot.hpp"
+#include "hexsuite/async.hpp"
+#include "hexsuite/scheduler.hpp"
+#include "hexsuite/mapped_file.hpp"
+#include "hexsuite/trace.hpp"
+#include "hexsuite/trace_source.hpp"
+#include "hexsuite/decompile_cache.hpp"
+#include "hexsuite/dirty_tracker.hpp"
\ No newline at end of file
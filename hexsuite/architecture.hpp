@@ -1,7 +1,12 @@
 #pragma once
 #include <memory>
 #include <concepts>
+#include <array>
+#include <vector>
+#include <mutex>
+#include <type_traits>
 #include "ida.hpp"
+#include "opcodes.hpp"
 
 namespace hex
 {
@@ -97,6 +102,7 @@ namespace hex
 		ci->role = ROLE_UNK;
 		ci->flags = FCI_FINAL | FCI_PROP;
 		ci->return_type = ret;
+		ci->args.reserve( sizeof...( Tx ) );
 		detail::push_arg( ci.get(), std::forward<Tx>( args )... );
 		return ci;
 	}
@@ -107,6 +113,97 @@ namespace hex
 		ci->flags |= FCI_PURE;
 		return ci;
 	}
+	// Maps C++ types to type information, each type is constructed once.
+	//
+	namespace detail
+	{
+		template<typename T>
+		inline tinfo_t make_type()
+		{
+			if constexpr ( std::is_void_v<T> )                                return tinfo_t{ BTF_VOID };
+			else if constexpr ( std::is_same_v<T, bool> )                     return tinfo_t{ BTF_BOOL };
+			else if constexpr ( std::is_same_v<T, float> )                    return tinfo_t{ BTF_FLOAT };
+			else if constexpr ( std::is_same_v<T, double> )                   return tinfo_t{ BTF_DOUBLE };
+			else if constexpr ( std::is_pointer_v<T> )
+			{
+				tinfo_t result;
+				result.create_ptr( make_type<std::remove_cv_t<std::remove_pointer_t<T>>>() );
+				return result;
+			}
+			else if constexpr ( std::is_integral_v<T> )
+			{
+				constexpr type_t base = sizeof( T ) == 1 ? BT_INT8 : sizeof( T ) == 2 ? BT_INT16 : sizeof( T ) == 4 ? BT_INT32 : BT_INT64;
+				return tinfo_t{ type_t( base | ( std::is_signed_v<T> ? BTMT_SIGNED : BTMT_UNSIGNED ) ) };
+			}
+			else
+			{
+				static_assert( sizeof( T ) == 0, "Type has no type information mapping." );
+			}
+		}
+	};
+	template<typename T>
+	inline const tinfo_t& type_of()
+	{
+		static const tinfo_t type = detail::make_type<std::remove_cv_t<T>>();
+		return type;
+	}
+
+	// Compile-time call signatures:
+	//  Each signature keeps prototype call-infos per calling convention and flags with the return and argument types
+	//  already filled in, so creating a call only copies the prototype and assigns the argument operands.
+	//
+	template<typename F>
+	struct signature;
+	template<typename R, typename... Args>
+	struct signature<R( Args... )>
+	{
+		static constexpr size_t arity = sizeof...( Args );
+		static constexpr int default_flags = FCI_FINAL | FCI_PROP;
+
+		static const tinfo_t& return_type() { return type_of<R>(); }
+
+		static const mcallinfo_t& prototype( cm_t cc = CM_CC_FASTCALL, int flags = default_flags )
+		{
+			struct entry
+			{
+				cm_t cc;
+				int flags;
+				std::unique_ptr<mcallinfo_t> ci;
+			};
+			// Prototypes are boxed so that the references handed out stay valid while the cache grows, the lock only
+			// covers the lookup.
+			//
+			static std::mutex lock;
+			static std::vector<entry> cache;
+			std::lock_guard _g{ lock };
+			for ( auto& e : cache )
+				if ( e.cc == cc && e.flags == flags )
+					return *e.ci;
+
+			auto ci = hex::call_info( return_type() );
+			ci->cc = cc;
+			ci->flags = flags;
+			ci->args.resize( arity );
+			size_t i = 0;
+			( ( ci->args[ i++ ].type = type_of<Args>() ), ... );
+			return *cache.emplace_back( entry{ cc, flags, std::move( ci ) } ).ci;
+		}
+
+		template<typename... Tx> requires ( sizeof...( Tx ) == arity )
+		static std::unique_ptr<mcallinfo_t> call_info_ex( cm_t cc, int flags, Tx&&... args )
+		{
+			auto ci = std::make_unique<mcallinfo_t>( prototype( cc, flags ) );
+			[[maybe_unused]] auto assign = [ & ] ( size_t i, operand op ) { ci->args[ i ].mop_t::swap( op ); };
+			size_t i = 0;
+			( assign( i++, std::forward<Tx>( args ) ), ... );
+			return ci;
+		}
+		template<typename... Tx> requires ( sizeof...( Tx ) == arity )
+		static std::unique_ptr<mcallinfo_t> call_info( Tx&&... args ) { return call_info_ex( CM_CC_FASTCALL, default_flags, std::forward<Tx>( args )... ); }
+		template<typename... Tx> requires ( sizeof...( Tx ) == arity )
+		static std::unique_ptr<mcallinfo_t> call_info( pure_t, Tx&&... args ) { return call_info_ex( CM_CC_FASTCALL, default_flags | FCI_PURE, std::forward<Tx>( args )... ); }
+	};
+
 	// Creates an instruction.
 	//
 	inline std::unique_ptr<minsn_t> minsn( ea_t ea, mcode_t opcode, operand l, operand r, operand d ) 
@@ -119,15 +216,16 @@ namespace hex
 		return result;
 	}
 
-	// Map every opcode.
+	// Map every opcode, the operand slots of each constructor are checked against the opcode traits.
 	//
-#define __decl_n(op)   inline std::unique_ptr<minsn_t> make_##op( ea_t ea ) { return minsn( ea, m_##op, {}, {}, {} ); }
-#define __decl_l(op)   inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l ) { return minsn( ea, m_##op, std::move( l ), {}, {} ); }
-#define __decl_d(op)   inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand d ) { return minsn( ea, m_##op, {}, {}, std::move( d ) ); }
-#define __decl_ld(op)  inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l, operand d ) { return minsn( ea, m_##op, std::move( l ), {}, std::move( d ) ); }
-#define __decl_rd(op)  inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand r, operand d ) { return minsn( ea, m_##op, {}, std::move( r ), std::move( d ) ); }
-#define __decl_lr(op)  inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l, operand r ) { return minsn( ea, m_##op, std::move( l ), std::move( r ), {} ); }
-#define __decl_lrd(op) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l, operand r, operand d ) { return minsn( ea, m_##op, std::move( l ), std::move( r ), std::move( d ) ); }
+#define __check_slots(op, f) static_assert( ( traits_of( m_##op ).flags & ( op_l | op_r | op_d ) ) == ( f ), "Operand slots of m_" #op " do not match its traits." );
+#define __decl_n(op)   __check_slots( op, 0 ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea ) { return minsn( ea, m_##op, {}, {}, {} ); }
+#define __decl_l(op)   __check_slots( op, op_l ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l ) { return minsn( ea, m_##op, std::move( l ), {}, {} ); }
+#define __decl_d(op)   __check_slots( op, op_d ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand d ) { return minsn( ea, m_##op, {}, {}, std::move( d ) ); }
+#define __decl_ld(op)  __check_slots( op, op_l | op_d ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l, operand d ) { return minsn( ea, m_##op, std::move( l ), {}, std::move( d ) ); }
+#define __decl_rd(op)  __check_slots( op, op_r | op_d ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand r, operand d ) { return minsn( ea, m_##op, {}, std::move( r ), std::move( d ) ); }
+#define __decl_lr(op)  __check_slots( op, op_l | op_r ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l, operand r ) { return minsn( ea, m_##op, std::move( l ), std::move( r ), {} ); }
+#define __decl_lrd(op) __check_slots( op, op_l | op_r | op_d ) inline std::unique_ptr<minsn_t> make_##op( ea_t ea, operand l, operand r, operand d ) { return minsn( ea, m_##op, std::move( l ), std::move( r ), std::move( d ) ); }
 	__decl_n( nop );     // nop                       // no operation
 	__decl_lrd( stx );   // stx  l,    {r=sel, d=off} // store register to memory     *F
 	__decl_lrd( ldx );   // ldx  {l=sel,r=off}, d     // load register from memory    *F
@@ -201,6 +299,7 @@ namespace hex
 	__decl_lrd( fsub );  // fsub   l, r, d       l - r  => d; subtract                +F
 	__decl_lrd( fmul );  // fmul   l, r, d       l * r  => d; multiply                +F
 	__decl_lrd( fdiv );  // fdiv   l, r, d       l / r  => d; divide                  +F
+#undef __check_slots
 #undef __decl_n   
 #undef __decl_l   
 #undef __decl_d   
@@ -208,4 +307,103 @@ namespace hex
 #undef __decl_rd  
 #undef __decl_lr  
 #undef __decl_lrd
+
+	// Generic constructor taking the operands used by the opcode in slot order.
+	//
+	template<mcode_t Op, typename... Tx>
+	inline std::unique_ptr<minsn_t> make( ea_t ea, Tx&&... operands )
+	{
+		constexpr opcode_traits traits = traits_of( Op );
+		static_assert( sizeof...( Tx ) == traits.operand_count(), "Operand count does not match the slots used by the opcode." );
+
+		auto result = std::make_unique<minsn_t>( ea );
+		result->opcode = Op;
+		std::array<mop_t*, 3> slots = {};
+		size_t n = 0;
+		if constexpr ( traits.has( op_l ) ) slots[ n++ ] = &result->l;
+		if constexpr ( traits.has( op_r ) ) slots[ n++ ] = &result->r;
+		if constexpr ( traits.has( op_d ) ) slots[ n++ ] = &result->d;
+
+		auto assign = [ & ] ( size_t i, operand op ) { slots[ i ]->swap( op ); };
+		size_t i = 0;
+		( assign( i++, std::forward<Tx>( operands ) ), ... );
+		return result;
+	}
+
+	// Instruction sequence builder:
+	//  Constructs a run of instructions linked to each other in place and splices the whole run into a block at once,
+	//  marking the block lists dirty a single time. Instructions not yet spliced are owned by the sequence.
+	//
+	struct insn_sequence
+	{
+		ea_t ea;
+		minsn_t* head = nullptr;
+		minsn_t* tail = nullptr;
+		size_t count = 0;
+
+		insn_sequence( ea_t ea ) : ea( ea ) {}
+		insn_sequence( insn_sequence&& o ) noexcept : ea( o.ea ), head( std::exchange( o.head, nullptr ) ), tail( std::exchange( o.tail, nullptr ) ), count( std::exchange( o.count, 0 ) ) {}
+		insn_sequence( const insn_sequence& ) = delete;
+		insn_sequence& operator=( const insn_sequence& ) = delete;
+		~insn_sequence() { clear(); }
+
+		// Appends an existing instruction or creates a new one in place.
+		//
+		minsn_t* append( minsn_t* ins )
+		{
+			ins->prev = tail;
+			ins->next = nullptr;
+			( tail ? tail->next : head ) = ins;
+			tail = ins;
+			count++;
+			return ins;
+		}
+		minsn_t* append( std::unique_ptr<minsn_t> ins ) { return append( ins.release() ); }
+		minsn_t* emit( mcode_t opcode )
+		{
+			minsn_t* ins = new minsn_t( ea );
+			ins->opcode = opcode;
+			return append( ins );
+		}
+		minsn_t* emit( mcode_t opcode, operand l, operand r, operand d )
+		{
+			minsn_t* ins = emit( opcode );
+			ins->l.swap( l );
+			ins->r.swap( r );
+			ins->d.swap( d );
+			return ins;
+		}
+
+		// Splices the sequence into the block after the given instruction or at the beginning if null, returns the
+		// last instruction inserted. The chain is already linked so only its ends are relinked into the block.
+		//
+		minsn_t* insert_into( mblock_t* blk, minsn_t* after )
+		{
+			if ( !head )
+				return after;
+			minsn_t* first = std::exchange( head, nullptr );
+			minsn_t* last = std::exchange( tail, nullptr );
+			minsn_t* next = after ? after->next : blk->head;
+			first->prev = after;
+			last->next = next;
+			( after ? after->next : blk->head ) = first;
+			( next ? next->prev : blk->tail ) = last;
+			count = 0;
+			blk->mark_lists_dirty();
+			return last;
+		}
+		minsn_t* append_to( mblock_t* blk ) { return insert_into( blk, blk->tail ); }
+
+		// Deletes the instructions not yet spliced.
+		//
+		void clear()
+		{
+			while ( head )
+				delete std::exchange( head, head->next );
+			tail = nullptr;
+			count = 0;
+		}
+		bool empty() const { return !head; }
+		size_t size() const { return count; }
+	};
 };
\ No newline at end of file
@@ -0,0 +1,327 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stop_token>
+#include <utility>
+#include <condition_variable>
+#include "ida.hpp"
+
+// Coroutine based access to the main thread from worker threads.
+//
+namespace hex
+{
+	namespace detail
+	{
+		// Intrusive node of the main thread queue, lives in the frame of the suspended coroutine.
+		//
+		struct main_thread_node
+		{
+			main_thread_node* next = nullptr;
+			std::coroutine_handle<> handle = {};
+			std::stop_token token = {};
+			bool cancelled = false;
+		};
+
+		// Lock-free multi-producer queue drained by the main thread. Producers push onto an atomic stack and the first
+		// push into an empty queue schedules a single execute_sync request which resumes everything queued up to that
+		// point in FIFO order, so that any number of concurrent requests cost one switch to the main thread.
+		//
+		struct main_thread_queue
+		{
+			std::atomic<main_thread_node*> head = nullptr;
+			std::atomic<size_t> pending = 0;
+			std::atomic<uint32_t> wakeups = 0;    // Bumped when slots are freed or a blocked request is cancelled.
+			std::atomic<bool> scheduled = false;
+			std::atomic<size_t> capacity = 4096;
+
+			// Statistics, only modified on the main thread.
+			//
+			size_t batches = 0;
+			size_t resumed = 0;
+
+			// Requests with MFF_NOWAIT must be allocated with new, the kernel deletes them once executed.
+			//
+			struct request : exec_request_t
+			{
+				int idaapi execute() override { instance().drain(); return 0; }
+			};
+
+			static main_thread_queue& instance() { static main_thread_queue queue = {}; return queue; }
+
+			// Reserves a slot, blocking while the queue is full unless wait is false or the request is cancelled. A blocked
+			// request registers a stop callback so that cancelling the token wakes it up.
+			//
+			struct waker
+			{
+				main_thread_queue* queue;
+				void operator()() const { queue->wake(); }
+			};
+			void wake()
+			{
+				wakeups.fetch_add( 1, std::memory_order::release );
+				wakeups.notify_all();
+			}
+			bool reserve( const std::stop_token& token, bool wait )
+			{
+				std::optional<std::stop_callback<waker>> on_stop;
+				while ( true )
+				{
+					uint32_t epoch = wakeups.load( std::memory_order::acquire );
+					size_t n = pending.load( std::memory_order::relaxed );
+					if ( n < capacity.load( std::memory_order::relaxed ) )
+					{
+						if ( pending.compare_exchange_weak( n, n + 1, std::memory_order::relaxed ) )
+							return true;
+						continue;
+					}
+					if ( !wait || token.stop_requested() )
+						return false;
+
+					// Register before blocking and check again, a stop requested in between bumps the epoch.
+					//
+					if ( !on_stop )
+					{
+						on_stop.emplace( token, waker{ this } );
+						continue;
+					}
+					wakeups.wait( epoch, std::memory_order::acquire );
+				}
+			}
+
+			void push( main_thread_node* node )
+			{
+				node->next = head.load( std::memory_order::relaxed );
+				while ( !head.compare_exchange_weak( node->next, node, std::memory_order::release, std::memory_order::relaxed ) );
+				if ( !scheduled.exchange( true, std::memory_order::acq_rel ) )
+					execute_sync( *new request{}, MFF_WRITE | MFF_NOWAIT );
+			}
+
+			// Resumes every queued coroutine, may also be called from a timer or any other main thread callback.
+			//
+			void drain()
+			{
+				// Clear the flag before taking the list so that any push we miss schedules another request.
+				//
+				scheduled.store( false, std::memory_order::release );
+				main_thread_node* list = head.exchange( nullptr, std::memory_order::acquire );
+
+				main_thread_node* fifo = nullptr;
+				size_t n = 0;
+				while ( list )
+				{
+					main_thread_node* next = list->next;
+					list->next = fifo;
+					fifo = list;
+					list = next;
+					n++;
+				}
+				if ( !n )
+					return;
+
+				batches++;
+				resumed += n;
+				pending.fetch_sub( n, std::memory_order::relaxed );
+				wake();
+
+				// The node is destroyed with the frame once resumed.
+				//
+				while ( fifo )
+				{
+					main_thread_node* next = fifo->next;
+					fifo->cancelled = fifo->token.stop_requested();
+					fifo->handle.resume();
+					fifo = next;
+				}
+			}
+		};
+	};
+
+	// Awaitable switching the coroutine to the main thread, completes immediately if already on it. Resumes to false
+	// if the token was cancelled before the switch, in which case the coroutine may still be running on the main thread
+	// and should return without touching the database. If wait is false a full queue cancels instead of blocking.
+	//
+	struct main_thread
+	{
+		detail::main_thread_node node = {};
+		bool wait = true;
+
+		main_thread() = default;
+		main_thread( std::stop_token token, bool wait = true ) : node{ nullptr, {}, std::move( token ), false }, wait( wait ) {}
+
+		bool await_ready()
+		{
+			node.cancelled = node.token.stop_requested();
+			return node.cancelled || is_main_thread();
+		}
+		bool await_suspend( std::coroutine_handle<> handle )
+		{
+			auto& queue = detail::main_thread_queue::instance();
+			if ( !queue.reserve( node.token, wait ) )
+			{
+				node.cancelled = true;
+				return false;
+			}
+			node.handle = handle;
+			queue.push( &node );
+			return true;
+		}
+		bool await_resume() const { return !node.cancelled; }
+
+		// Queue configuration and statistics.
+		//
+		static void set_capacity( size_t n )
+		{
+			auto& queue = detail::main_thread_queue::instance();
+			queue.capacity.store( n, std::memory_order::relaxed );
+			queue.wake();
+		}
+		static size_t pending() { return detail::main_thread_queue::instance().pending.load( std::memory_order::relaxed ); }
+		static void drain() { detail::main_thread_queue::instance().drain(); }
+	};
+
+	namespace detail
+	{
+		// Event signalled by a finished task, the lock guarantees the waiter cannot destroy it before set() returns.
+		//
+		struct task_event
+		{
+			std::mutex mutex;
+			std::condition_variable cv;
+			bool done = false;
+
+			void set()
+			{
+				std::lock_guard lock{ mutex };
+				done = true;
+				cv.notify_one();
+			}
+			void wait()
+			{
+				std::unique_lock lock{ mutex };
+				cv.wait( lock, [ & ] { return done; } );
+			}
+			template<typename D>
+			bool wait_for( D duration )
+			{
+				std::unique_lock lock{ mutex };
+				return cv.wait_for( lock, duration, [ & ] { return done; } );
+			}
+		};
+
+		struct task_promise_base
+		{
+			std::coroutine_handle<> continuation = {};
+			task_event* event = nullptr;
+			std::exception_ptr exception = {};
+
+			struct final_awaiter
+			{
+				bool await_ready() noexcept { return false; }
+				template<typename P>
+				std::coroutine_handle<> await_suspend( std::coroutine_handle<P> handle ) noexcept
+				{
+					task_promise_base& promise = handle.promise();
+					if ( promise.continuation )
+						return promise.continuation;
+
+					// The frame may be destroyed as soon as the event is set.
+					//
+					if ( task_event* event = promise.event )
+						event->set();
+					return std::noop_coroutine();
+				}
+				void await_resume() noexcept {}
+			};
+
+			std::suspend_always initial_suspend() noexcept { return {}; }
+			final_awaiter final_suspend() noexcept { return {}; }
+			void unhandled_exception() { exception = std::current_exception(); }
+			void rethrow() { if ( exception ) std::rethrow_exception( exception ); }
+		};
+
+		template<typename T>
+		struct task_promise : task_promise_base
+		{
+			std::optional<T> value = {};
+			template<typename V>
+			void return_value( V&& v ) { value.emplace( std::forward<V>( v ) ); }
+			T result() { rethrow(); return std::move( *value ); }
+		};
+		template<>
+		struct task_promise<void> : task_promise_base
+		{
+			void return_void() {}
+			void result() { rethrow(); }
+		};
+	};
+
+	// Task:
+	//  Lazily started coroutine, runs when awaited by another coroutine or when get() is called, which blocks the
+	//  calling thread until it completes:
+	//
+	//   hex::task<qstring> name_of( ea_t ea ) { co_await hex::main_thread{}; qstring n; get_name( &n, ea ); co_return n; }
+	//   ... on any number of workers: qstring n = name_of( ea ).get();
+	//
+	//  Called on the main thread, get() drains the main thread queue while it waits since nothing else would resume the
+	//  coroutines queued there. Anything else the task waits for that needs the main thread, such as its own
+	//  execute_sync requests, deadlocks.
+	//
+	template<typename T = void>
+	struct task
+	{
+		struct promise_type : detail::task_promise<T>
+		{
+			task get_return_object() { return task{ std::coroutine_handle<promise_type>::from_promise( *this ) }; }
+		};
+		std::coroutine_handle<promise_type> handle = {};
+
+		task() = default;
+		explicit task( std::coroutine_handle<promise_type> handle ) : handle( handle ) {}
+		task( task&& o ) noexcept : handle( std::exchange( o.handle, {} ) ) {}
+		task& operator=( task&& o ) noexcept
+		{
+			if ( this != &o )
+			{
+				if ( handle )
+					handle.destroy();
+				handle = std::exchange( o.handle, {} );
+			}
+			return *this;
+		}
+		~task() { if ( handle ) handle.destroy(); }
+
+		bool done() const { return !handle || handle.done(); }
+
+		bool await_ready() const noexcept { return done(); }
+		std::coroutine_handle<> await_suspend( std::coroutine_handle<> continuation ) noexcept
+		{
+			handle.promise().continuation = continuation;
+			return handle;
+		}
+		T await_resume() { return handle.promise().result(); }
+
+		T get()
+		{
+			if ( !handle.done() )
+			{
+				detail::task_event event = {};
+				handle.promise().event = &event;
+				handle.resume();
+				if ( is_main_thread() )
+				{
+					while ( !event.wait_for( std::chrono::milliseconds( 1 ) ) )
+						main_thread::drain();
+				}
+				else
+				{
+					event.wait();
+				}
+			}
+			return handle.promise().result();
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+namespace hex
+{
+	// Fixed size bitset usable in constant expressions, std::bitset only becomes constexpr in C++23.
+	//
+	template<size_t N>
+	struct static_bitset
+	{
+		static constexpr size_t word_count = ( N + 63 ) / 64;
+		std::array<uint64_t, word_count> words = {};
+
+		// Construction from a list of bit indices, enumerators are accepted as is.
+		//
+		constexpr static_bitset() = default;
+		template<typename... Tx>
+		constexpr static_bitset( std::in_place_t, Tx... bits ) { ( set( ( size_t ) bits ), ... ); }
+
+		// Bit access.
+		//
+		constexpr size_t size() const { return N; }
+		constexpr bool test( size_t n ) const { return n < N && ( ( words[ n >> 6 ] >> ( n & 63 ) ) & 1 ); }
+		constexpr bool operator[]( size_t n ) const { return test( n ); }
+		constexpr static_bitset& set( size_t n, bool value = true )
+		{
+			assert( n < N );
+			uint64_t mask = 1ull << ( n & 63 );
+			words[ n >> 6 ] = value ? ( words[ n >> 6 ] | mask ) : ( words[ n >> 6 ] & ~mask );
+			return *this;
+		}
+		constexpr static_bitset& reset( size_t n ) { return set( n, false ); }
+
+		// Queries.
+		//
+		constexpr size_t count() const
+		{
+			size_t n = 0;
+			for ( uint64_t w : words )
+				n += std::popcount( w );
+			return n;
+		}
+		constexpr bool any() const
+		{
+			for ( uint64_t w : words )
+				if ( w ) return true;
+			return false;
+		}
+		constexpr bool none() const { return !any(); }
+
+		// Enumerates every set bit in ascending order.
+		//
+		template<typename F>
+		constexpr void for_each( F&& functor ) const
+		{
+			for ( size_t i = 0; i != word_count; i++ )
+				for ( uint64_t w = words[ i ]; w; w &= w - 1 )
+					functor( ( i << 6 ) + std::countr_zero( w ) );
+		}
+
+		// Set operations.
+		//
+		constexpr static_bitset& operator|=( const static_bitset& o ) { for ( size_t i = 0; i != word_count; i++ ) words[ i ] |= o.words[ i ]; return *this; }
+		constexpr static_bitset& operator&=( const static_bitset& o ) { for ( size_t i = 0; i != word_count; i++ ) words[ i ] &= o.words[ i ]; return *this; }
+		constexpr static_bitset operator|( const static_bitset& o ) const { auto r = *this; return r |= o; }
+		constexpr static_bitset operator&( const static_bitset& o ) const { auto r = *this; return r &= o; }
+		constexpr bool operator==( const static_bitset& o ) const = default;
+	};
+};
\ No newline at end of file
@@ -1,6 +1,12 @@
 #pragma once
 #include <span>
+#include <array>
+#include <vector>
+#include <memory>
 #include "ida.hpp"
+#include "bitset.hpp"
+#include "profiling.hpp"
+#include "trace_source.hpp"
 
 // Lambda wrappers around common optimizer types.
 //
@@ -13,6 +19,10 @@ namespace hex
 		virtual void set_state( bool enable ) = 0;
 		void install() { set_state( true ); }
 		void uninstall() { set_state( false ); }
+
+		// Statistics of the component if it keeps any.
+		//
+		virtual component_stats* statistics() { return nullptr; }
 	};
 
 	// Component list type.
@@ -41,15 +51,148 @@ namespace hex
 		struct storage : optinsn_t
 		{
 			F functor;
+			component_stats stats;
+			trace_source trace;
 			storage( F&& functor ) : functor( std::forward<F>( functor ) ) {}
-			inline int func( mblock_t* block, minsn_t* ins, int optflags ) override { return functor( block, ins, optflags ); }
+			inline int func( mblock_t* block, minsn_t* ins, int optflags ) override
+			{
+				return trace_insn( trace, ins, [ & ] { return profile( stats, [ & ] { return functor( block, ins, optflags ); } ); } );
+			}
 		} storage;
 		insn_optimizer( F&& functor ) : storage( std::forward<F>( functor ) ) {}
+		insn_optimizer& named( const char* name ) { storage.stats.set_name( name ); storage.trace.set_name( name ); return *this; }
+		component_stats* statistics() override { return &storage.stats; }
 		operator optinsn_t&() { return storage; }
 		void set_state( bool enable ) override { enable ? ( void ) install_optinsn_handler( &storage ) : ( void ) remove_optinsn_handler( &storage ); }
 	};
 	template<typename F> insn_optimizer( F&& )->insn_optimizer<F>;
 
+	// Opcode-filtered instruction optimizer:
+	//  Rather than registering an optinsn_t per optimizer, every opcode optimizer is registered into a single
+	//  consolidated handler which only invokes the functors listening for the opcode of the current instruction.
+	//  Like optinsn_t itself, only top-level instructions are dispatched, an optimizer interested in instructions
+	//  nested as operands (mop_d) has to visit them itself, e.g. with hex::minsn_visitor.
+	//
+	using opcode_set = static_bitset<256>;
+	template<mcode_t... Ops>
+	constexpr opcode_set opcodes = opcode_set{ std::in_place, Ops... };
+
+	namespace detail
+	{
+		struct insn_dispatcher : optinsn_t
+		{
+			using handler_t = int( * )( void* ctx, mblock_t* block, minsn_t* ins, int optflags );
+			struct entry
+			{
+				handler_t handler;
+				void* ctx;
+			};
+			std::array<std::vector<entry>, 256> table = {};
+			std::vector<std::pair<opcode_set, entry>> pending = {};
+			size_t count = 0;
+			int depth = 0;
+			bool tombstones = false;
+
+			static insn_dispatcher& instance() { static insn_dispatcher dispatcher = {}; return dispatcher; }
+
+			// Handlers added during dispatch are deferred until the outermost dispatch returns, removed ones are
+			// tombstoned immediately so that the running dispatch no longer invokes them.
+			//
+			void add( const opcode_set& ops, entry e )
+			{
+				if ( depth )
+					pending.emplace_back( ops, e );
+				else
+					ops.for_each( [ & ] ( size_t op ) { table[ op ].push_back( e ); } );
+				if ( !count++ )
+					install_optinsn_handler( this );
+			}
+			void remove( const opcode_set& ops, void* ctx )
+			{
+				if ( depth )
+				{
+					ops.for_each( [ & ] ( size_t op )
+					{
+						for ( entry& e : table[ op ] )
+							if ( e.ctx == ctx )
+								e.handler = nullptr;
+					} );
+					std::erase_if( pending, [ & ] ( const auto& p ) { return p.second.ctx == ctx; } );
+					tombstones = true;
+				}
+				else
+				{
+					ops.for_each( [ & ] ( size_t op ) { std::erase_if( table[ op ], [ & ] ( const entry& e ) { return e.ctx == ctx; } ); } );
+				}
+				if ( !--count )
+					remove_optinsn_handler( this );
+			}
+			void settle()
+			{
+				if ( std::exchange( tombstones, false ) )
+					for ( auto& list : table )
+						std::erase_if( list, [ ] ( const entry& e ) { return !e.handler; } );
+				for ( auto& [ops, e] : std::exchange( pending, {} ) )
+					ops.for_each( [ & ] ( size_t op ) { table[ op ].push_back( e ); } );
+			}
+
+			// Stops at the first handler reporting a change, the instruction may no longer carry the same opcode
+			// and Hex-Rays will invoke us again until a fixpoint is reached.
+			//
+			inline int func( mblock_t* block, minsn_t* ins, int optflags ) override
+			{
+				depth++;
+				int result = 0;
+				for ( const entry& e : table[ ( uint8_t ) ins->opcode ] )
+					if ( e.handler && ( result = e.handler( e.ctx, block, ins, optflags ) ) )
+						break;
+				if ( !--depth && ( tombstones || !pending.empty() ) )
+					settle();
+				return result;
+			}
+		};
+	};
+	template<typename F>
+	struct opcode_optimizer : component
+	{
+		F functor;
+		opcode_set ops;
+		component_stats stats;
+		trace_source trace;
+		bool installed = false;
+		opcode_optimizer( opcode_set ops, F&& functor ) : functor( std::forward<F>( functor ) ), ops( ops ) {}
+		opcode_optimizer& named( const char* name ) { stats.set_name( name ); trace.set_name( name ); return *this; }
+		component_stats* statistics() override { return &stats; }
+		static int invoke( void* ctx, mblock_t* block, minsn_t* ins, int optflags )
+		{
+			auto* self = ( opcode_optimizer* ) ctx;
+			return trace_insn( self->trace, ins, [ & ] { return profile( self->stats, [ & ] { return self->functor( block, ins, optflags ); } ); } );
+		}
+		void set_state( bool enable ) override
+		{
+			if ( std::exchange( installed, enable ) == enable )
+				return;
+			auto& dispatcher = detail::insn_dispatcher::instance();
+			enable ? dispatcher.add( ops, { &invoke, this } ) : dispatcher.remove( ops, this );
+		}
+	};
+	template<typename F> opcode_optimizer( opcode_set, F&& )->opcode_optimizer<F>;
+
+	namespace detail
+	{
+		template<mcode_t... Ops>
+		struct opcode_filter_gen
+		{
+			template<typename F>
+			inline constexpr auto operator()( F&& func ) const
+			{
+				return hex::opcode_optimizer( opcodes<Ops...>, std::forward<F>( func ) );
+			}
+		};
+	};
+	template<mcode_t... Ops>
+	constexpr detail::opcode_filter_gen<Ops...> insn_optimizer_for = {};
+
 	// Block optimizer:
 	//
 	template<typename F>
@@ -58,16 +201,26 @@ namespace hex
 		struct storage : optblock_t
 		{
 			F functor;
+			component_stats stats;
+			trace_source trace;
 			storage( F&& functor ) : functor( std::forward<F>( functor ) ) {}
-			inline int func( mblock_t* block ) override { return functor( block ); }
+			inline int func( mblock_t* block ) override { return trace_block( trace, block, [ & ] { return profile( stats, [ & ] { return functor( block ); } ); } ); }
 		} storage;
 		block_optimizer( F&& functor ) : storage( std::forward<F>( functor ) ) {}
+		block_optimizer& named( const char* name ) { storage.stats.set_name( name ); storage.trace.set_name( name ); return *this; }
+		component_stats* statistics() override { return &storage.stats; }
 		operator optblock_t&() { return storage; }
 		void set_state( bool enable ) override { enable ? ( void ) install_optblock_handler( &storage ) : ( void ) remove_optblock_handler( &storage ); }
 	};
 	template<typename F> block_optimizer( F&& )->block_optimizer<F>;
 
-	// Microcode filter:
+	// Instruction type sets used to narrow the instructions a microcode filter matches.
+	//
+	using itype_set = static_bitset<4096>;
+	template<uint16_t... Ix>
+	constexpr itype_set itypes = itype_set{ std::in_place, Ix... };
+
+	// Microcode filter, optionally restricted to a set of instruction types:
 	//
 	template<typename F>
 	struct microcode_filter : component
@@ -75,16 +228,91 @@ namespace hex
 		struct storage : microcode_filter_t
 		{
 			F functor;
-			storage( F&& functor ) : functor( std::forward<F>( functor ) ) {}
+			itype_set filter;
+			bool filtered;
+			component_stats stats;
+			storage( F&& functor ) : functor( std::forward<F>( functor ) ), filter(), filtered( false ) {}
+			storage( F&& functor, const itype_set& filter ) : functor( std::forward<F>( functor ) ), filter( filter ), filtered( true ) {}
 			
-			bool match( codegen_t& cdg ) override { return true; }
-			merror_t apply( codegen_t& cdg ) override { return functor( cdg ) ? MERR_OK : MERR_INSN; }
+			bool match( codegen_t& cdg ) override { return !filtered || filter.test( cdg.insn.itype ); }
+			merror_t apply( codegen_t& cdg ) override { return profile( stats, [ & ] { return ( bool ) functor( cdg ); } ) ? MERR_OK : MERR_INSN; }
 		} storage;
 		microcode_filter( F&& functor ) : storage( std::forward<F>( functor ) ) {}
+		microcode_filter( const itype_set& filter, F&& functor ) : storage( std::forward<F>( functor ), filter ) {}
+		microcode_filter& named( const char* name ) { storage.stats.set_name( name ); return *this; }
+		component_stats* statistics() override { return &storage.stats; }
 		operator microcode_filter_t&() { return storage; }
 		void set_state( bool enable ) override { install_microcode_filter( &storage, enable ); }
 	};
 	template<typename F> microcode_filter( F&& )->microcode_filter<F>;
+	template<typename F> microcode_filter( const itype_set&, F&& )->microcode_filter<F>;
+
+	namespace detail
+	{
+		template<uint16_t... Ix>
+		struct itype_filter_gen
+		{
+			template<typename F>
+			inline constexpr auto operator()( F&& func ) const
+			{
+				return hex::microcode_filter( itypes<Ix...>, std::forward<F>( func ) );
+			}
+		};
+	};
+	template<uint16_t... Ix>
+	constexpr detail::itype_filter_gen<Ix...> microcode_filter_for = {};
+
+	// Composite microcode filter:
+	//  Merges any number of filters into a single registered microcode_filter_t, dispatching through an itype indexed
+	//  table so that instructions no filter is interested in are rejected by a single bounds check.
+	//
+	struct composite_filter : component
+	{
+		struct handler
+		{
+			bool( *apply )( void* ctx, codegen_t& cdg );
+			void* ctx;
+		};
+		struct storage : microcode_filter_t
+		{
+			std::vector<std::vector<handler>> table;
+			component_stats stats;
+
+			bool match( codegen_t& cdg ) override { return cdg.insn.itype < table.size() && !table[ cdg.insn.itype ].empty(); }
+			merror_t apply( codegen_t& cdg ) override
+			{
+				return profile( stats, [ & ]
+				{
+					for ( const handler& h : table[ cdg.insn.itype ] )
+						if ( h.apply( h.ctx, cdg ) )
+							return true;
+					return false;
+				} ) ? MERR_OK : MERR_INSN;
+			}
+		} storage;
+		composite_filter& named( const char* name ) { storage.stats.set_name( name ); return *this; }
+		component_stats* statistics() override { return &storage.stats; }
+		std::vector<std::shared_ptr<void>> functors;
+
+		// Adds a filter for the given set of instruction types, handlers are tried in the order they were added.
+		//
+		template<typename F>
+		composite_filter& add( const itype_set& filter, F&& functor )
+		{
+			using T = std::decay_t<F>;
+			auto& fn = functors.emplace_back( std::make_shared<T>( std::forward<F>( functor ) ) );
+			handler h = { [ ] ( void* ctx, codegen_t& cdg ) -> bool { return ( *( T* ) ctx )( cdg ); }, fn.get() };
+			filter.for_each( [ & ] ( size_t itype )
+			{
+				if ( storage.table.size() <= itype )
+					storage.table.resize( itype + 1 );
+				storage.table[ itype ].push_back( h );
+			} );
+			return *this;
+		}
+		operator microcode_filter_t&() { return storage; }
+		void set_state( bool enable ) override { install_microcode_filter( &storage, enable ); }
+	};
 
 	// Hexrays callback.
 	//
@@ -92,12 +320,44 @@ namespace hex
 	struct hexrays_callback : component
 	{
 		F functor;
+		component_stats stats;
 		hexrays_callback( F&& functor ) : functor( std::forward<F>( functor ) ) {}
-		static ssize_t callback( void* ud, hexrays_event_t evt, va_list va )  { return ( *( ( decltype( &functor ) ) ud ) )( evt, va ); }
-		void set_state( bool enable ) override { enable ? ( void ) install_hexrays_callback( &callback, &functor ) : ( void ) remove_hexrays_callback( &callback, &functor ); }
+		hexrays_callback& named( const char* name ) { stats.set_name( name ); return *this; }
+		component_stats* statistics() override { return &stats; }
+		static ssize_t callback( void* ud, hexrays_event_t evt, va_list va ) 
+		{
+			auto* self = ( hexrays_callback* ) ud;
+			return profile( self->stats, [ & ] { return ( ssize_t ) self->functor( evt, va ); } );
+		}
+		void set_state( bool enable ) override { enable ? ( void ) install_hexrays_callback( &callback, this ) : ( void ) remove_hexrays_callback( &callback, this ); }
 	};
 	template<typename F> hexrays_callback( F&& )->hexrays_callback<F>;
 
+	// IDB event callback.
+	//
+	template<typename F>
+	struct idb_callback : component
+	{
+		F functor;
+		component_stats stats;
+		bool installed = false;
+		idb_callback( F&& functor ) : functor( std::forward<F>( functor ) ) {}
+		idb_callback& named( const char* name ) { stats.set_name( name ); return *this; }
+		component_stats* statistics() override { return &stats; }
+		static ssize_t callback( void* ud, int code, va_list va )
+		{
+			auto* self = ( idb_callback* ) ud;
+			return profile( self->stats, [ & ] { return ( ssize_t ) self->functor( ( idb_event::event_code_t ) code, va ); } );
+		}
+		void set_state( bool enable ) override
+		{
+			if ( std::exchange( installed, enable ) == enable )
+				return;
+			enable ? ( void ) hook_to_notification_point( HT_IDB, &callback, this ) : ( void ) unhook_from_notification_point( HT_IDB, &callback, this );
+		}
+	};
+	template<typename F> idb_callback( F&& )->idb_callback<F>;
+
 	namespace detail
 	{
 		inline auto fill_from( va_list a, std::type_identity<std::tuple<>> ) 
@@ -140,4 +400,29 @@ namespace hex
 	};
 	template<hexrays_event_t Evt>
 	constexpr detail::event_filter_gen<Evt> hexrays_callback_for = {};
+
+	namespace detail
+	{
+		template<idb_event::event_code_t Evt>
+		struct idb_filter_gen
+		{
+			template<typename F>
+			inline constexpr auto operator()( F&& func ) const
+			{
+				using args = typename clambda_args<decltype( &F::operator() )>::type;
+
+				return hex::idb_callback( [f = std::forward<F>(func)](idb_event::event_code_t e, va_list a)->ssize_t
+				{
+					if ( e != Evt )
+						return 0;
+					else if constexpr ( std::is_void_v<decltype( std::apply( f, fill_from( a, std::type_identity<args>{} ) ) )> )
+						return std::apply( f, fill_from( a, std::type_identity<args>{} ) ), 0;
+					else
+						return std::apply( f, fill_from( a, std::type_identity<args>{} ) );
+				} );
+			}
+		};
+	};
+	template<idb_event::event_code_t Evt>
+	constexpr detail::idb_filter_gen<Evt> idb_callback_for = {};
 };
@@ -0,0 +1,510 @@
+#pragma once
+#include <vector>
+#include <span>
+#include <bit>
+#include <algorithm>
+#include <concepts>
+#include <unordered_map>
+#include "ida.hpp"
+#include "ranges.hpp"
+
+// Worklist dataflow framework over microcode blocks.
+//
+namespace hex
+{
+	// Dynamically sized dense bitset used as the lattice of the bundled analyses.
+	//
+	struct dense_bitset
+	{
+		std::vector<uint64_t> words;
+
+		dense_bitset() = default;
+		explicit dense_bitset( size_t n ) : words( ( n + 63 ) / 64 ) {}
+
+		size_t size() const { return words.size() * 64; }
+		bool test( size_t n ) const { return ( n >> 6 ) < words.size() && ( ( words[ n >> 6 ] >> ( n & 63 ) ) & 1 ); }
+		void set( size_t n ) { words[ n >> 6 ] |= 1ull << ( n & 63 ); }
+		void reset( size_t n ) { words[ n >> 6 ] &= ~( 1ull << ( n & 63 ) ); }
+		void set_range( size_t first, size_t count ) { for ( size_t i = first; i != first + count; i++ ) set( i ); }
+		void clear() { std::fill( words.begin(), words.end(), 0 ); }
+		bool any() const { return std::any_of( words.begin(), words.end(), [ ] ( uint64_t w ) { return w != 0; } ); }
+		size_t count() const
+		{
+			size_t n = 0;
+			for ( uint64_t w : words )
+				n += std::popcount( w );
+			return n;
+		}
+
+		// Set operations, unions report whether any bit was added.
+		//
+		bool merge( const dense_bitset& o )
+		{
+			uint64_t added = 0;
+			for ( size_t i = 0; i != words.size(); i++ )
+			{
+				added |= o.words[ i ] & ~words[ i ];
+				words[ i ] |= o.words[ i ];
+			}
+			return added != 0;
+		}
+		void intersect( const dense_bitset& o ) { for ( size_t i = 0; i != words.size(); i++ ) words[ i ] &= o.words[ i ]; }
+		void subtract( const dense_bitset& o ) { for ( size_t i = 0; i != words.size(); i++ ) words[ i ] &= ~o.words[ i ]; }
+		bool operator==( const dense_bitset& o ) const = default;
+
+		template<typename F>
+		void for_each( F&& functor ) const
+		{
+			for ( size_t i = 0; i != words.size(); i++ )
+				for ( uint64_t w = words[ i ]; w; w &= w - 1 )
+					functor( ( i << 6 ) + std::countr_zero( w ) );
+		}
+	};
+
+	// Block orders of an mba_t computed once and shared between analyses, the CFG must not change while it is used.
+	//
+	struct cfg_order
+	{
+		std::vector<int> rpo;         // Reverse post-order of the reachable blocks.
+		std::vector<int> position;    // Position of each block in the RPO, -1 if unreachable.
+
+		cfg_order() = default;
+		cfg_order( mba_t* mba ) : rpo( detail::post_order( mba ) ), position( mba->qty, -1 )
+		{
+			std::reverse( rpo.begin(), rpo.end() );
+			for ( size_t i = 0; i != rpo.size(); i++ )
+				position[ rpo[ i ] ] = ( int ) i;
+		}
+	};
+
+	// Generic worklist solver:
+	//  Transfer is invoked as transfer( block, input, output ) and computes the output state of a block from its input,
+	//  where input/output are in the direction of the analysis. Meet is invoked as meet( accumulator, state ). Blocks are
+	//  processed in reverse post-order (post-order for backward problems) and only blocks whose neighbour changed are
+	//  re-queued.
+	//
+	enum class direction { forward, backward };
+
+	template<direction Dir, typename Lattice, typename Transfer, typename Meet>
+	struct dataflow_solver
+	{
+		mba_t* mba;
+		const cfg_order& order;
+		Transfer transfer;
+		Meet meet;
+		std::vector<Lattice> in;      // State at block entry.
+		std::vector<Lattice> out;     // State at block exit.
+		size_t iterations = 0;
+
+		dataflow_solver( mba_t* mba, const cfg_order& order, Transfer transfer, Meet meet )
+			: mba( mba ), order( order ), transfer( std::move( transfer ) ), meet( std::move( meet ) ) {}
+
+		// Solves the problem given the state at the boundary (entry or exit blocks) and the initial state of every other
+		// block, which should be the identity of the meet. The boundary can also be given per block as boundary( block ).
+		//
+		void solve( const Lattice& boundary, const Lattice& initial ) { solve( [ & ] ( mblock_t* ) -> const Lattice& { return boundary; }, initial ); }
+
+		template<typename Boundary> requires std::invocable<Boundary&, mblock_t*>
+		void solve( Boundary&& boundary, const Lattice& initial )
+		{
+			size_t n = order.rpo.size();
+			in.assign( mba->qty, initial );
+			out.assign( mba->qty, initial );
+
+			// Worklist indexed by processing position.
+			//
+			auto block_at = [ & ] ( size_t i ) { return Dir == direction::forward ? order.rpo[ i ] : order.rpo[ n - 1 - i ]; };
+			auto position_of = [ & ] ( int id ) { return Dir == direction::forward ? ( size_t ) order.position[ id ] : n - 1 - order.position[ id ]; };
+			dense_bitset pending{ n };
+			for ( size_t i = 0; i != n; i++ )
+				pending.set( i );
+
+			size_t remaining = n;
+			size_t cursor = 0;
+			while ( remaining )
+			{
+				// Find the next pending block in order, wrapping around.
+				//
+				while ( !pending.test( cursor ) )
+					cursor = cursor + 1 == n ? 0 : cursor + 1;
+				pending.reset( cursor );
+				remaining--;
+				iterations++;
+
+				int id = block_at( cursor );
+				mblock_t* blk = mba->get_mblock( id );
+				auto& entry = Dir == direction::forward ? in[ id ] : out[ id ];
+				auto& exit = Dir == direction::forward ? out[ id ] : in[ id ];
+
+				// Meet over the incoming edges.
+				//
+				const intvec_t& sources = Dir == direction::forward ? blk->predset : blk->succset;
+				if ( sources.empty() )
+				{
+					entry = boundary( blk );
+				}
+				else
+				{
+					entry = initial;
+					for ( int src : sources )
+						if ( order.position[ src ] >= 0 )
+							meet( entry, Dir == direction::forward ? out[ src ] : in[ src ] );
+				}
+				if constexpr ( Dir == direction::forward )
+				{
+					if ( id == 0 )
+						meet( entry, boundary( blk ) );
+				}
+
+				// Apply the transfer function, queue the dependents on change.
+				//
+				Lattice result = initial;
+				transfer( blk, static_cast<const Lattice&>( entry ), result );
+				if ( result == exit )
+					continue;
+				exit = std::move( result );
+
+				const intvec_t& targets = Dir == direction::forward ? blk->succset : blk->predset;
+				for ( int dst : targets )
+				{
+					if ( order.position[ dst ] < 0 )
+						continue;
+					size_t p = position_of( dst );
+					if ( !pending.test( p ) )
+					{
+						pending.set( p );
+						remaining++;
+					}
+				}
+			}
+		}
+	};
+
+	// Locations read (may) and written (must) by every top-level instruction, recorded while the location map is built
+	// so that the analyses do not query the decompiler again. Registers are kept as bitmaps numbered like the location
+	// map and memory as the raw intervals, both in shared arrays so that recording makes no per-instruction allocations.
+	//
+	struct access_lists
+	{
+		struct list
+		{
+			uint32_t words, words_end;      // Register bitmap.
+			uint32_t memory, memory_end;    // Memory intervals.
+		};
+
+		std::vector<uint32_t> offsets = { 0 };   // Instructions of block b are offsets[ b ] .. offsets[ b + 1 ).
+		std::vector<list> uses;
+		std::vector<list> defs;
+		std::vector<uint64_t> register_words;
+		std::vector<ivl_t> memory_intervals;
+
+		list record( const mlist_t& l )
+		{
+			int last = l.reg.last();
+			list result = { ( uint32_t ) register_words.size(), 0, ( uint32_t ) memory_intervals.size(), 0 };
+			register_words.resize( register_words.size() + ( size_t ) ( last + 64 ) / 64 );
+			uint64_t* words = register_words.data() + result.words;
+			for ( auto it = l.reg.begin(); it != l.reg.end(); l.reg.inc( it ) )
+				words[ *it >> 6 ] |= 1ull << ( *it & 63 );
+			memory_intervals.insert( memory_intervals.end(), l.mem.begin(), l.mem.end() );
+			result.words_end = ( uint32_t ) register_words.size();
+			result.memory_end = ( uint32_t ) memory_intervals.size();
+			return result;
+		}
+		std::span<const uint64_t> registers( const list& l ) const { return { register_words.data() + l.words, register_words.data() + l.words_end }; }
+		std::span<const ivl_t> memory( const list& l ) const { return { memory_intervals.data() + l.memory, memory_intervals.data() + l.memory_end }; }
+	};
+
+	// Dense numbering of the locations of an mba_t, computed from the use/def lists of the decompiler so that calls
+	// account for their arguments, passed, spoiled and returned registers. Register bytes come first, numbered like
+	// mreg_t, followed by the memory bytes must-defined somewhere in the function. Memory that is never must-defined
+	// (globals only read, accesses through pointers) is not tracked and is always considered live.
+	//
+	struct location_map
+	{
+		size_t reg_count = 0;
+		std::vector<ivl_t> memory;                  // Disjoint memory ranges sorted by address.
+		std::vector<size_t> memory_bits = { 0 };    // Bit of the first byte of each range, followed by the total.
+
+		size_t size() const { return reg_count + memory_bits.back(); }
+
+		// Invokes functor( first_bit, count ) for every tracked run of the interval and returns the number of bytes
+		// covered by tracked ranges.
+		//
+		template<typename F>
+		uval_t for_each_run( const ivl_t& ivl, F&& functor ) const
+		{
+			uval_t end = ivl.size > BADADDR - ivl.off ? BADADDR : ivl.off + ivl.size;
+			auto it = std::upper_bound( memory.begin(), memory.end(), ivl.off, [ ] ( uval_t off, const ivl_t& r ) { return off < r.off + r.size; } );
+			uval_t covered = 0;
+			for ( ; it != memory.end() && it->off < end; ++it )
+			{
+				uval_t lo = std::max( it->off, ivl.off ), hi = std::min( it->off + it->size, end );
+				functor( reg_count + memory_bits[ it - memory.begin() ] + ( size_t ) ( lo - it->off ), ( size_t ) ( hi - lo ) );
+				covered += hi - lo;
+			}
+			return covered;
+		}
+
+		// Adds the tracked locations of the list to the set.
+		//
+		void add( dense_bitset& set, const mlist_t& list ) const
+		{
+			for ( int r = 0, last = std::min( list.reg.last(), ( int ) reg_count - 1 ); r <= last; r++ )
+				if ( list.reg.has( r ) )
+					set.set( ( size_t ) r );
+			for ( const ivl_t& ivl : list.mem )
+				for_each_run( ivl, [ & ] ( size_t first, size_t count ) { set.set_range( first, count ); } );
+		}
+		void add( dense_bitset& set, const access_lists& lists, const access_lists::list& list ) const
+		{
+			std::span<const uint64_t> regs = lists.registers( list );
+			for ( size_t i = 0; i != regs.size() && i * 64 < reg_count; i++ )
+			{
+				uint64_t w = regs[ i ];
+				if ( reg_count - i * 64 < 64 )
+					w &= ( 1ull << ( reg_count - i * 64 ) ) - 1;
+				set.words[ i ] |= w;
+			}
+			for ( const ivl_t& ivl : lists.memory( list ) )
+				for_each_run( ivl, [ & ] ( size_t first, size_t count ) { set.set_range( first, count ); } );
+		}
+
+		// Returns whether any location of the list is in the set, untracked locations are members of every set.
+		//
+		bool test( const dense_bitset& set, const mlist_t& list ) const
+		{
+			for ( int r = 0, last = list.reg.last(); r <= last; r++ )
+				if ( list.reg.has( r ) && ( ( size_t ) r >= reg_count || set.test( ( size_t ) r ) ) )
+					return true;
+			for ( const ivl_t& ivl : list.mem )
+			{
+				bool any = false;
+				uval_t covered = for_each_run( ivl, [ & ] ( size_t first, size_t count )
+				{
+					for ( size_t i = first; i != first + count && !any; i++ )
+						any = set.test( i );
+				} );
+				if ( any || covered != ivl.size )
+					return true;
+			}
+			return false;
+		}
+
+		// Numbers the locations of the function, the lists it queries are kept in accesses if given so that the analyses
+		// do not have to build them again.
+		//
+		static location_map build( mba_t* mba, access_lists* accesses = nullptr )
+		{
+			location_map map = {};
+			std::vector<ivl_t> defined;
+			auto visit_regs = [ & ] ( const mlist_t& list ) { map.reg_count = std::max( map.reg_count, ( size_t ) ( list.reg.last() + 1 ) ); };
+			for ( mblock_t* blk : basic_blocks( mba ) )
+			{
+				if ( blk->type == BLT_STOP )
+				{
+					blk->make_lists_ready();
+					visit_regs( blk->maybuse );
+				}
+				for ( minsn_t* ins = blk->head; ins; ins = ins->next )
+				{
+					mlist_t use = blk->build_use_list( *ins, MAY_ACCESS );
+					mlist_t must = blk->build_def_list( *ins, MUST_ACCESS );
+					visit_regs( use );
+					visit_regs( blk->build_def_list( *ins, MAY_ACCESS ) );
+					defined.insert( defined.end(), must.mem.begin(), must.mem.end() );
+					if ( accesses )
+					{
+						accesses->uses.push_back( accesses->record( use ) );
+						accesses->defs.push_back( accesses->record( must ) );
+					}
+				}
+				if ( accesses )
+					accesses->offsets.push_back( ( uint32_t ) accesses->uses.size() );
+			}
+
+			// Merge the must-defined intervals into disjoint ranges.
+			//
+			std::sort( defined.begin(), defined.end(), [ ] ( const ivl_t& a, const ivl_t& b ) { return a.off < b.off; } );
+			for ( const ivl_t& ivl : defined )
+			{
+				if ( !ivl.size )
+					continue;
+				if ( !map.memory.empty() && ivl.off <= map.memory.back().off + map.memory.back().size )
+					map.memory.back().size = std::max( map.memory.back().size, ivl.off + ivl.size - map.memory.back().off );
+				else
+					map.memory.push_back( ivl );
+			}
+			for ( const ivl_t& range : map.memory )
+				map.memory_bits.push_back( map.memory_bits.back() + ( size_t ) range.size );
+			return map;
+		}
+	};
+
+	// Live variable analysis over register and memory bytes. At the stop block the registers it uses (the return
+	// registers and those preserved for the caller) and all tracked memory are live, any other exit (noreturn calls,
+	// indirect jumps) leaves every location live.
+	//
+	struct liveness
+	{
+		location_map locations;
+		std::vector<dense_bitset> use;    // Upward exposed uses of each block.
+		std::vector<dense_bitset> def;    // Must-definitions of each block.
+		std::vector<dense_bitset> live_in;
+		std::vector<dense_bitset> live_out;
+		dense_bitset at_stop;             // State at the exit of the stop block.
+		size_t iterations = 0;
+
+		liveness( mba_t* mba, const cfg_order& order )
+		{
+			access_lists accesses;
+			locations = location_map::build( mba, &accesses );
+			size_t n = locations.size();
+			use.assign( mba->qty, dense_bitset{ n } );
+			def.assign( mba->qty, dense_bitset{ n } );
+			at_stop = dense_bitset{ n };
+			at_stop.set_range( locations.reg_count, n - locations.reg_count );
+			dense_bitset everything{ n };
+			everything.set_range( 0, n );
+
+			dense_bitset iuse{ n }, idef{ n };
+			for ( mblock_t* blk : basic_blocks( mba ) )
+			{
+				if ( blk->type == BLT_STOP )
+					locations.add( at_stop, blk->maybuse );
+
+				auto& u = use[ blk->serial ];
+				auto& d = def[ blk->serial ];
+				for ( uint32_t i = accesses.offsets[ blk->serial + 1 ]; i-- != accesses.offsets[ blk->serial ]; )
+				{
+					iuse.clear();
+					idef.clear();
+					locations.add( iuse, accesses, accesses.uses[ i ] );
+					locations.add( idef, accesses, accesses.defs[ i ] );
+					u.subtract( idef );
+					u.merge( iuse );
+					d.merge( idef );
+				}
+			}
+
+			auto transfer = [ & ] ( mblock_t* blk, const dense_bitset& out, dense_bitset& in )
+			{
+				in = out;
+				in.subtract( def[ blk->serial ] );
+				in.merge( use[ blk->serial ] );
+			};
+			auto meet = [ ] ( dense_bitset& acc, const dense_bitset& x ) { acc.merge( x ); };
+			auto boundary = [ & ] ( mblock_t* blk ) -> const dense_bitset& { return blk->type == BLT_STOP ? at_stop : everything; };
+			dataflow_solver<direction::backward, dense_bitset, decltype( transfer ), decltype( meet )> solver{ mba, order, transfer, meet };
+			solver.solve( boundary, dense_bitset{ n } );
+			live_in = std::move( solver.in );
+			live_out = std::move( solver.out );
+			iterations = solver.iterations;
+		}
+		liveness( mba_t* mba ) : liveness( mba, cfg_order{ mba } ) {}
+
+		// Returns whether any location read by the operand may be live, locations that are not tracked always are.
+		//
+		bool is_live_in( mblock_t* blk, const mop_t& op ) const { return test( live_in[ blk->serial ], blk, op ); }
+		bool is_live_out( mblock_t* blk, const mop_t& op ) const { return test( live_out[ blk->serial ], blk, op ); }
+		bool test( const dense_bitset& set, mblock_t* blk, const mop_t& op ) const
+		{
+			mlist_t list;
+			blk->append_use_list( &list, op, MAY_ACCESS );
+			return locations.test( set, list );
+		}
+	};
+
+	// Reaching definitions of the must-defined locations, each contiguous run of locations written by an instruction is
+	// a definition and it is killed only by a later definition of exactly the same run. May-definitions such as stores
+	// through pointers and spoiled registers are not recorded.
+	//
+	struct reaching_definitions
+	{
+		struct definition
+		{
+			mblock_t* blk;
+			minsn_t* ins;
+			uint32_t first;
+			uint32_t count;
+		};
+
+		location_map locations;
+		std::vector<definition> definitions;
+		std::vector<dense_bitset> gen;
+		std::vector<dense_bitset> kill;
+		std::vector<dense_bitset> reach_in;
+		std::vector<dense_bitset> reach_out;
+		size_t iterations = 0;
+
+		reaching_definitions( mba_t* mba, const cfg_order& order )
+		{
+			access_lists accesses;
+			locations = location_map::build( mba, &accesses );
+
+			// Enumerate the definitions and group them by location.
+			//
+			std::unordered_map<uint64_t, std::vector<uint32_t>> by_location;
+			dense_bitset defs{ locations.size() };
+			for ( mblock_t* blk : basic_blocks( mba ) )
+			{
+				uint32_t i = accesses.offsets[ blk->serial ];
+				for ( minsn_t* ins = blk->head; ins; ins = ins->next, i++ )
+				{
+					defs.clear();
+					locations.add( defs, accesses, accesses.defs[ i ] );
+
+					size_t first = 0, count = 0;
+					auto flush = [ & ] ()
+					{
+						if ( !count )
+							return;
+						by_location[ ( uint64_t( first ) << 32 ) | count ].push_back( ( uint32_t ) definitions.size() );
+						definitions.push_back( { blk, ins, ( uint32_t ) first, ( uint32_t ) count } );
+						count = 0;
+					};
+					defs.for_each( [ & ] ( size_t bit )
+					{
+						if ( count && bit != first + count )
+							flush();
+						if ( !count )
+							first = bit;
+						count++;
+					} );
+					flush();
+				}
+			}
+
+			size_t n = definitions.size();
+			gen.assign( mba->qty, dense_bitset{ n } );
+			kill.assign( mba->qty, dense_bitset{ n } );
+			for ( size_t i = 0; i != n; i++ )
+			{
+				const definition& d = definitions[ i ];
+				auto& g = gen[ d.blk->serial ];
+				auto& k = kill[ d.blk->serial ];
+				for ( uint32_t other : by_location[ ( uint64_t( d.first ) << 32 ) | d.count ] )
+				{
+					g.reset( other );
+					k.set( other );
+				}
+				g.set( i );
+			}
+
+			auto transfer = [ & ] ( mblock_t* blk, const dense_bitset& in, dense_bitset& out )
+			{
+				out = in;
+				out.subtract( kill[ blk->serial ] );
+				out.merge( gen[ blk->serial ] );
+			};
+			auto meet = [ ] ( dense_bitset& acc, const dense_bitset& x ) { acc.merge( x ); };
+			dataflow_solver<direction::forward, dense_bitset, decltype( transfer ), decltype( meet )> solver{ mba, order, transfer, meet };
+			dense_bitset empty{ n };
+			solver.solve( empty, empty );
+			reach_in = std::move( solver.in );
+			reach_out = std::move( solver.out );
+			iterations = solver.iterations;
+		}
+		reaching_definitions( mba_t* mba ) : reaching_definitions( mba, cfg_order{ mba } ) {}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,597 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <algorithm>
+#include <unordered_map>
+#include "ida.hpp"
+#include "hash.hpp"
+#include "mapped_file.hpp"
+
+// Persistent caching of decompilation results keyed by function content.
+//
+namespace hex
+{
+	// Fingerprint of everything a decompilation depends on, the zero value is reserved.
+	//
+	struct fingerprint
+	{
+		uint64_t lo = 0;
+		uint64_t hi = 0;
+
+		bool empty() const { return !lo && !hi; }
+		bool operator==( const fingerprint& ) const = default;
+	};
+	struct fingerprint_hash
+	{
+		size_t operator()( const fingerprint& f ) const { return ( size_t ) detail::hash_mix( f.lo, f.hi ); }
+	};
+
+	namespace detail
+	{
+		struct fingerprint_builder
+		{
+			uint64_t lo = 0x6A09E667F3BCC908ull;
+			uint64_t hi = 0xBB67AE8584CAA73Bull;
+
+			void add( uint64_t v )
+			{
+				lo = hash_mix( lo, v );
+				hi = hash_mix( hi, v ^ 0xA54FF53A5F1D36F1ull );
+			}
+			void add( const void* data, size_t n )
+			{
+				auto* p = ( const uint8_t* ) data;
+				for ( ; n >= 8; n -= 8, p += 8 )
+				{
+					uint64_t v;
+					memcpy( &v, p, 8 );
+					add( v );
+				}
+				uint64_t tail = 0;
+				memcpy( &tail, p, n );
+				add( tail ^ ( n << 56 ) );
+			}
+			void add( const qstring& s ) { add( s.c_str(), s.length() ); }
+			void add_type( const tinfo_t& type )
+			{
+				qstring t, f;
+				if ( type.serialize( &t, &f ) )
+				{
+					add( t );
+					add( f );
+				}
+				else
+				{
+					add( 0 );
+				}
+			}
+			void add_type( ea_t ea )
+			{
+				tinfo_t type;
+				if ( get_tinfo( &type, ea ) )
+					add_type( type );
+				else
+					add( 0 );
+			}
+			void add_symbol( ea_t ea )
+			{
+				qstring name;
+				get_name( &name, ea );
+				add( name );
+				add_type( ea );
+			}
+
+			// Addresses within the function are hashed relative to its entry.
+			//
+			void add_locator( const lvar_locator_t& ll, ea_t base )
+			{
+				add( ll.defea == BADADDR ? BADADDR : ll.defea - base );
+				add( ll.location.atype() );
+				add( ll.location.is_stkoff() ? ( uint64_t ) ll.location.stkoff() : ll.location.is_reg1() ? ( uint64_t ) ll.location.reg1() : 0 );
+			}
+			fingerprint finish() const { return { lo | ( !lo && !hi ), hi }; }
+		};
+	};
+
+	// Fingerprints a function by everything its decompilation depends on: its entry address and name, its bytes with
+	// relocated fields masked out, the name and type of every code and data reference target outside of it, its own
+	// prototype, the user names of its items, the user settings saved by the decompiler and the decompiler version.
+	// The entry is part of the key since the pseudocode spells out addresses, be it in auto-generated names such as
+	// sub_1000 or in constants; other addresses within the function are hashed relative to it.
+	//
+	inline fingerprint function_fingerprint( func_t* pfn )
+	{
+		detail::fingerprint_builder b;
+		ea_t base = pfn->start_ea;
+		b.add( get_hexrays_version(), strlen( get_hexrays_version() ) );
+		b.add( base );
+		b.add_symbol( base );
+
+		std::vector<uint8_t> bytes;
+		func_tail_iterator_t fti{ pfn };
+		for ( bool ok = fti.main(); ok; ok = fti.next() )
+		{
+			const auto& chunk = fti.chunk();
+			bytes.resize( chunk.end_ea - chunk.start_ea );
+			if ( get_bytes( bytes.data(), ( ssize_t ) bytes.size(), chunk.start_ea ) != ( ssize_t ) bytes.size() )
+				std::fill( bytes.begin(), bytes.end(), 0 );
+
+			for ( ea_t ea = get_next_fixup_ea( chunk.start_ea - 1 ); ea != BADADDR && ea < chunk.end_ea; ea = get_next_fixup_ea( ea ) )
+			{
+				fixup_data_t fd;
+				if ( !fd.get( ea ) )
+					continue;
+				int size = calc_fixup_size( fd.get_type() );
+				size_t offset = ea - chunk.start_ea;
+				std::fill_n( bytes.begin() + offset, std::min<size_t>( size > 0 ? size : 0, bytes.size() - offset ), 0 );
+
+				ea_t target = fd.get_base() + fd.off;
+				qstring name;
+				get_name( &name, target );
+				b.add( offset );
+				b.add( fd.get_type() );
+				b.add( ( uint64_t ) fd.displacement );
+				b.add( name );
+				b.add_type( target );
+			}
+			b.add( chunk.end_ea - chunk.start_ea );
+			b.add( bytes.data(), bytes.size() );
+		}
+
+		// References leaving the function and local names.
+		//
+		func_item_iterator_t fii;
+		for ( bool ok = fii.set( pfn ); ok; ok = fii.next_head() )
+		{
+			ea_t ea = fii.current();
+			if ( has_user_name( get_flags( ea ) ) )
+			{
+				qstring name;
+				get_name( &name, ea );
+				b.add( ea - base );
+				b.add( name );
+			}
+			xrefblk_t xb;
+			for ( bool has_ref = xb.first_from( ea, XREF_FAR ); has_ref; has_ref = xb.next_from() )
+			{
+				if ( func_contains( pfn, xb.to ) )
+					continue;
+				b.add( ea - base );
+				b.add( xb.iscode );
+				b.add_symbol( xb.to );
+			}
+		}
+
+		// User settings saved by the decompiler.
+		//
+		lvar_uservec_t lvinf;
+		if ( restore_user_lvar_settings( &lvinf, base ) )
+		{
+			b.add( lvinf.lvvec.size() );
+			for ( const lvar_saved_info_t& lv : lvinf.lvvec )
+			{
+				b.add_locator( lv.ll, base );
+				b.add( lv.name );
+				b.add_type( lv.type );
+				b.add( lv.cmt );
+				b.add( ( uint64_t ) lv.size );
+				b.add( ( uint64_t ) lv.flags );
+			}
+			for ( auto it = lvar_mapping_begin( &lvinf.lmaps ); it != lvar_mapping_end( &lvinf.lmaps ); it = lvar_mapping_next( it ) )
+			{
+				b.add_locator( lvar_mapping_first( it ), base );
+				b.add_locator( lvar_mapping_second( it ), base );
+			}
+			b.add( lvinf.stkoff_delta );
+			b.add( ( uint64_t ) lvinf.ulv_flags );
+		}
+		if ( user_cmts_t* cmts = restore_user_cmts( base ) )
+		{
+			for ( auto it = user_cmts_begin( cmts ); it != user_cmts_end( cmts ); it = user_cmts_next( it ) )
+			{
+				const treeloc_t& loc = user_cmts_first( it );
+				b.add( loc.ea - base );
+				b.add( ( uint64_t ) loc.itp );
+				b.add( user_cmts_second( it ) );
+			}
+			user_cmts_free( cmts );
+		}
+		if ( user_numforms_t* numforms = restore_user_numforms( base ) )
+		{
+			for ( auto it = user_numforms_begin( numforms ); it != user_numforms_end( numforms ); it = user_numforms_next( it ) )
+			{
+				const operand_locator_t& loc = user_numforms_first( it );
+				const number_format_t& nf = user_numforms_second( it );
+				b.add( loc.ea - base );
+				b.add( ( uint64_t ) loc.opnum );
+				b.add( ( uint64_t ) nf.flags32 );
+				b.add( ( uint64_t ) nf.props | ( uint64_t ) nf.serial << 8 | ( uint64_t ) ( uint8_t ) nf.org_nbytes << 16 );
+				b.add( nf.type_name );
+			}
+			user_numforms_free( numforms );
+		}
+		return b.finish();
+	}
+
+	// Cache interface, the text is the pseudocode without color tags and facts is an opaque blob of whatever the
+	// caller derived from the ctree.
+	//
+	struct cache_entry
+	{
+		std::string text;
+		std::string facts;
+	};
+	struct cache_stats
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t stores = 0;
+		uint64_t evictions = 0;
+		uint64_t entries = 0;
+		uint64_t bytes = 0;
+	};
+	struct decompilation_cache
+	{
+		virtual ~decompilation_cache() = default;
+		virtual bool find( const fingerprint& key, cache_entry& out ) = 0;
+		virtual void store( const fingerprint& key, const cache_entry& entry ) = 0;
+		virtual cache_stats statistics() = 0;
+	};
+
+	// In-memory backend, evicts the least recently used half once the size limit is reached.
+	//
+	struct memory_cache : decompilation_cache
+	{
+		struct record
+		{
+			cache_entry entry;
+			uint64_t stamp;
+		};
+		std::mutex lock;
+		std::unordered_map<fingerprint, record, fingerprint_hash> records;
+		size_t max_bytes;
+		uint64_t clock = 0;
+		cache_stats stats = {};
+
+		memory_cache( size_t max_bytes = 64 << 20 ) : max_bytes( max_bytes ) {}
+
+		bool find( const fingerprint& key, cache_entry& out ) override
+		{
+			std::lock_guard _g{ lock };
+			auto it = records.find( key );
+			if ( it == records.end() )
+				return stats.misses++, false;
+			it->second.stamp = ++clock;
+			out = it->second.entry;
+			return stats.hits++, true;
+		}
+		void store( const fingerprint& key, const cache_entry& entry ) override
+		{
+			std::lock_guard _g{ lock };
+			size_t size = entry.text.size() + entry.facts.size();
+			if ( size > max_bytes )
+				return;
+			if ( stats.bytes + size > max_bytes )
+				evict( max_bytes / 2 );
+			auto [it, inserted] = records.try_emplace( key, record{ entry, ++clock } );
+			if ( !inserted )
+				return;
+			stats.bytes += size;
+			stats.stores++;
+		}
+		cache_stats statistics() override
+		{
+			std::lock_guard _g{ lock };
+			cache_stats result = stats;
+			result.entries = records.size();
+			return result;
+		}
+
+		void evict( size_t target )
+		{
+			std::vector<std::pair<uint64_t, fingerprint>> order;
+			order.reserve( records.size() );
+			for ( auto& [key, r] : records )
+				order.emplace_back( r.stamp, key );
+			std::sort( order.begin(), order.end(), [ ] ( auto& a, auto& b ) { return a.first < b.first; } );
+			for ( auto& [stamp, key] : order )
+			{
+				if ( stats.bytes <= target )
+					break;
+				auto it = records.find( key );
+				stats.bytes -= it->second.entry.text.size() + it->second.entry.facts.size();
+				records.erase( it );
+				stats.evictions++;
+			}
+		}
+	};
+
+	// File backend:
+	//  Append-only record log behind an open addressing hash index, both in a single memory mapped file. Lookups hold
+	//  a shared file lock and stores an exclusive one, so any number of processes can use the same file. Once the log
+	//  reaches the size limit or the index fills up, the least recently used half of the records is dropped and the
+	//  rest compacted in place.
+	//
+	struct file_cache : decompilation_cache
+	{
+		static constexpr uint32_t magic = 0x43445848;   // 'HXDC'
+		static constexpr uint32_t version = 1;
+
+		struct header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t bucket_count;
+			uint64_t data_begin;
+			uint64_t data_end;
+			uint64_t file_size;
+			uint64_t entries;
+			uint64_t clock;
+		};
+		struct bucket
+		{
+			fingerprint key;      // Empty if unused.
+			uint64_t offset;
+			uint64_t stamp;       // Last use, updated without the exclusive lock.
+		};
+		struct record
+		{
+			fingerprint key;
+			uint32_t text_size;
+			uint32_t facts_size;
+		};
+
+		mapped_file file;
+		size_t max_size = 0;
+		cache_stats stats = {};
+		std::mutex lock;
+
+		file_cache() = default;
+		file_cache( const char* path, size_t max_size = 256 << 20, size_t buckets = 1 << 16 ) { open( path, max_size, buckets ); }
+
+		header* head() const { return ( header* ) file.data; }
+		bucket* buckets() const { return ( bucket* ) ( head() + 1 ); }
+		static size_t record_size( size_t payload ) { return ( sizeof( record ) + payload + 7 ) & ~( size_t ) 7; }
+
+		bool is_open() const { return file.is_open(); }
+		bool open( const char* path, size_t limit = 256 << 20, size_t bucket_count = 1 << 16 )
+		{
+			std::lock_guard _g{ lock };
+			if ( !file.open( path, sizeof( header ) ) )
+				return false;
+
+			// Existing files keep their geometry, the requested bucket count only applies to new or incompatible ones.
+			//
+			file.lock();
+			bool valid = head()->magic == magic && head()->version == version && sync() &&
+				std::has_single_bit( head()->bucket_count ) && head()->bucket_count >= 16 &&
+				head()->data_begin == sizeof( header ) + head()->bucket_count * sizeof( bucket ) &&
+				head()->data_begin <= head()->data_end && head()->data_end <= head()->file_size;
+			if ( valid )
+				bucket_count = head()->bucket_count;
+			else
+				bucket_count = std::bit_ceil( std::max<size_t>( bucket_count, 16 ) );
+
+			size_t data_begin = sizeof( header ) + bucket_count * sizeof( bucket );
+			max_size = std::max( limit, data_begin + ( 1 << 20 ) );
+			bool ok = file.size >= data_begin + ( 1 << 20 ) || file.resize( data_begin + ( 1 << 20 ) );
+			if ( ok && !valid )
+			{
+				std::fill_n( file.data, data_begin, 0 );
+				*head() = { magic, version, bucket_count, data_begin, data_begin, file.size, 0, 0 };
+			}
+			else if ( ok )
+			{
+				head()->file_size = std::max<uint64_t>( head()->file_size, file.size );
+			}
+			file.unlock();
+			if ( !ok )
+				file.close();
+			return ok;
+		}
+
+		// Remaps the file if another process has grown it.
+		//
+		bool sync()
+		{
+			if ( head()->file_size > file.size )
+				return file.resize( head()->file_size );
+			return true;
+		}
+
+		bucket* probe( const fingerprint& key ) const
+		{
+			size_t mask = head()->bucket_count - 1;
+			for ( size_t i = fingerprint_hash{}( key ) & mask;; i = ( i + 1 ) & mask )
+			{
+				bucket& b = buckets()[ i ];
+				if ( b.key.empty() || b.key == key )
+					return &b;
+			}
+		}
+
+		bool find( const fingerprint& key, cache_entry& out ) override
+		{
+			std::lock_guard _g{ lock };
+			if ( !is_open() )
+				return false;
+			file.lock( false );
+			bool found = false;
+			if ( sync() )
+			{
+				// Records are validated against the log before being read, the file may have been damaged or written
+				// by a misbehaving process.
+				//
+				bucket* b = probe( key );
+				auto* r = ( const record* ) ( file.data + b->offset );
+				if ( !b->key.empty() && b->offset >= head()->data_begin && b->offset <= head()->data_end - sizeof( record ) &&
+					head()->data_end - sizeof( record ) - b->offset >= ( uint64_t ) r->text_size + r->facts_size && r->key == key )
+				{
+					auto* payload = ( const char* ) ( r + 1 );
+					out.text.assign( payload, r->text_size );
+					out.facts.assign( payload + r->text_size, r->facts_size );
+					std::atomic_ref<uint64_t>{ b->stamp }.store( std::atomic_ref<uint64_t>{ head()->clock }.fetch_add( 1 ) + 1, std::memory_order::relaxed );
+					found = true;
+				}
+			}
+			file.unlock();
+			( found ? stats.hits : stats.misses )++;
+			return found;
+		}
+
+		void store( const fingerprint& key, const cache_entry& entry ) override
+		{
+			std::lock_guard _g{ lock };
+			// Records must fit next to what compaction keeps, which is up to half of the log.
+			//
+			size_t size = record_size( entry.text.size() + entry.facts.size() );
+			if ( !is_open() || size > ( max_size - head()->data_begin ) / 2 || entry.text.size() > UINT32_MAX || entry.facts.size() > UINT32_MAX )
+				return;
+
+			file.lock();
+			if ( sync() && probe( key )->key.empty() )
+			{
+				if ( head()->data_end + size > max_size || ( head()->entries + 1 ) * 4 > head()->bucket_count * 3 )
+					compact();
+
+				// Grow the file geometrically up to the limit. The log can still be too full if another process shares
+				// the file with a larger limit, the record is dropped then.
+				//
+				bool ok = head()->data_end + size <= max_size;
+				if ( ok && head()->data_end + size > file.size )
+				{
+					size_t grown = std::min( max_size, std::max<size_t>( file.size * 2, head()->data_end + size ) );
+					if ( ( ok = file.resize( grown ) ) )
+						head()->file_size = file.size;
+				}
+				ok = ok && head()->data_end + size <= file.size;
+				if ( ok )
+				{
+					auto* r = ( record* ) ( file.data + head()->data_end );
+					*r = { key, ( uint32_t ) entry.text.size(), ( uint32_t ) entry.facts.size() };
+					auto* payload = ( char* ) ( r + 1 );
+					std::copy_n( entry.text.data(), entry.text.size(), payload );
+					std::copy_n( entry.facts.data(), entry.facts.size(), payload + entry.text.size() );
+
+					bucket* b = probe( key );
+					*b = { key, head()->data_end, ++head()->clock };
+					head()->data_end += size;
+					head()->entries++;
+					stats.stores++;
+				}
+			}
+			file.unlock();
+		}
+
+		// Keeps the most recently used records filling at most half of the limit and half of the index, must hold the
+		// exclusive lock.
+		//
+		void compact()
+		{
+			header* h = head();
+			std::vector<bucket> live;
+			live.reserve( h->entries );
+			for ( size_t i = 0; i != h->bucket_count; i++ )
+				if ( !buckets()[ i ].key.empty() )
+					live.push_back( buckets()[ i ] );
+			std::sort( live.begin(), live.end(), [ ] ( const bucket& a, const bucket& b ) { return a.stamp > b.stamp; } );
+
+			size_t budget = ( max_size - h->data_begin ) / 2, used = 0, keep = 0;
+			for ( ; keep != live.size() && keep < h->bucket_count / 2; keep++ )
+			{
+				auto* r = ( record* ) ( file.data + live[ keep ].offset );
+				size_t size = record_size( r->text_size + r->facts_size );
+				if ( used + size > budget )
+					break;
+				used += size;
+			}
+			stats.evictions += live.size() - keep;
+			live.resize( keep );
+
+			// Copy the survivors out, the log is rewritten in place.
+			//
+			std::vector<uint8_t> data( used );
+			size_t offset = 0;
+			for ( bucket& b : live )
+			{
+				auto* r = ( record* ) ( file.data + b.offset );
+				size_t size = record_size( r->text_size + r->facts_size );
+				std::copy_n( file.data + b.offset, size, data.data() + offset );
+				b.offset = h->data_begin + offset;
+				offset += size;
+			}
+			std::fill_n( ( uint8_t* ) buckets(), h->bucket_count * sizeof( bucket ), 0 );
+			std::copy( data.begin(), data.end(), file.data + h->data_begin );
+			for ( const bucket& b : live )
+				*probe( b.key ) = b;
+			h->data_end = h->data_begin + used;
+			h->entries = live.size();
+		}
+
+		void flush() { file.flush(); }
+
+		cache_stats statistics() override
+		{
+			std::lock_guard _g{ lock };
+			cache_stats result = stats;
+			if ( is_open() )
+			{
+				result.entries = head()->entries;
+				result.bytes = head()->data_end - head()->data_begin;
+			}
+			return result;
+		}
+	};
+
+	// Pseudocode of a decompiled function without color tags, one line per row.
+	//
+	inline std::string pseudocode_text( cfunc_t* cfunc )
+	{
+		std::string result;
+		qstring line;
+		for ( const simpleline_t& sl : cfunc->get_pseudocode() )
+		{
+			tag_remove( &line, sl.line.c_str() );
+			result.append( line.c_str(), line.length() );
+			result += '\n';
+		}
+		return result;
+	}
+
+	// Decompiles the function unless the cache already holds the result for its fingerprint. The facts functor, if
+	// any, is invoked as facts( cfunc_t* ) -> std::string on misses and its result stored alongside the text. cfunc is
+	// only set when the function was actually decompiled.
+	//
+	struct cached_result
+	{
+		bool hit = false;
+		cache_entry entry;
+		cfuncptr_t cfunc = {};
+	};
+	template<typename F = std::nullptr_t>
+	inline std::optional<cached_result> cached_decompile( func_t* pfn, decompilation_cache& cache, F&& facts = nullptr, hexrays_failure_t* hf = nullptr )
+	{
+		cached_result result = {};
+		fingerprint key = function_fingerprint( pfn );
+		if ( cache.find( key, result.entry ) )
+		{
+			result.hit = true;
+			return result;
+		}
+
+		result.cfunc = decompile_func( pfn, hf );
+		if ( !result.cfunc )
+			return std::nullopt;
+		result.entry.text = pseudocode_text( &*result.cfunc );
+		if constexpr ( !std::is_null_pointer_v<std::decay_t<F>> )
+			result.entry.facts = facts( &*result.cfunc );
+		cache.store( key, result.entry );
+		return result;
+	}
+};
\ No newline at end of file
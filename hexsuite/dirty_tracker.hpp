@@ -0,0 +1,240 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include "ida.hpp"
+#include "components.hpp"
+#include "events.hpp"
+
+// Tracking of functions whose decompilation inputs changed.
+//
+namespace hex
+{
+	// Dirty tracker:
+	//  Listens to the database and decompiler change events and records the entry of every function whose output may
+	//  have changed, so that consumers only re-process those. Changes to the prototype, name or return behaviour of a
+	//  function or global also dirty every function referencing it; changes to the local types dirty everything since
+	//  types are not tracked per function. Optionally also marks the cached ctree of dirtied functions as stale.
+	//
+	struct dirty_tracker : component
+	{
+		struct idb_handler
+		{
+			dirty_tracker* self;
+			ssize_t operator()( idb_event::event_code_t code, va_list va ) const { self->on_idb( code, va ); return 0; }
+		};
+
+		std::unordered_set<ea_t> dirty;
+		bool all = false;
+		bool invalidate_decompiler;
+		bool installed = false;
+		idb_callback<idb_handler> idb{ idb_handler{ this } };
+
+		static constexpr hexrays_event_t lvar_events[] = { lxe_lvar_name_changed, lxe_lvar_type_changed, lxe_lvar_cmt_changed, lxe_lvar_mapping_changed };
+
+		dirty_tracker( bool invalidate_decompiler = false ) : invalidate_decompiler( invalidate_decompiler ) {}
+		dirty_tracker( const dirty_tracker& ) = delete;
+		dirty_tracker& operator=( const dirty_tracker& ) = delete;
+		~dirty_tracker() { uninstall(); }
+
+		// Marking.
+		//
+		void mark( ea_t ea )
+		{
+			func_t* pfn = get_func( ea );
+			if ( !pfn )
+				return;
+			if ( !all )
+				dirty.insert( pfn->start_ea );
+			if ( invalidate_decompiler )
+				mark_cfunc_dirty( pfn->start_ea );
+		}
+		void mark_referencing( ea_t ea )
+		{
+			xrefblk_t xb;
+			for ( bool ok = xb.first_to( ea, XREF_ALL ); ok; ok = xb.next_to() )
+				mark( xb.from );
+		}
+		void mark_all()
+		{
+			all = true;
+			dirty.clear();
+			if ( invalidate_decompiler )
+				clear_cached_cfuncs();
+		}
+		void clear()
+		{
+			all = false;
+			dirty.clear();
+		}
+
+		// Queries.
+		//
+		bool empty() const { return !all && dirty.empty(); }
+		size_t size() const { return all ? get_func_qty() : dirty.size(); }
+		bool is_dirty( ea_t ea ) const
+		{
+			func_t* pfn = get_func( ea );
+			return pfn && ( all || dirty.contains( pfn->start_ea ) );
+		}
+
+		// Returns the entries of the dirty functions in ascending order and resets the tracker.
+		//
+		std::vector<ea_t> take()
+		{
+			std::vector<ea_t> result;
+			if ( all )
+			{
+				size_t n = get_func_qty();
+				result.reserve( n );
+				for ( size_t i = 0; i != n; i++ )
+					if ( func_t* pfn = getn_func( i ) )
+						result.push_back( pfn->start_ea );
+			}
+			else
+			{
+				result.assign( dirty.begin(), dirty.end() );
+				std::sort( result.begin(), result.end() );
+			}
+			clear();
+			return result;
+		}
+
+		// Invokes functor( func_t* ) for every dirty function that still exists, returns the number of functions.
+		//
+		template<typename F>
+		size_t drain( F&& functor )
+		{
+			size_t n = 0;
+			for ( ea_t ea : take() )
+			{
+				func_t* pfn = get_func( ea );
+				if ( pfn && pfn->start_ea == ea )
+				{
+					functor( pfn );
+					n++;
+				}
+			}
+			return n;
+		}
+
+		void on_idb( idb_event::event_code_t code, va_list va )
+		{
+			switch ( code )
+			{
+				case idb_event::closebase:
+					clear();
+					break;
+				case idb_event::local_types_changed:
+				case idb_event::compiler_changed:
+					mark_all();
+					break;
+
+				// Naming and typing of an address, the referencing functions change unless the name is local.
+				//
+				case idb_event::renamed:
+				{
+					ea_t ea = va_arg( va, ea_t );
+					( void ) va_arg( va, const char* );
+					bool local = va_arg( va, int ) != 0;
+					mark( ea );
+					if ( !local )
+						mark_referencing( ea );
+					break;
+				}
+				case idb_event::ti_changed:
+				{
+					ea_t ea = va_arg( va, ea_t );
+					mark( ea );
+					mark_referencing( ea );
+					break;
+				}
+
+				// Changes within a function.
+				//
+				case idb_event::op_ti_changed:
+				case idb_event::op_type_changed:
+				case idb_event::byte_patched:
+				case idb_event::cmt_changed:
+				case idb_event::extra_cmt_changed:
+				case idb_event::callee_addr_changed:
+					mark( va_arg( va, ea_t ) );
+					break;
+
+				// Changes of a function.
+				//
+				case idb_event::func_added:
+				case idb_event::func_updated:
+				case idb_event::set_func_end:
+				case idb_event::func_tail_appended:
+				case idb_event::stkpnts_changed:
+					if ( func_t* pfn = va_arg( va, func_t* ) )
+						mark( pfn->start_ea );
+					break;
+
+				// Raised before the entry moves, the function is tracked under its new entry which may not be part of it
+				// yet. Tail chunks only change the extent of their owner.
+				//
+				case idb_event::set_func_start:
+				{
+					func_t* pfn = va_arg( va, func_t* );
+					ea_t new_start = va_arg( va, ea_t );
+					if ( !pfn )
+						break;
+					func_t* owner = get_func( pfn->start_ea );
+					mark( pfn->start_ea );
+					if ( owner && owner->start_ea == pfn->start_ea )
+					{
+						dirty.erase( pfn->start_ea );
+						if ( !all )
+							dirty.insert( new_start );
+					}
+					break;
+				}
+				case idb_event::func_noret_changed:
+					if ( func_t* pfn = va_arg( va, func_t* ) )
+					{
+						mark( pfn->start_ea );
+						mark_referencing( pfn->start_ea );
+					}
+					break;
+				case idb_event::deleting_func:
+					if ( func_t* pfn = va_arg( va, func_t* ) )
+					{
+						dirty.erase( pfn->start_ea );
+						mark_referencing( pfn->start_ea );
+					}
+					break;
+				default:
+					break;
+			}
+		}
+
+		// Edits made in the pseudocode view.
+		//
+		static ssize_t on_lvar( void* ctx, const void* args )
+		{
+			auto* vu = std::get<0>( *( const std::tuple<vdui_t*>* ) args );
+			if ( vu && vu->cfunc )
+				( ( dirty_tracker* ) ctx )->mark( vu->cfunc->entry_ea );
+			return 0;
+		}
+		static ssize_t on_cmt( void* ctx, const void* args )
+		{
+			if ( auto* cfunc = std::get<0>( *( const std::tuple<cfunc_t*>* ) args ) )
+				( ( dirty_tracker* ) ctx )->mark( cfunc->entry_ea );
+			return 0;
+		}
+
+		void set_state( bool enable ) override
+		{
+			if ( std::exchange( installed, enable ) == enable )
+				return;
+			idb.set_state( enable );
+			auto& bus = event_bus::instance();
+			for ( hexrays_event_t evt : lvar_events )
+				enable ? bus.subscribe( evt, { 0, &detail::decode_args<std::tuple<vdui_t*>>, &on_lvar, this } ) : bus.unsubscribe( evt, this );
+			enable ? bus.subscribe( hxe_cmt_changed, { 0, &detail::decode_args<std::tuple<cfunc_t*>>, &on_cmt, this } ) : bus.unsubscribe( hxe_cmt_changed, this );
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,416 @@
+#pragma once
+#include <span>
+#include <array>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include "ida.hpp"
+#include "hash.hpp"
+#include "ranges.hpp"
+#include "dataflow.hpp"
+#include "events.hpp"
+
+// Dominator trees, dominance frontiers and natural loops of microcode CFGs.
+//
+namespace hex
+{
+	namespace detail
+	{
+		// Reverse post-order of the nodes reachable from the root following the given edge list.
+		//
+		template<typename E>
+		inline std::vector<int> reverse_post_order( int n, int root, E&& edges )
+		{
+			std::vector<int> order;
+			if ( root < 0 || root >= n )
+				return order;
+			order.reserve( n );
+
+			std::vector<bool> visited( n );
+			std::vector<std::pair<int, int>> stack;
+			stack.emplace_back( root, 0 );
+			visited[ root ] = true;
+			while ( !stack.empty() )
+			{
+				auto& [id, next] = stack.back();
+				const intvec_t& list = edges( id );
+				if ( next < ( int ) list.size() )
+				{
+					int dst = list[ next++ ];
+					if ( !visited[ dst ] )
+					{
+						visited[ dst ] = true;
+						stack.emplace_back( dst, 0 );
+					}
+				}
+				else
+				{
+					order.push_back( id );
+					stack.pop_back();
+				}
+			}
+			std::reverse( order.begin(), order.end() );
+			return order;
+		}
+	};
+
+	// Dominator tree computed with the Cooper-Harvey-Kennedy algorithm, post-dominator trees are computed the same way
+	// over the reversed CFG. Dominance queries are answered in constant time using the pre/post numbering of the tree.
+	//
+	struct dominator_tree
+	{
+		int root = -1;
+		std::vector<int> idom;            // Immediate dominator of each block, the root's is itself and -1 if unreachable.
+		std::vector<int> pre;             // Pre-order number of each block in the tree.
+		std::vector<int> post;            // Post-order number of each block in the tree.
+		std::vector<int> child_offsets;   // Children of block n are children[ child_offsets[ n ] .. child_offsets[ n + 1 ] ).
+		std::vector<int> children;
+
+		dominator_tree() = default;
+
+		// Builds the tree given the reverse post-order from the root and the incoming edges of each block.
+		//
+		template<typename E>
+		dominator_tree( int n, const std::vector<int>& rpo, E&& incoming ) : root( rpo.empty() ? -1 : rpo.front() ), idom( n, -1 )
+		{
+			if ( root < 0 )
+				return;
+			std::vector<int> position( n, -1 );
+			for ( size_t i = 0; i != rpo.size(); i++ )
+				position[ rpo[ i ] ] = ( int ) i;
+
+			auto intersect = [ & ] ( int a, int b )
+			{
+				while ( a != b )
+				{
+					while ( position[ a ] > position[ b ] )
+						a = idom[ a ];
+					while ( position[ b ] > position[ a ] )
+						b = idom[ b ];
+				}
+				return a;
+			};
+
+			idom[ root ] = root;
+			for ( bool changed = true; changed; )
+			{
+				changed = false;
+				for ( size_t i = 1; i < rpo.size(); i++ )
+				{
+					int b = rpo[ i ];
+					int result = -1;
+					for ( int p : incoming( b ) )
+					{
+						if ( position[ p ] < 0 || idom[ p ] < 0 )
+							continue;
+						result = result < 0 ? p : intersect( p, result );
+					}
+					if ( result != idom[ b ] )
+					{
+						idom[ b ] = result;
+						changed = true;
+					}
+				}
+			}
+
+			// Flatten the children lists.
+			//
+			child_offsets.assign( n + 1, 0 );
+			for ( int b : rpo )
+				if ( b != root )
+					child_offsets[ idom[ b ] + 1 ]++;
+			for ( int i = 0; i != n; i++ )
+				child_offsets[ i + 1 ] += child_offsets[ i ];
+			children.resize( child_offsets[ n ] );
+			std::vector<int> fill( child_offsets.begin(), child_offsets.end() - 1 );
+			for ( int b : rpo )
+				if ( b != root )
+					children[ fill[ idom[ b ] ]++ ] = b;
+
+			// Number the tree.
+			//
+			pre.assign( n, -1 );
+			post.assign( n, -1 );
+			int pre_counter = 0, post_counter = 0;
+			std::vector<std::pair<int, int>> stack;
+			stack.emplace_back( root, child_offsets[ root ] );
+			pre[ root ] = pre_counter++;
+			while ( !stack.empty() )
+			{
+				auto& [id, next] = stack.back();
+				if ( next != child_offsets[ id + 1 ] )
+				{
+					int c = children[ next++ ];
+					pre[ c ] = pre_counter++;
+					stack.emplace_back( c, child_offsets[ c ] );
+				}
+				else
+				{
+					post[ id ] = post_counter++;
+					stack.pop_back();
+				}
+			}
+		}
+
+		bool reachable( int b ) const { return idom[ b ] >= 0; }
+		int immediate( int b ) const { return b == root ? -1 : idom[ b ]; }
+		std::span<const int> children_of( int b ) const { return { children.data() + child_offsets[ b ], children.data() + child_offsets[ b + 1 ] }; }
+
+		// Returns whether a dominates b, every block dominates itself.
+		//
+		bool dominates( int a, int b ) const { return reachable( a ) && reachable( b ) && pre[ a ] <= pre[ b ] && post[ a ] >= post[ b ]; }
+		bool strictly_dominates( int a, int b ) const { return a != b && dominates( a, b ); }
+		bool dominates( mblock_t* a, mblock_t* b ) const { return dominates( a->serial, b->serial ); }
+	};
+
+	// Dominance frontiers stored as a flat adjacency list.
+	//
+	struct dominance_frontier
+	{
+		std::vector<int> offsets;
+		std::vector<int> blocks;
+
+		dominance_frontier() = default;
+		dominance_frontier( mba_t* mba, const dominator_tree& dom )
+		{
+			std::vector<std::pair<int, int>> pairs;
+			for ( int b = 0; b != mba->qty; b++ )
+			{
+				mblock_t* blk = mba->get_mblock( b );
+				if ( !dom.reachable( b ) || blk->npred() < 2 )
+					continue;
+				for ( int p : blk->predset )
+				{
+					for ( int runner = p; dom.reachable( runner ) && runner != dom.idom[ b ]; runner = dom.idom[ runner ] )
+					{
+						pairs.emplace_back( runner, b );
+						if ( runner == dom.root )
+							break;
+					}
+				}
+			}
+			std::sort( pairs.begin(), pairs.end() );
+			pairs.erase( std::unique( pairs.begin(), pairs.end() ), pairs.end() );
+
+			offsets.assign( mba->qty + 1, 0 );
+			blocks.reserve( pairs.size() );
+			for ( auto& [from, to] : pairs )
+			{
+				offsets[ from + 1 ]++;
+				blocks.push_back( to );
+			}
+			for ( int i = 0; i != mba->qty; i++ )
+				offsets[ i + 1 ] += offsets[ i ];
+		}
+
+		std::span<const int> operator[]( int b ) const { return { blocks.data() + offsets[ b ], blocks.data() + offsets[ b + 1 ] }; }
+	};
+
+	// Natural loops grouped by header and nested into a forest, loops are sorted from outermost to innermost.
+	//
+	struct loop_forest
+	{
+		struct loop
+		{
+			int header;
+			int parent;                 // Index of the enclosing loop or -1.
+			int depth;                  // Nesting depth starting from 1.
+			std::vector<int> blocks;    // Sorted body including the header.
+			std::vector<int> latches;   // Sources of the back edges.
+
+			bool contains( int b ) const { return std::binary_search( blocks.begin(), blocks.end(), b ); }
+		};
+		std::vector<loop> loops;
+		std::vector<int> innermost;     // Innermost loop of each block or -1.
+
+		loop_forest() = default;
+		loop_forest( mba_t* mba, const dominator_tree& dom )
+		{
+			// Collect the back edges per header and walk the body backwards from the latches.
+			//
+			std::vector<int> header_loop( mba->qty, -1 );
+			for ( int b = 0; b != mba->qty; b++ )
+			{
+				if ( !dom.reachable( b ) )
+					continue;
+				for ( int s : mba->get_mblock( b )->succset )
+				{
+					if ( !dom.dominates( s, b ) )
+						continue;
+					if ( header_loop[ s ] < 0 )
+					{
+						header_loop[ s ] = ( int ) loops.size();
+						loops.push_back( { s, -1, 0, {}, {} } );
+					}
+					loops[ header_loop[ s ] ].latches.push_back( b );
+				}
+			}
+
+			std::vector<int> mark( mba->qty, -1 );
+			std::vector<int> stack;
+			for ( size_t i = 0; i != loops.size(); i++ )
+			{
+				loop& l = loops[ i ];
+				mark[ l.header ] = ( int ) i;
+				l.blocks.push_back( l.header );
+				for ( int latch : l.latches )
+				{
+					if ( mark[ latch ] != ( int ) i )
+					{
+						mark[ latch ] = ( int ) i;
+						stack.push_back( latch );
+					}
+				}
+				while ( !stack.empty() )
+				{
+					int b = stack.back();
+					stack.pop_back();
+					l.blocks.push_back( b );
+					for ( int p : mba->get_mblock( b )->predset )
+					{
+						if ( dom.reachable( p ) && mark[ p ] != ( int ) i )
+						{
+							mark[ p ] = ( int ) i;
+							stack.push_back( p );
+						}
+					}
+				}
+				std::sort( l.blocks.begin(), l.blocks.end() );
+			}
+
+			// Nest the loops, an enclosing loop is always larger than the loops it contains.
+			//
+			std::sort( loops.begin(), loops.end(), [ ] ( const loop& a, const loop& b ) { return a.blocks.size() > b.blocks.size(); } );
+			innermost.assign( mba->qty, -1 );
+			for ( size_t i = 0; i != loops.size(); i++ )
+			{
+				loop& l = loops[ i ];
+				l.parent = innermost[ l.header ];
+				l.depth = l.parent < 0 ? 1 : loops[ l.parent ].depth + 1;
+				for ( int b : l.blocks )
+					innermost[ b ] = ( int ) i;
+			}
+		}
+
+		const loop* loop_of( int b ) const { return innermost[ b ] < 0 ? nullptr : &loops[ innermost[ b ] ]; }
+		int depth_of( int b ) const { return innermost[ b ] < 0 ? 0 : loops[ innermost[ b ] ].depth; }
+	};
+
+	// Control flow analyses of an mba_t.
+	//
+	struct cfg_info
+	{
+		uint64_t fingerprint;
+		cfg_order order;
+		dominator_tree dom;
+		dominator_tree pdom;     // Rooted at the exit block, blocks that never reach it are unreachable.
+		dominance_frontier frontier;
+		loop_forest loops;
+
+		static uint64_t compute_fingerprint( mba_t* mba )
+		{
+			uint64_t h = detail::hash_mix( 0, ( uint64_t ) mba->qty );
+			for ( int b = 0; b != mba->qty; b++ )
+			{
+				mblock_t* blk = mba->get_mblock( b );
+				h = detail::hash_mix( h, ( uint64_t ) blk->nsucc() );
+				for ( int s : blk->succset )
+					h = detail::hash_mix( h, ( uint64_t ) s );
+			}
+			return h;
+		}
+
+		cfg_info( mba_t* mba ) : fingerprint( compute_fingerprint( mba ) ), order( mba )
+		{
+			dom = dominator_tree{ mba->qty, order.rpo, [ & ] ( int b ) -> const intvec_t& { return mba->get_mblock( b )->predset; } };
+			auto exit_rpo = detail::reverse_post_order( mba->qty, mba->qty - 1, [ & ] ( int b ) -> const intvec_t& { return mba->get_mblock( b )->predset; } );
+			pdom = dominator_tree{ mba->qty, exit_rpo, [ & ] ( int b ) -> const intvec_t& { return mba->get_mblock( b )->succset; } };
+			frontier = dominance_frontier{ mba, dom };
+			loops = loop_forest{ mba, dom };
+		}
+	};
+
+	// Cache of the analyses of recently used mba_t instances. Every lookup compares the CFG fingerprint, which is linear
+	// in the number of edges and cheap next to a rebuild, so edits made by optimizers in the middle of a phase are seen
+	// by the next lookup. Entries are dropped when Hex-Rays generates new microcode, since the mba_t may reuse a
+	// previous address. The analyses are shared so that they outlive their eviction from the cache.
+	//
+	// The cache subscribes to the event bus on the first lookup and stays subscribed until release() is called, which
+	// should be done when the plugin terminates.
+	//
+	struct cfg_cache
+	{
+		static constexpr size_t capacity = 8;
+
+		struct entry
+		{
+			mba_t* mba = nullptr;
+			uint64_t stamp = 0;
+			std::shared_ptr<const cfg_info> info;
+		};
+		std::array<entry, capacity> entries = {};
+		uint64_t clock = 0;
+		bool subscribed = false;
+
+		static cfg_cache& instance() { static cfg_cache cache = {}; return cache; }
+
+		std::shared_ptr<const cfg_info> get( mba_t* mba )
+		{
+			if ( !subscribed )
+			{
+				event_bus::instance().subscribe( hxe_microcode, { 0, &detail::decode_args<std::tuple<mba_t*>>, &on_microcode, this } );
+				subscribed = true;
+			}
+
+			uint64_t fingerprint = cfg_info::compute_fingerprint( mba );
+			entry* victim = &entries[ 0 ];
+			for ( entry& e : entries )
+			{
+				if ( e.mba == mba && e.info )
+				{
+					if ( e.info->fingerprint == fingerprint )
+					{
+						e.stamp = ++clock;
+						return e.info;
+					}
+					victim = &e;
+					break;
+				}
+				if ( e.stamp < victim->stamp )
+					victim = &e;
+			}
+			victim->mba = mba;
+			victim->stamp = ++clock;
+			victim->info = std::make_shared<const cfg_info>( mba );
+			return victim->info;
+		}
+		void invalidate( mba_t* mba )
+		{
+			for ( entry& e : entries )
+				if ( e.mba == mba )
+					e = {};
+		}
+
+		// Drops every entry and unsubscribes from the event bus, the next lookup subscribes again.
+		//
+		void release()
+		{
+			entries = {};
+			if ( std::exchange( subscribed, false ) )
+				event_bus::instance().unsubscribe( hxe_microcode, this );
+		}
+
+		static ssize_t on_microcode( void* ctx, const void* args )
+		{
+			( ( cfg_cache* ) ctx )->invalidate( std::get<0>( *( const std::tuple<mba_t*>* ) args ) );
+			return 0;
+		}
+	};
+
+	// Returns the cached control flow analyses of the mba_t, recomputing them if its CFG changed. The cache is released
+	// with release_cfg_analysis(), which unsubscribes it from the event bus.
+	//
+	inline std::shared_ptr<const cfg_info> cfg_analysis( mba_t* mba ) { return cfg_cache::instance().get( mba ); }
+	inline void invalidate_cfg_analysis( mba_t* mba ) { cfg_cache::instance().invalidate( mba ); }
+	inline void release_cfg_analysis() { cfg_cache::instance().release(); }
+};
\ No newline at end of file
@@ -0,0 +1,296 @@
+#pragma once
+#include <array>
+#include <span>
+#include <vector>
+#include <random>
+#include <bit>
+#include <algorithm>
+#include <type_traits>
+#include "ida.hpp"
+#include "opcodes.hpp"
+
+// Concrete evaluation of integer microcode expressions.
+//
+namespace hex
+{
+	namespace detail
+	{
+		// Single compiled operation, operands and the destination are slot indices.
+		//
+		struct eval_op
+		{
+			using kernel_t = void( * )( uint64_t* d, const uint64_t* a, const uint64_t* b, size_t n, const eval_op& op );
+
+			kernel_t kernel;
+			uint16_t a;
+			uint16_t b;
+			uint16_t d;
+			uint8_t shift;       // Shift applied by m_high.
+			uint64_t mask;       // Mask of the destination width.
+		};
+
+		template<mcode_t Op, typename T>
+		inline uint64_t eval_compute( uint64_t a, uint64_t b, uint8_t shift )
+		{
+			using S = std::make_signed_t<T>;
+			constexpr uint64_t bits = sizeof( T ) * 8;
+			T x = ( T ) a, y = ( T ) b;
+			S sx = ( S ) x, sy = ( S ) y;
+
+			if constexpr ( Op == m_mov || Op == m_ldc || Op == m_xdu || Op == m_low ) return x;
+			else if constexpr ( Op == m_xds )   return ( uint64_t ) ( int64_t ) sx;
+			else if constexpr ( Op == m_high )  return a >> shift;
+			else if constexpr ( Op == m_neg )   return ( T ) ( 0 - ( uint64_t ) x );
+			else if constexpr ( Op == m_bnot )  return ( T ) ~x;
+			else if constexpr ( Op == m_lnot )  return x == 0;
+			else if constexpr ( Op == m_add )   return ( T ) ( ( uint64_t ) x + y );
+			else if constexpr ( Op == m_sub )   return ( T ) ( ( uint64_t ) x - y );
+			else if constexpr ( Op == m_mul )   return ( T ) ( ( uint64_t ) x * y );
+			else if constexpr ( Op == m_udiv )  return y ? x / y : 0;
+			else if constexpr ( Op == m_umod )  return y ? x % y : 0;
+			else if constexpr ( Op == m_sdiv )  return ( T ) ( sy == 0 ? 0 : sy == -1 ? ( 0 - ( uint64_t ) x ) : ( uint64_t ) ( sx / sy ) );
+			else if constexpr ( Op == m_smod )  return ( T ) ( sy == 0 || sy == -1 ? 0 : ( uint64_t ) ( sx % sy ) );
+			else if constexpr ( Op == m_or )    return x | y;
+			else if constexpr ( Op == m_and )   return x & y;
+			else if constexpr ( Op == m_xor )   return x ^ y;
+			else if constexpr ( Op == m_shl )   return b >= bits ? 0 : ( T ) ( ( uint64_t ) x << b );
+			else if constexpr ( Op == m_shr )   return b >= bits ? 0 : x >> b;
+			else if constexpr ( Op == m_sar )   return ( T ) ( b >= bits ? ( sx < 0 ? -1 : 0 ) : sx >> b );
+			else if constexpr ( Op == m_cfadd ) return ( T ) ( x + y ) < x;
+			else if constexpr ( Op == m_ofadd ) return ( ( ~( sx ^ sy ) & ( sx ^ ( S ) ( T ) ( x + y ) ) ) < 0 );
+			else if constexpr ( Op == m_sets )  return sx < 0;
+			else if constexpr ( Op == m_seto )  return ( ( ( sx ^ sy ) & ( sx ^ ( S ) ( T ) ( x - y ) ) ) < 0 );
+			else if constexpr ( Op == m_setp )  return ( std::popcount( ( uint8_t ) ( x - y ) ) & 1 ) == 0;   // Even parity of the low byte.
+			else if constexpr ( Op == m_setnz ) return x != y;
+			else if constexpr ( Op == m_setz )  return x == y;
+			else if constexpr ( Op == m_setae ) return x >= y;
+			else if constexpr ( Op == m_setb )  return x < y;
+			else if constexpr ( Op == m_seta )  return x > y;
+			else if constexpr ( Op == m_setbe ) return x <= y;
+			else if constexpr ( Op == m_setg )  return sx > sy;
+			else if constexpr ( Op == m_setge ) return sx >= sy;
+			else if constexpr ( Op == m_setl )  return sx < sy;
+			else if constexpr ( Op == m_setle ) return sx <= sy;
+			else static_assert( Op == m_nop, "Unsupported opcode." );
+		}
+
+		// Kernels are specialized per opcode and operand width and written as straight loops over the lanes so that the
+		// compiler can vectorize them.
+		//
+		template<mcode_t Op, typename T>
+		inline void eval_kernel( uint64_t* d, const uint64_t* a, const uint64_t* b, size_t n, const eval_op& op )
+		{
+			const uint64_t mask = op.mask;
+			const uint8_t shift = op.shift;
+			for ( size_t i = 0; i != n; i++ )
+				d[ i ] = eval_compute<Op, T>( a[ i ], b[ i ], shift ) & mask;
+		}
+
+		template<mcode_t... Ops>
+		inline constexpr auto make_eval_kernels()
+		{
+			std::array<std::array<eval_op::kernel_t, 4>, 256> table = {};
+			( ( table[ Ops ] = { &eval_kernel<Ops, uint8_t>, &eval_kernel<Ops, uint16_t>, &eval_kernel<Ops, uint32_t>, &eval_kernel<Ops, uint64_t> } ), ... );
+			return table;
+		}
+		inline constexpr auto eval_kernels = make_eval_kernels<
+			m_mov, m_ldc, m_neg, m_lnot, m_bnot, m_xds, m_xdu, m_low, m_high,
+			m_add, m_sub, m_mul, m_udiv, m_sdiv, m_umod, m_smod, m_or, m_and, m_xor, m_shl, m_shr, m_sar, m_cfadd, m_ofadd,
+			m_sets, m_seto, m_setp, m_setnz, m_setz, m_setae, m_setb, m_seta, m_setbe, m_setg, m_setge, m_setl, m_setle
+		>();
+
+		inline int width_index( int size )
+		{
+			switch ( size )
+			{
+				case 1:  return 0;
+				case 2:  return 1;
+				case 4:  return 2;
+				case 8:  return 3;
+				default: return -1;
+			}
+		}
+		inline uint64_t width_mask( int size ) { return size >= 8 ? ~0ull : ( 1ull << ( size * 8 ) ) - 1; }
+	};
+
+	// Evaluator:
+	//  Compiles an integer instruction tree into a flat program over value slots, where every operand that is not a
+	//  constant or a sub-instruction becomes an input (equal operands share an input). Programs are evaluated over
+	//  batches of input vectors stored as columns, one column per input.
+	//
+	struct evaluator
+	{
+		static constexpr size_t lanes = 64;
+
+		std::vector<detail::eval_op> program;
+		std::vector<mop_t> inputs;                                 // Slots [0, inputs.size()).
+		std::vector<std::pair<uint16_t, uint64_t>> constants;     // Slots following the inputs.
+		size_t slot_count = 0;
+		uint16_t result = 0;
+		int result_size = 0;
+		bool valid = false;
+
+		evaluator() = default;
+		evaluator( const minsn_t* ins )
+		{
+			// Collect the inputs first so that their slots are contiguous.
+			//
+			auto collect = [ & ] ( auto& self, const minsn_t* i ) -> void
+			{
+				for ( const mop_t* op : { &i->l, &i->r } )
+				{
+					if ( op->t == mop_d )
+						self( self, op->d );
+					else if ( op->t != mop_z && op->t != mop_n && input_index( *op ) < 0 )
+						inputs.push_back( *op );
+				}
+			};
+			collect( collect, ins );
+			slot_count = inputs.size();
+
+			int r = compile( ins, ins->d.size );
+			valid = r >= 0;
+			result = ( uint16_t ) std::max( r, 0 );
+			result_size = ins->d.size;
+		}
+
+		int input_index( const mop_t& op ) const
+		{
+			for ( size_t i = 0; i != inputs.size(); i++ )
+				if ( inputs[ i ].equal_mops( op, 0 ) )
+					return ( int ) i;
+			return -1;
+		}
+
+		// Compiles the operand or instruction returning its slot or -1 if it is not supported.
+		//
+		int operand( const mop_t& op )
+		{
+			if ( op.t == mop_d )
+				return compile( op.d, op.size );
+			if ( op.t == mop_n )
+			{
+				constants.emplace_back( ( uint16_t ) slot_count, op.nnn->value & detail::width_mask( op.size ) );
+				return ( int ) slot_count++;
+			}
+			if ( op.t == mop_z )
+				return -1;
+			return input_index( op );
+		}
+		int compile( const minsn_t* ins, int size )
+		{
+			int w = detail::width_index( ins->l.size );
+			if ( w < 0 || detail::width_index( size ) < 0 )
+				return -1;
+			auto kernel = detail::eval_kernels[ ins->opcode ][ w ];
+			if ( !kernel )
+				return -1;
+
+			int a = operand( ins->l );
+			int b = uses_r( ins->opcode ) ? operand( ins->r ) : a;
+			if ( a < 0 || b < 0 )
+				return -1;
+
+			detail::eval_op op = {};
+			op.kernel = kernel;
+			op.a = ( uint16_t ) a;
+			op.b = ( uint16_t ) b;
+			op.d = ( uint16_t ) slot_count++;
+			op.mask = detail::width_mask( size );
+			op.shift = ( uint8_t ) ( ins->opcode == m_high ? ( ins->l.size - size ) * 8 : 0 );
+			program.push_back( op );
+			return op.d;
+		}
+
+		// Evaluates the program for count input vectors, columns[ i ] holds the values of input i for each vector and
+		// there must be a column per input. The slots live in a per-thread buffer reused across calls, every slot is
+		// written before it is read. Invalid programs and missing inputs produce zeroes.
+		//
+		void evaluate( std::span<const uint64_t* const> columns, uint64_t* out, size_t count ) const
+		{
+			if ( !valid || columns.size() < inputs.size() )
+				return void( std::fill_n( out, count, 0 ) );
+			thread_local std::vector<uint64_t> scratch = {};
+			if ( scratch.size() < slot_count * lanes )
+				scratch.resize( slot_count * lanes );
+			for ( auto& [slot, value] : constants )
+				std::fill_n( &scratch[ slot * lanes ], lanes, value );
+
+			for ( size_t base = 0; base < count; base += lanes )
+			{
+				size_t n = std::min( lanes, count - base );
+				for ( size_t i = 0; i != inputs.size(); i++ )
+				{
+					uint64_t mask = detail::width_mask( inputs[ i ].size );
+					for ( size_t j = 0; j != n; j++ )
+						scratch[ i * lanes + j ] = columns[ i ][ base + j ] & mask;
+				}
+				for ( const detail::eval_op& op : program )
+					op.kernel( &scratch[ op.d * lanes ], &scratch[ op.a * lanes ], &scratch[ op.b * lanes ], n, op );
+				std::copy_n( &scratch[ result * lanes ], n, out + base );
+			}
+		}
+		uint64_t evaluate( std::span<const uint64_t> values ) const
+		{
+			if ( !valid || values.size() < inputs.size() )
+				return 0;
+			thread_local std::vector<const uint64_t*> columns = {};
+			columns.resize( values.size() );
+			for ( size_t i = 0; i != values.size(); i++ )
+				columns[ i ] = &values[ i ];
+			uint64_t out = 0;
+			evaluate( columns, &out, 1 );
+			return out;
+		}
+
+		// Checks two expressions for equality on random inputs, inputs are matched between the expressions by operand.
+		//
+		static bool equivalent( const minsn_t* a, const minsn_t* b, size_t samples = 1024, uint64_t seed = 0x5EED )
+		{
+			evaluator ea{ a }, eb{ b };
+			if ( !ea.valid || !eb.valid || ea.result_size != eb.result_size )
+				return false;
+
+			// Random inputs biased towards edge values.
+			//
+			std::mt19937_64 rng{ seed };
+			auto generate = [ & ] ( std::vector<uint64_t>& column )
+			{
+				static constexpr uint64_t special[] = { 0, 1, ~0ull, 0x80ull, 0x8000ull, 0x80000000ull, 0x8000000000000000ull, 0x7FFFFFFFFFFFFFFFull };
+				column.resize( samples );
+				for ( uint64_t& v : column )
+				{
+					uint64_t r = rng();
+					v = ( r & 7 ) == 0 ? special[ ( r >> 3 ) & 7 ] : rng();
+				}
+			};
+			std::vector<std::vector<uint64_t>> data( ea.inputs.size() );
+			std::vector<const uint64_t*> ca, cb;
+			for ( auto& column : data )
+			{
+				generate( column );
+				ca.push_back( column.data() );
+			}
+			std::vector<std::vector<uint64_t>> extra;
+			extra.reserve( eb.inputs.size() );
+			for ( const mop_t& op : eb.inputs )
+			{
+				int i = ea.input_index( op );
+				if ( i >= 0 )
+				{
+					cb.push_back( ca[ i ] );
+				}
+				else
+				{
+					generate( extra.emplace_back() );
+					cb.push_back( extra.back().data() );
+				}
+			}
+
+			std::vector<uint64_t> ra( samples ), rb( samples );
+			ea.evaluate( ca, ra.data(), samples );
+			eb.evaluate( cb, rb.data(), samples );
+			return ra == rb;
+		}
+	};
+};
\ No newline at end of file
@@ -0,0 +1,215 @@
+#pragma once
+#include <array>
+#include <vector>
+#include <tuple>
+#include <algorithm>
+#include <new>
+#include "ida.hpp"
+#include "components.hpp"
+
+// Multiplexed Hex-Rays event bus.
+//
+namespace hex
+{
+	// Decoder of the variadic arguments of an event into a tuple, shared by every subscriber expecting the same argument
+	// types so that the bus decodes them once.
+	//
+	namespace detail
+	{
+		template<typename Tuple>
+		inline void decode_args( va_list va, void* out ) { new ( out ) Tuple( fill_from( va, std::type_identity<Tuple>{} ) ); }
+	};
+
+	// Single hexrays callback routing each event to a per-event list of typed subscribers, ordered by priority. The
+	// variadic arguments are decoded once per event (per distinct argument signature) rather than once per subscriber.
+	//
+	struct event_bus
+	{
+		using decoder_t = void( * )( va_list va, void* out );
+		using handler_t = ssize_t( * )( void* ctx, const void* args );
+
+		// Maximum size of a decoded argument tuple and the number of distinct signatures cached per event.
+		//
+		static constexpr size_t max_args_size = 64;
+		static constexpr size_t max_decoded = 4;
+
+		struct subscriber
+		{
+			int priority;
+			decoder_t decoder;
+			handler_t handler;
+			void* ctx;
+		};
+		struct pending_subscription
+		{
+			hexrays_event_t evt;
+			subscriber sub;
+		};
+
+		std::array<std::vector<subscriber>, 256> table = {};
+		std::vector<pending_subscription> pending = {};
+		size_t count = 0;
+		int depth = 0;
+		bool tombstones = false;
+
+		static event_bus& instance() { static event_bus bus = {}; return bus; }
+
+		// Subscription management. Subscriptions made during dispatch are deferred until the outermost dispatch returns,
+		// removed subscribers are tombstoned immediately so that the running dispatch no longer invokes them.
+		//
+		void subscribe( hexrays_event_t evt, const subscriber& sub )
+		{
+			if ( depth )
+				return pending.push_back( { evt, sub } );
+
+			auto& list = table[ ( size_t ) evt ];
+			auto it = std::find_if( list.begin(), list.end(), [ & ] ( const subscriber& s ) { return s.priority < sub.priority; } );
+			list.insert( it, sub );
+			if ( !count++ )
+				install_hexrays_callback( &callback, this );
+		}
+		void unsubscribe( hexrays_event_t evt, void* ctx )
+		{
+			if ( depth )
+			{
+				auto p = std::find_if( pending.begin(), pending.end(), [ & ] ( const pending_subscription& s ) { return s.evt == evt && s.sub.ctx == ctx; } );
+				if ( p != pending.end() )
+					return void( pending.erase( p ) );
+			}
+
+			auto& list = table[ ( size_t ) evt ];
+			auto it = std::find_if( list.begin(), list.end(), [ & ] ( const subscriber& s ) { return s.ctx == ctx && s.handler; } );
+			if ( it == list.end() )
+				return;
+			if ( depth )
+			{
+				it->handler = nullptr;
+				tombstones = true;
+				return;
+			}
+			list.erase( it );
+			if ( !--count )
+				remove_hexrays_callback( &callback, this );
+		}
+		void settle()
+		{
+			if ( std::exchange( tombstones, false ) )
+			{
+				size_t removed = 0;
+				for ( auto& list : table )
+					removed += std::erase_if( list, [ ] ( const subscriber& s ) { return !s.handler; } );
+				if ( removed && !( count -= removed ) )
+					remove_hexrays_callback( &callback, this );
+			}
+			for ( auto& p : std::exchange( pending, {} ) )
+				subscribe( p.evt, p.sub );
+		}
+
+		// Dispatches the event, stopping at the first subscriber returning a non-zero value.
+		//
+		static ssize_t callback( void* ud, hexrays_event_t evt, va_list va )
+		{
+			auto* bus = ( event_bus* ) ud;
+			if ( ( size_t ) evt >= bus->table.size() )
+				return 0;
+			auto& list = bus->table[ ( size_t ) evt ];
+			if ( list.empty() )
+				return 0;
+
+			struct decoded
+			{
+				decoder_t decoder;
+				alignas( std::max_align_t ) uint8_t data[ max_args_size ];
+			};
+			decoded cache[ max_decoded ];
+			size_t cache_count = 0;
+
+			bus->depth++;
+			ssize_t result = 0;
+			for ( const subscriber& sub : list )
+			{
+				if ( !sub.handler )
+					continue;
+
+				// Find or decode the arguments for this signature.
+				//
+				decoded* args = nullptr;
+				for ( size_t i = 0; i != cache_count; i++ )
+				{
+					if ( cache[ i ].decoder == sub.decoder )
+					{
+						args = &cache[ i ];
+						break;
+					}
+				}
+				if ( !args )
+				{
+					args = &cache[ cache_count < max_decoded ? cache_count++ : max_decoded - 1 ];
+					args->decoder = sub.decoder;
+					va_list copy;
+					va_copy( copy, va );
+					sub.decoder( copy, args->data );
+					va_end( copy );
+				}
+
+				if ( ( result = sub.handler( sub.ctx, args->data ) ) )
+					break;
+			}
+			if ( !--bus->depth && ( bus->tombstones || !bus->pending.empty() ) )
+				bus->settle();
+			return result;
+		}
+	};
+
+	// Event listener subscribing a typed functor to the bus.
+	//
+	template<hexrays_event_t Evt, typename F>
+	struct event_listener : component
+	{
+		using args = typename detail::clambda_args<decltype( &std::remove_cvref_t<F>::operator() )>::type;
+		static_assert( sizeof( args ) <= event_bus::max_args_size, "Event argument tuple is too large." );
+		static_assert( std::is_trivially_destructible_v<args>, "Event arguments must be trivially destructible." );
+
+		F functor;
+		int priority;
+		component_stats stats;
+		bool installed = false;
+		event_listener( F&& functor, int priority = 0 ) : functor( std::forward<F>( functor ) ), priority( priority ) {}
+		event_listener& named( const char* name ) { stats.set_name( name ); return *this; }
+		component_stats* statistics() override { return &stats; }
+
+		static ssize_t invoke( void* ctx, const void* a )
+		{
+			auto& self = *( event_listener* ) ctx;
+			return profile( self.stats, [ & ] () -> ssize_t
+			{
+				if constexpr ( std::is_void_v<decltype( std::apply( self.functor, *( const args* ) a ) )> )
+					return std::apply( self.functor, *( const args* ) a ), 0;
+				else
+					return std::apply( self.functor, *( const args* ) a );
+			} );
+		}
+		void set_state( bool enable ) override
+		{
+			if ( std::exchange( installed, enable ) == enable )
+				return;
+			auto& bus = event_bus::instance();
+			enable ? bus.subscribe( Evt, { priority, &detail::decode_args<args>, &invoke, this } ) : bus.unsubscribe( Evt, this );
+		}
+	};
+
+	namespace detail
+	{
+		template<hexrays_event_t Evt>
+		struct event_listener_gen
+		{
+			template<typename F>
+			inline constexpr auto operator()( F&& func, int priority = 0 ) const
+			{
+				return hex::event_listener<Evt, F>( std::forward<F>( func ), priority );
+			}
+		};
+	};
+	template<hexrays_event_t Evt>
+	constexpr detail::event_listener_gen<Evt> event_listener_for = {};
+};
\ No newline at end of file
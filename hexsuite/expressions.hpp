@@ -0,0 +1,238 @@
+#pragma once
+#include <memory>
+#include <concepts>
+#include "ida.hpp"
+#include "architecture.hpp"
+
+// Expression templates building nested microcode instruction trees in a single pass.
+//
+namespace hex
+{
+	namespace detail
+	{
+		struct expr_tag {};
+	};
+	template<typename T>
+	concept Expression = std::is_base_of_v<detail::expr_tag, std::remove_cvref_t<T>>;
+
+	// Leaves, a static width of zero means the width is only known at runtime. Operand leaves reference the operand
+	// which is copied into the tree when it is built, so it should outlive the expression.
+	//
+	template<int W = 0>
+	struct mop_expr : detail::expr_tag
+	{
+		static constexpr int static_width = W;
+		const mop_t* op;
+
+		int width() const { return W ? W : op->size; }
+		void emit( ea_t, mop_t& out ) const { out.assign( *op ); }
+	};
+	template<int W = 0>
+	struct reg_expr : detail::expr_tag
+	{
+		static constexpr int static_width = W;
+		mreg_t r;
+		int w;
+
+		int width() const { return W ? W : w; }
+		void emit( ea_t, mop_t& out ) const { out.make_reg( r, width() ); }
+	};
+	template<int W = 0>
+	struct imm_expr : detail::expr_tag
+	{
+		static constexpr int static_width = W;
+		uint64_t value;
+		int w;
+
+		int width() const { return W ? W : w; }
+		void emit( ea_t, mop_t& out ) const { out.make_number( value, width() ); }
+	};
+
+	inline mop_expr<> x( const mop_t& op ) { return { {}, &op }; }
+	template<int W> inline mop_expr<W> x( const mop_t& op ) { return { {}, &op }; }
+	inline reg_expr<> x( reg r ) { return { {}, r.r, r.width }; }
+	template<int W> inline reg_expr<W> x( reg r ) { return { {}, r.r, W }; }
+	inline imm_expr<> imm( uint64_t value, int width ) { return { {}, value, width }; }
+	template<int W> inline imm_expr<W> imm( uint64_t value ) { return { {}, value, W }; }
+
+	// Instruction nodes.
+	//
+	namespace detail
+	{
+		template<typename E>
+		inline void emit_nested( ea_t ea, const E& e, mop_t& out )
+		{
+			if constexpr ( requires { e.emit_insn( ea, ( minsn_t* ) nullptr ); } )
+			{
+				minsn_t* ins = new minsn_t( ea );
+				e.emit_insn( ea, ins );
+				ins->d.size = e.width();
+				out.make_insn( ins );
+				out.size = ins->d.size;
+			}
+			else
+			{
+				e.emit( ea, out );
+			}
+		}
+	};
+
+	template<mcode_t Op, Expression L, Expression R>
+	struct binary_expr : detail::expr_tag
+	{
+		static constexpr bool is_shift = Op == m_shl || Op == m_shr || Op == m_sar;
+		static constexpr bool is_compare = Op >= m_seto && Op <= m_setle;
+		static_assert( is_shift || !L::static_width || !R::static_width || L::static_width == R::static_width, "Operand width mismatch." );
+		static constexpr int static_width = is_compare ? 1 : ( L::static_width || is_shift ? L::static_width : R::static_width );
+
+		L l;
+		R r;
+
+		int width() const
+		{
+			if constexpr ( is_compare )
+				return 1;
+			else
+				return l.width();
+		}
+		void emit_insn( ea_t ea, minsn_t* ins ) const
+		{
+			ins->opcode = Op;
+			detail::emit_nested( ea, l, ins->l );
+			detail::emit_nested( ea, r, ins->r );
+		}
+	};
+	template<mcode_t Op, int W, Expression E>
+	struct unary_expr : detail::expr_tag
+	{
+		static constexpr bool is_extend = Op == m_xdu || Op == m_xds;
+		static constexpr bool is_truncate = Op == m_low || Op == m_high;
+		static_assert( !is_extend || !W || !E::static_width || W > E::static_width, "Extension must widen the operand." );
+		static_assert( !is_truncate || !W || !E::static_width || W < E::static_width, "Truncation must narrow the operand." );
+		static constexpr int static_width = ( is_extend || is_truncate ) ? W : ( Op == m_lnot || Op == m_sets ) ? 1 : E::static_width;
+
+		E e;
+		int w;
+
+		int width() const
+		{
+			if constexpr ( static_width != 0 )
+				return static_width;
+			else if constexpr ( is_extend || is_truncate )
+				return w;
+			else
+				return e.width();
+		}
+		void emit_insn( ea_t ea, minsn_t* ins ) const
+		{
+			ins->opcode = Op;
+			detail::emit_nested( ea, e, ins->l );
+		}
+	};
+
+	// Generic constructors for any opcode, constants are converted to immediates of the width of the other operand
+	// except for shift counts which are always a single byte. The value of a shift has no other operand to take its
+	// width from so it must be an expression, e.g. hex::imm<4>( 1 ) << count.
+	//
+	namespace detail
+	{
+		template<typename T, typename O>
+		inline auto lift( T&& v, const O& other )
+		{
+			if constexpr ( Expression<T> )
+				return std::forward<T>( v );
+			else
+				return imm_expr<O::static_width>{ {}, ( uint64_t ) v, other.width() };
+		}
+		template<typename T>
+		inline auto lift_count( T&& v )
+		{
+			if constexpr ( Expression<T> )
+				return std::forward<T>( v );
+			else
+				return imm_expr<1>{ {}, ( uint64_t ) v, 1 };
+		}
+		template<typename T>
+		concept Operand = Expression<T> || std::integral<std::remove_cvref_t<T>>;
+		template<mcode_t Op, typename L, typename R>
+		concept BinaryOperands = Operand<L> && Operand<R> && ( Expression<L> || ( Expression<R> && Op != m_shl && Op != m_shr && Op != m_sar ) );
+	};
+	template<mcode_t Op, typename L, typename R> requires detail::BinaryOperands<Op, L, R>
+	inline auto binary( L&& l, R&& r )
+	{
+		if constexpr ( Expression<L> )
+		{
+			auto rhs = [ & ] ()
+			{
+				if constexpr ( Op == m_shl || Op == m_shr || Op == m_sar )
+					return detail::lift_count( std::forward<R>( r ) );
+				else
+					return detail::lift( std::forward<R>( r ), l );
+			}( );
+			return binary_expr<Op, std::remove_cvref_t<L>, decltype( rhs )>{ {}, std::forward<L>( l ), std::move( rhs ) };
+		}
+		else
+		{
+			auto lhs = detail::lift( std::forward<L>( l ), r );
+			return binary_expr<Op, decltype( lhs ), std::remove_cvref_t<R>>{ {}, std::move( lhs ), std::forward<R>( r ) };
+		}
+	}
+	template<mcode_t Op, int W = 0, Expression E>
+	inline auto unary( E&& e, int width = W ) { return unary_expr<Op, W, std::remove_cvref_t<E>>{ {}, std::forward<E>( e ), width }; }
+
+	// Operators.
+	//
+#define __decl_binary(tok, opc) template<typename L, typename R> requires detail::BinaryOperands<opc, L, R> inline auto operator tok( L&& l, R&& r ) { return binary<opc>( std::forward<L>( l ), std::forward<R>( r ) ); }
+#define __decl_unary(tok, opc)  template<Expression E> inline auto operator tok( E&& e ) { return unary<opc>( std::forward<E>( e ) ); }
+	__decl_binary( +, m_add );
+	__decl_binary( -, m_sub );
+	__decl_binary( *, m_mul );
+	__decl_binary( &, m_and );
+	__decl_binary( |, m_or );
+	__decl_binary( ^, m_xor );
+	__decl_binary( <<, m_shl );
+	__decl_binary( >>, m_shr );
+	__decl_binary( ==, m_setz );
+	__decl_binary( !=, m_setnz );
+	__decl_unary( -, m_neg );
+	__decl_unary( ~, m_bnot );
+	__decl_unary( !, m_lnot );
+#undef __decl_binary
+#undef __decl_unary
+
+	// Width changing helpers.
+	//
+	template<int W, Expression E> inline auto xdu( E&& e ) { return unary<m_xdu, W>( std::forward<E>( e ) ); }
+	template<int W, Expression E> inline auto xds( E&& e ) { return unary<m_xds, W>( std::forward<E>( e ) ); }
+	template<int W, Expression E> inline auto low( E&& e ) { return unary<m_low, W>( std::forward<E>( e ) ); }
+	template<int W, Expression E> inline auto high( E&& e ) { return unary<m_high, W>( std::forward<E>( e ) ); }
+
+	// Materializes the expression as a single instruction tree writing into the destination, a leaf expression becomes
+	// a move. Each node is constructed directly in its parent operand without intermediate operands.
+	//
+	template<Expression E>
+	inline std::unique_ptr<minsn_t> build( ea_t ea, const E& e, operand d = {} )
+	{
+		auto ins = std::make_unique<minsn_t>( ea );
+		if constexpr ( requires { e.emit_insn( ea, ins.get() ); } )
+		{
+			e.emit_insn( ea, ins.get() );
+		}
+		else
+		{
+			ins->opcode = m_mov;
+			e.emit( ea, ins->l );
+		}
+		if ( d.t == mop_z )
+			d.size = e.width();
+		ins->d.swap( d );
+		return ins;
+	}
+	template<Expression E>
+	inline operand build_operand( ea_t ea, const E& e )
+	{
+		operand result = {};
+		detail::emit_nested( ea, e, result );
+		return result;
+	}
+};
\ No newline at end of file
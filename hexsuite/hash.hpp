@@ -0,0 +1,201 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include <bit>
+#include <algorithm>
+#include "ida.hpp"
+
+// Structural hashing of microcode.
+//
+namespace hex
+{
+	namespace detail
+	{
+		constexpr uint64_t hash_mix( uint64_t h, uint64_t v )
+		{
+			v *= 0x9E3779B97F4A7C15ull;
+			v ^= v >> 32;
+			h ^= v + 0x9E3779B97F4A7C15ull + ( h << 6 ) + ( h >> 2 );
+			return h;
+		}
+		inline uint64_t hash_string( const char* s )
+		{
+			uint64_t h = 0xCBF29CE484222325ull;
+			if ( s )
+				for ( ; *s; s++ )
+					h = ( h ^ ( uint8_t ) *s ) * 0x100000001B3ull;
+			return h;
+		}
+	};
+
+	// Hashes are independent of instruction addresses. Node hashes are composed from the hashes of the operands so
+	// that a rewritten operand only requires the path to the root to be recomputed.
+	//
+	inline uint64_t hash_mop( const mop_t& op );
+	inline uint64_t hash_node( mcode_t opcode, uint64_t l, uint64_t r, uint64_t d )
+	{
+		uint64_t h = detail::hash_mix( 0x2545F4914F6CDD1Dull, opcode );
+		h = detail::hash_mix( h, l );
+		h = detail::hash_mix( h, r );
+		return detail::hash_mix( h, d );
+	}
+	inline uint64_t hash_insn( const minsn_t& ins ) { return hash_node( ins.opcode, hash_mop( ins.l ), hash_mop( ins.r ), hash_mop( ins.d ) ); }
+	inline uint64_t hash_mop( const mop_t& op )
+	{
+		uint64_t h = detail::hash_mix( op.t, ( uint32_t ) op.size );
+		switch ( op.t )
+		{
+			case mop_r:   return detail::hash_mix( h, ( uint64_t ) op.r );
+			case mop_n:   return detail::hash_mix( h, op.nnn->value );
+			case mop_str: return detail::hash_mix( h, detail::hash_string( op.cstr ) );
+			case mop_d:   return detail::hash_mix( h, hash_insn( *op.d ) );
+			case mop_S:   return detail::hash_mix( h, ( uint64_t ) op.s->off );
+			case mop_v:   return detail::hash_mix( h, op.g );
+			case mop_b:   return detail::hash_mix( h, ( uint64_t ) op.b );
+			case mop_l:   return detail::hash_mix( detail::hash_mix( h, ( uint64_t ) op.l->idx ), ( uint64_t ) op.l->off );
+			case mop_a:   return detail::hash_mix( h, hash_mop( *op.a ) );
+			case mop_h:   return detail::hash_mix( h, detail::hash_string( op.helper ) );
+			case mop_p:   return detail::hash_mix( detail::hash_mix( h, hash_mop( op.pair->lop ) ), hash_mop( op.pair->hop ) );
+			case mop_fn:
+				for ( uint16_t w : op.fpc->fnum )
+					h = detail::hash_mix( h, w );
+				return h;
+			case mop_f:
+				h = detail::hash_mix( h, op.f->callee );
+				for ( const mcallarg_t& arg : op.f->args )
+					h = detail::hash_mix( h, hash_mop( arg ) );
+				return h;
+			case mop_c:
+				for ( int target : op.c->targets )
+					h = detail::hash_mix( h, ( uint64_t ) target );
+				return h;
+			default:
+				return h;
+		}
+	}
+
+	// Hasher usable with unordered containers.
+	//
+	struct structural_hash
+	{
+		size_t operator()( const mop_t& op ) const { return ( size_t ) hash_mop( op ); }
+		size_t operator()( const minsn_t& ins ) const { return ( size_t ) hash_insn( ins ); }
+		size_t operator()( const minsn_t* ins ) const { return ( size_t ) hash_insn( *ins ); }
+	};
+
+	// Bounded memoization cache mapping an expression to its simplified form (or to the knowledge that it could not be
+	// simplified), keyed by structural hash and verified with equal_insns. Entries are kept in 4-way sets with least
+	// recently used replacement.
+	//
+	struct memo_cache
+	{
+		static constexpr size_t ways = 4;
+
+		struct entry
+		{
+			uint64_t hash = 0;
+			uint64_t stamp = 0;
+			std::unique_ptr<minsn_t> key;
+			std::unique_ptr<minsn_t> result;
+		};
+		struct statistics
+		{
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t insertions = 0;
+			uint64_t evictions = 0;
+			uint64_t collisions = 0;
+
+			double hit_rate() const { return ( hits + misses ) ? double( hits ) / double( hits + misses ) : 0.0; }
+		};
+
+		std::vector<entry> entries;
+		size_t set_mask;
+		uint64_t clock = 0;
+		int eqflags;
+		statistics stats = {};
+
+		memo_cache( size_t capacity = 4096, int eqflags = 0 ) : eqflags( eqflags )
+		{
+			size_t sets = std::bit_ceil( std::max<size_t>( capacity / ways, 1 ) );
+			entries.resize( sets * ways );
+			set_mask = sets - 1;
+		}
+
+		// Looks up the entry for the expression, returns null on a miss.
+		//
+		entry* find( const minsn_t& ins, uint64_t hash )
+		{
+			entry* set = &entries[ ( hash & set_mask ) * ways ];
+			for ( size_t i = 0; i != ways; i++ )
+			{
+				entry& e = set[ i ];
+				if ( !e.key || e.hash != hash )
+					continue;
+				if ( !e.key->equal_insns( ins, eqflags ) )
+				{
+					stats.collisions++;
+					continue;
+				}
+				e.stamp = ++clock;
+				stats.hits++;
+				return &e;
+			}
+			stats.misses++;
+			return nullptr;
+		}
+		entry* find( const minsn_t& ins ) { return find( ins, hash_insn( ins ) ); }
+
+		// Inserts the result of simplifying the expression, a null result records that no simplification exists.
+		//
+		entry& insert( const minsn_t& ins, uint64_t hash, std::unique_ptr<minsn_t> result )
+		{
+			entry* set = &entries[ ( hash & set_mask ) * ways ];
+			entry* victim = &set[ 0 ];
+			for ( size_t i = 0; i != ways; i++ )
+			{
+				if ( !set[ i ].key )
+				{
+					victim = &set[ i ];
+					break;
+				}
+				if ( set[ i ].stamp < victim->stamp )
+					victim = &set[ i ];
+			}
+			if ( victim->key )
+				stats.evictions++;
+			stats.insertions++;
+
+			victim->hash = hash;
+			victim->stamp = ++clock;
+			victim->key = std::make_unique<minsn_t>( ins );
+			victim->result = std::move( result );
+			return *victim;
+		}
+
+		// Replaces the instruction with its cached simplification, computing it via the functor on a miss. The functor
+		// returns the simplified instruction or null if there is none. Returns whether the instruction was replaced.
+		//
+		template<typename F>
+		bool simplify( minsn_t* ins, F&& functor )
+		{
+			uint64_t hash = hash_insn( *ins );
+			entry* e = find( *ins, hash );
+			if ( !e )
+				e = &insert( *ins, hash, functor( static_cast<const minsn_t*>( ins ) ) );
+			if ( !e->result )
+				return false;
+
+			minsn_t copy = *e->result;
+			copy.setaddr( ins->ea );
+			ins->swap( copy );
+			return true;
+		}
+
+		void clear()
+		{
+			for ( entry& e : entries )
+				e = {};
+		}
+	};
+};
\ No newline at end of file
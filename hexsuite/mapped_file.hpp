@@ -0,0 +1,186 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#ifdef _WIN32
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <unistd.h>
+	#include <sys/file.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+#endif
+
+// Portable shared memory mapping of files.
+//
+namespace hex
+{
+	// Maps a whole file into memory, writes are shared with every other process mapping the same file.
+	//
+	struct mapped_file
+	{
+		uint8_t* data = nullptr;
+		size_t size = 0;
+		bool read_only = false;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = nullptr;
+#else
+		int fd = -1;
+#endif
+
+		mapped_file() = default;
+		mapped_file( const mapped_file& ) = delete;
+		mapped_file& operator=( const mapped_file& ) = delete;
+		~mapped_file() { close(); }
+
+		bool is_open() const { return data != nullptr; }
+
+		// Opens the file, creating it if it does not exist and it is writable, grows it to at least min_size bytes
+		// and maps all of it.
+		//
+		bool open( const char* path, size_t min_size = 0, bool ro = false )
+		{
+			close();
+			read_only = ro;
+#ifdef _WIN32
+			file = CreateFileA( path, ro ? GENERIC_READ : GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+				nullptr, ro ? OPEN_EXISTING : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr );
+			if ( file == INVALID_HANDLE_VALUE )
+				return false;
+#else
+			fd = ::open( path, ro ? O_RDONLY : O_RDWR | O_CREAT, 0644 );
+			if ( fd < 0 )
+				return false;
+#endif
+			if ( !map( min_size ) )
+			{
+				close();
+				return false;
+			}
+			return true;
+		}
+
+		// Grows the file to at least new_size bytes and maps it again, any pointer into the old view is invalidated.
+		//
+		bool resize( size_t new_size )
+		{
+			unmap();
+			return map( new_size );
+		}
+
+		// Writes dirty pages back asynchronously.
+		//
+		void flush()
+		{
+			if ( !data || read_only )
+				return;
+#ifdef _WIN32
+			FlushViewOfFile( data, 0 );
+#else
+			msync( data, size, MS_ASYNC );
+#endif
+		}
+
+		// Advisory whole-file lock shared between processes.
+		//
+		bool lock( bool exclusive = true )
+		{
+#ifdef _WIN32
+			OVERLAPPED ov = {};
+			return LockFileEx( file, exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0, 0, MAXDWORD, MAXDWORD, &ov );
+#else
+			return flock( fd, exclusive ? LOCK_EX : LOCK_SH ) == 0;
+#endif
+		}
+		void unlock()
+		{
+#ifdef _WIN32
+			OVERLAPPED ov = {};
+			UnlockFileEx( file, 0, MAXDWORD, MAXDWORD, &ov );
+#else
+			flock( fd, LOCK_UN );
+#endif
+		}
+
+		void close()
+		{
+			unmap();
+#ifdef _WIN32
+			if ( file != INVALID_HANDLE_VALUE )
+				CloseHandle( file );
+			file = INVALID_HANDLE_VALUE;
+#else
+			if ( fd >= 0 )
+				::close( fd );
+			fd = -1;
+#endif
+		}
+
+		bool map( size_t min_size )
+		{
+#ifdef _WIN32
+			LARGE_INTEGER current = {};
+			if ( !GetFileSizeEx( file, &current ) )
+				return false;
+			size_t length = ( size_t ) current.QuadPart;
+			if ( length < min_size && !read_only )
+				length = min_size;
+			if ( !length )
+				return false;
+
+			// Creating a mapping larger than the file extends it.
+			//
+			mapping = CreateFileMappingA( file, nullptr, read_only ? PAGE_READONLY : PAGE_READWRITE, ( DWORD ) ( ( uint64_t ) length >> 32 ), ( DWORD ) length, nullptr );
+			if ( !mapping )
+				return false;
+			data = ( uint8_t* ) MapViewOfFile( mapping, read_only ? FILE_MAP_READ : FILE_MAP_WRITE, 0, 0, length );
+			if ( !data )
+			{
+				CloseHandle( mapping );
+				mapping = nullptr;
+				return false;
+			}
+#else
+			struct stat st = {};
+			if ( fstat( fd, &st ) != 0 )
+				return false;
+			size_t length = ( size_t ) st.st_size;
+			if ( length < min_size && !read_only )
+			{
+				if ( ftruncate( fd, ( off_t ) min_size ) != 0 )
+					return false;
+				length = min_size;
+			}
+			if ( !length )
+				return false;
+			void* view = mmap( nullptr, length, read_only ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+			if ( view == MAP_FAILED )
+				return false;
+			data = ( uint8_t* ) view;
+#endif
+			size = length;
+			return true;
+		}
+		void unmap()
+		{
+			if ( !data )
+				return;
+#ifdef _WIN32
+			UnmapViewOfFile( data );
+			CloseHandle( mapping );
+			mapping = nullptr;
+#else
+			munmap( data, size );
+#endif
+			data = nullptr;
+			size = 0;
+		}
+	};
+};
\ No newline at end of file
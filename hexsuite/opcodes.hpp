@@ -0,0 +1,166 @@
+#pragma once
+#include <array>
+#include "ida.hpp"
+
+// Compile-time opcode traits.
+//
+namespace hex
+{
+	enum opcode_flags : uint32_t
+	{
+		op_l =           1 << 0,   // Uses the left operand.
+		op_r =           1 << 1,   // Uses the right operand.
+		op_d =           1 << 2,   // Uses the destination operand.
+		op_commutative = 1 << 3,   // Left and right operands can be swapped.
+		op_jump =        1 << 4,   // Transfers control.
+		op_cond_jump =   1 << 5,   // Conditionally transfers control.
+		op_setcc =       1 << 6,   // Sets a byte from a condition.
+		op_flag =        1 << 7,   // Computes a carry or overflow flag.
+		op_float =       1 << 8,   // Floating point operation.
+		op_call =        1 << 9,   // Calls a function.
+		op_side_effects= 1 << 10,  // Has effects beyond writing the destination.
+		op_signed =      1 << 11,  // Signed comparison or arithmetic.
+	};
+
+	struct opcode_traits
+	{
+		uint32_t flags = 0;
+		mcode_t inverse = m_nop;   // Opcode with the negated condition.
+		mcode_t swapped = m_nop;   // Opcode with the same condition after swapping the left and right operands.
+		mcode_t partner = m_nop;   // Conditional jump of a setcc opcode or vice versa.
+
+		constexpr bool has( uint32_t f ) const { return ( flags & f ) == f; }
+		constexpr size_t operand_count() const { return ( ( flags & op_l ) != 0 ) + ( ( flags & op_r ) != 0 ) + ( ( flags & op_d ) != 0 ); }
+	};
+
+	// Table indexed by opcode, operand usage follows the layout documented next to the instruction constructors.
+	//
+	inline constexpr std::array<opcode_traits, 256> opcode_table = [ ] ()
+	{
+		std::array<opcode_traits, 256> t = {};
+		constexpr uint32_t ld = op_l | op_d, lrd = op_l | op_r | op_d;
+
+		t[ m_stx ].flags = lrd | op_side_effects;
+		t[ m_ldx ].flags = lrd;
+		for ( mcode_t op : { m_ldc, m_mov, m_neg, m_lnot, m_bnot, m_xds, m_xdu, m_low, m_high } )
+			t[ op ].flags = ld;
+		t[ m_xds ].flags |= op_signed;
+		for ( mcode_t op : { m_add, m_sub, m_mul, m_udiv, m_sdiv, m_umod, m_smod, m_or, m_and, m_xor, m_shl, m_shr, m_sar } )
+			t[ op ].flags = lrd;
+		for ( mcode_t op : { m_add, m_mul, m_or, m_and, m_xor } )
+			t[ op ].flags |= op_commutative;
+		for ( mcode_t op : { m_sdiv, m_smod, m_sar } )
+			t[ op ].flags |= op_signed;
+		for ( mcode_t op : { m_cfadd, m_ofadd, m_cfshl, m_cfshr } )
+			t[ op ].flags = lrd | op_flag;
+		t[ m_cfadd ].flags |= op_commutative;
+		t[ m_ofadd ].flags |= op_commutative;
+
+		// Conditions, setcc and conditional jumps share the same order.
+		//
+		t[ m_sets ].flags = ld | op_setcc | op_signed;
+		t[ m_jcnd ].flags = ld | op_jump | op_cond_jump;
+		for ( int i = 0; i <= m_setle - m_seto; i++ )
+		{
+			t[ m_seto + i ].flags = lrd | op_setcc;
+			if ( i >= m_setnz - m_seto )
+			{
+				mcode_t jcc = mcode_t( m_jnz + ( i - ( m_setnz - m_seto ) ) );
+				t[ jcc ].flags = lrd | op_jump | op_cond_jump;
+				t[ jcc ].partner = mcode_t( m_seto + i );
+				t[ m_seto + i ].partner = jcc;
+			}
+		}
+		for ( mcode_t op : { m_setnz, m_setz, m_jnz, m_jz } )
+			t[ op ].flags |= op_commutative;
+		for ( mcode_t op : { m_seto, m_setg, m_setge, m_setl, m_setle, m_jg, m_jge, m_jl, m_jle } )
+			t[ op ].flags |= op_signed;
+
+		auto pair = [ & ] ( mcode_t a, mcode_t b, mcode_t opcode_traits::* field )
+		{
+			t[ a ].*field = b;
+			t[ b ].*field = a;
+		};
+		pair( m_setnz, m_setz, &opcode_traits::inverse );
+		pair( m_setae, m_setb, &opcode_traits::inverse );
+		pair( m_seta, m_setbe, &opcode_traits::inverse );
+		pair( m_setg, m_setle, &opcode_traits::inverse );
+		pair( m_setge, m_setl, &opcode_traits::inverse );
+		pair( m_jnz, m_jz, &opcode_traits::inverse );
+		pair( m_jae, m_jb, &opcode_traits::inverse );
+		pair( m_ja, m_jbe, &opcode_traits::inverse );
+		pair( m_jg, m_jle, &opcode_traits::inverse );
+		pair( m_jge, m_jl, &opcode_traits::inverse );
+		pair( m_setae, m_setbe, &opcode_traits::swapped );
+		pair( m_setb, m_seta, &opcode_traits::swapped );
+		pair( m_setge, m_setle, &opcode_traits::swapped );
+		pair( m_setg, m_setl, &opcode_traits::swapped );
+		pair( m_jae, m_jbe, &opcode_traits::swapped );
+		pair( m_jb, m_ja, &opcode_traits::swapped );
+		pair( m_jge, m_jle, &opcode_traits::swapped );
+		pair( m_jg, m_jl, &opcode_traits::swapped );
+		for ( mcode_t op : { m_setnz, m_setz, m_jnz, m_jz } )
+			t[ op ].swapped = op;
+
+		// Control flow and calls.
+		//
+		t[ m_jtbl ].flags = op_l | op_r | op_jump;
+		t[ m_ijmp ].flags = op_r | op_d | op_jump;
+		t[ m_goto ].flags = op_l | op_jump;
+		t[ m_call ].flags = ld | op_call | op_side_effects;
+		t[ m_icall ].flags = lrd | op_call | op_side_effects;
+		t[ m_ret ].flags = op_side_effects;
+		t[ m_push ].flags = op_l | op_side_effects;
+		t[ m_pop ].flags = op_d | op_side_effects;
+		t[ m_und ].flags = op_d;
+		t[ m_ext ].flags = lrd | op_side_effects;
+
+		// Floating point.
+		//
+		for ( mcode_t op : { m_f2i, m_f2u, m_i2f, m_u2f, m_f2f, m_fneg } )
+			t[ op ].flags = ld | op_float;
+		for ( mcode_t op : { m_fadd, m_fsub, m_fmul, m_fdiv } )
+			t[ op ].flags = lrd | op_float;
+		t[ m_fadd ].flags |= op_commutative;
+		t[ m_fmul ].flags |= op_commutative;
+		return t;
+	}( );
+
+	// Predicates.
+	//
+	constexpr const opcode_traits& traits_of( mcode_t op ) { return opcode_table[ ( uint8_t ) op ]; }
+	constexpr bool is_commutative( mcode_t op ) { return traits_of( op ).has( op_commutative ); }
+	constexpr bool is_jump( mcode_t op ) { return traits_of( op ).has( op_jump ); }
+	constexpr bool is_cond_jump( mcode_t op ) { return traits_of( op ).has( op_cond_jump ); }
+	constexpr bool is_setcc( mcode_t op ) { return traits_of( op ).has( op_setcc ); }
+	constexpr bool is_flag_calc( mcode_t op ) { return traits_of( op ).has( op_flag ); }
+	constexpr bool is_float_op( mcode_t op ) { return traits_of( op ).has( op_float ); }
+	constexpr bool is_call( mcode_t op ) { return traits_of( op ).has( op_call ); }
+	constexpr bool has_side_effects( mcode_t op ) { return traits_of( op ).has( op_side_effects ); }
+	constexpr bool is_signed_op( mcode_t op ) { return traits_of( op ).has( op_signed ); }
+	constexpr bool uses_l( mcode_t op ) { return traits_of( op ).has( op_l ); }
+	constexpr bool uses_r( mcode_t op ) { return traits_of( op ).has( op_r ); }
+	constexpr bool uses_d( mcode_t op ) { return traits_of( op ).has( op_d ); }
+
+	// Mnemonics as printed by Hex-Rays, null for values that are not opcodes.
+	//
+	inline constexpr const char* opcode_names[] =
+	{
+		"nop", "stx", "ldx", "ldc", "mov", "neg", "lnot", "bnot", "xds", "xdu", "low", "high",
+		"add", "sub", "mul", "udiv", "sdiv", "umod", "smod", "or", "and", "xor", "shl", "shr", "sar",
+		"cfadd", "ofadd", "cfshl", "cfshr", "sets", "seto", "setp", "setnz", "setz", "setae", "setb", "seta", "setbe",
+		"setg", "setge", "setl", "setle", "jcnd", "jnz", "jz", "jae", "jb", "ja", "jbe", "jg", "jge", "jl", "jle",
+		"jtbl", "ijmp", "goto", "call", "icall", "ret", "push", "pop", "und", "ext",
+		"f2i", "f2u", "i2f", "u2f", "f2f", "fneg", "fadd", "fsub", "fmul", "fdiv"
+	};
+	static_assert( std::size( opcode_names ) == m_fdiv + 1, "Opcode name table is out of date." );
+	constexpr const char* opcode_name( mcode_t op ) { return ( size_t ) op < std::size( opcode_names ) ? opcode_names[ op ] : nullptr; }
+
+	// Condition transformations, returning m_nop if the opcode has no such counterpart.
+	//
+	constexpr mcode_t inverted_jump( mcode_t op ) { return is_cond_jump( op ) ? traits_of( op ).inverse : m_nop; }
+	constexpr mcode_t inverted_setcc( mcode_t op ) { return is_setcc( op ) ? traits_of( op ).inverse : m_nop; }
+	constexpr mcode_t swapped_condition( mcode_t op ) { return traits_of( op ).swapped; }
+	constexpr mcode_t setcc_to_jump( mcode_t op ) { return is_setcc( op ) ? traits_of( op ).partner : m_nop; }
+	constexpr mcode_t jump_to_setcc( mcode_t op ) { return is_cond_jump( op ) ? traits_of( op ).partner : m_nop; }
+};
\ No newline at end of file
@@ -0,0 +1,228 @@
+#pragma once
+#include <array>
+#include <tuple>
+#include <utility>
+#include "ida.hpp"
+#include "bitset.hpp"
+#include "components.hpp"
+#include "visitors.hpp"
+
+// Declarative microcode peephole rules.
+//
+namespace hex::pat
+{
+	// Captured operands of a match.
+	//
+	struct captures
+	{
+		static constexpr size_t max_count = 8;
+		std::array<mop_t*, max_count> ops = {};
+
+		mop_t& operator[]( size_t n ) const { return *ops[ n ]; }
+		bool has( size_t n ) const { return ops[ n ] != nullptr; }
+	};
+
+	// Operand patterns, each pattern declares the operand type and sub-instruction opcode it requires (or -1 for any)
+	// which the rule set uses to build its dispatch tables.
+	//
+	struct any
+	{
+		static constexpr int mop_type = -1;
+		static constexpr int sub_opcode = -1;
+		static bool match( mop_t&, captures& ) { return true; }
+	};
+	template<mopt_t T>
+	struct of
+	{
+		static constexpr int mop_type = T;
+		static constexpr int sub_opcode = -1;
+		static bool match( mop_t& op, captures& ) { return op.t == T; }
+	};
+	template<int64_t V>
+	struct num
+	{
+		static constexpr int mop_type = mop_n;
+		static constexpr int sub_opcode = -1;
+		static bool match( mop_t& op, captures& )
+		{
+			if ( op.t != mop_n )
+				return false;
+			uint64_t mask = op.size >= 8 ? ~0ull : ( ( 1ull << ( op.size * 8 ) ) - 1 );
+			return op.nnn->value == ( ( uint64_t ) V & mask );
+		}
+	};
+
+	// Captures the operand into the given slot if it matches the inner pattern, an operand bound to a slot that is
+	// already occupied must be equal to the previous one.
+	//
+	template<size_t N, typename P = any>
+	struct cap
+	{
+		static_assert( N < captures::max_count, "Capture index out of range." );
+		static constexpr int mop_type = P::mop_type;
+		static constexpr int sub_opcode = P::sub_opcode;
+		static bool match( mop_t& op, captures& c )
+		{
+			if ( c.ops[ N ] )
+				return c.ops[ N ]->equal_mops( op, 0 );
+			if ( !P::match( op, c ) )
+				return false;
+			c.ops[ N ] = &op;
+			return true;
+		}
+	};
+
+	// Instruction pattern, used both for the root of a rule and for sub-instructions.
+	//
+	template<mcode_t Op, typename L = any, typename R = any, typename D = any>
+	struct insn
+	{
+		static constexpr mcode_t opcode = Op;
+		using lhs = L;
+		using rhs = R;
+
+		static constexpr int mop_type = mop_d;
+		static constexpr int sub_opcode = Op;
+		static bool match_insn( minsn_t* ins, captures& c ) { return ins->opcode == Op && L::match( ins->l, c ) && R::match( ins->r, c ) && D::match( ins->d, c ); }
+		static bool match( mop_t& op, captures& c ) { return op.t == mop_d && match_insn( op.d, c ); }
+	};
+
+	// Rule pairing a root instruction pattern with a rewrite functor invoked as f( ins, captures ) or
+	// f( block, ins, captures ), returning whether the instruction was changed.
+	//
+	template<typename P, typename F>
+	struct rule_t
+	{
+		using pattern = P;
+		F rewrite;
+	};
+	template<typename P, typename F>
+	inline auto rule( F&& rewrite ) { return rule_t<P, std::decay_t<F>>{ std::forward<F>( rewrite ) }; }
+
+	// Rule set:
+	//  Rules are filtered by intersecting candidate sets indexed by the root opcode, the operand types and the opcodes
+	//  of the sub-instructions, so each of these tests is done once per instruction for the whole set rather than once
+	//  per rule. Remaining candidates are then fully matched in declaration order.
+	//
+	template<typename... Rx>
+	struct rule_set
+	{
+		static constexpr size_t count = sizeof...( Rx );
+		using rule_mask = static_bitset<count>;
+		using handler_t = bool( * )( rule_set& self, mblock_t* blk, minsn_t* ins );
+
+		struct tables_t
+		{
+			std::array<rule_mask, 256> by_opcode = {};
+			std::array<std::array<rule_mask, 16>, 2> by_type = {};
+			std::array<std::array<rule_mask, 257>, 2> by_sub = {};
+			opcode_set opcodes = {};
+		};
+		static constexpr tables_t tables = [ ] ()
+		{
+			tables_t t = {};
+			size_t i = 0;
+			auto add = [ & ] <typename P> ( std::type_identity<P> )
+			{
+				t.by_opcode[ P::opcode ].set( i );
+				t.opcodes.set( P::opcode );
+				auto add_operand = [ & ] <typename O> ( size_t slot, std::type_identity<O> )
+				{
+					for ( size_t ty = 0; ty != 16; ty++ )
+						if ( O::mop_type < 0 || ( size_t ) O::mop_type == ty )
+							t.by_type[ slot ][ ty ].set( i );
+					for ( size_t op = 0; op != 257; op++ )
+						if ( O::sub_opcode < 0 || ( size_t ) O::sub_opcode == op )
+							t.by_sub[ slot ][ op ].set( i );
+				};
+				add_operand( 0, std::type_identity<typename P::lhs>{} );
+				add_operand( 1, std::type_identity<typename P::rhs>{} );
+				i++;
+			};
+			( add( std::type_identity<typename Rx::pattern>{} ), ... );
+			return t;
+		}( );
+
+		std::tuple<Rx...> rules;
+		rule_set( Rx... rules ) : rules( std::move( rules )... ) {}
+
+		template<size_t I>
+		static bool try_rule( rule_set& self, mblock_t* blk, minsn_t* ins )
+		{
+			auto& r = std::get<I>( self.rules );
+			using R = std::tuple_element_t<I, std::tuple<Rx...>>;
+			captures c = {};
+			if ( !R::pattern::match_insn( ins, c ) )
+				return false;
+			if constexpr ( std::is_invocable_v<decltype( r.rewrite )&, mblock_t*, minsn_t*, captures&> )
+				return r.rewrite( blk, ins, c );
+			else
+				return r.rewrite( ins, c );
+		}
+		static constexpr auto handlers = [ ] <size_t... Ix> ( std::index_sequence<Ix...> )
+		{
+			return std::array<handler_t, count>{ &try_rule<Ix>... };
+		}( std::index_sequence_for<Rx...>{} );
+
+		// Candidate rules for the instruction.
+		//
+		static rule_mask candidates( minsn_t* ins )
+		{
+			auto sub = [ ] ( const mop_t& op ) -> size_t { return op.t == mop_d ? ( size_t ) op.d->opcode : 256; };
+			rule_mask mask = tables.by_opcode[ ( uint8_t ) ins->opcode ];
+			if ( mask.none() )
+				return mask;
+			mask &= tables.by_type[ 0 ][ ins->l.t & 15 ];
+			mask &= tables.by_type[ 1 ][ ins->r.t & 15 ];
+			mask &= tables.by_sub[ 0 ][ sub( ins->l ) ];
+			mask &= tables.by_sub[ 1 ][ sub( ins->r ) ];
+			return mask;
+		}
+
+		// Applies the first matching rule, returns the number of changes made.
+		//
+		int apply( mblock_t* blk, minsn_t* ins )
+		{
+			rule_mask mask = candidates( ins );
+			bool changed = false;
+			for ( size_t w = 0; w != mask.word_count && !changed; w++ )
+			{
+				for ( uint64_t bits = mask.words[ w ]; bits && !changed; bits &= bits - 1 )
+					changed = handlers[ ( w << 6 ) + std::countr_zero( bits ) ]( *this, blk, ins );
+			}
+			return changed ? 1 : 0;
+		}
+
+		// Applies the first matching rule to the instruction or to any of its sub-instructions, innermost first, and
+		// returns the number of changes made. Sub-instructions are rewritten in place and must keep their width.
+		//
+		int apply_nested( mblock_t* blk, minsn_t* ins )
+		{
+			int changes = 0;
+			hex::minsn_visitor visitor( [ & ] ( minsn_t* sub ) { return changes = apply( blk, sub ); } );
+			minsn_visitor_t& v = visitor;
+			v.mba = blk ? blk->mba : nullptr;
+			v.blk = blk;
+			v.topins = ins;
+			ins->for_all_insns( v );
+			return changes;
+		}
+
+		// Creates an opcode-dispatched instruction optimizer for the rule set which should outlive it. Only top-level
+		// instructions are matched, see nested_optimizer for rules targeting sub-instructions.
+		//
+		auto optimizer()
+		{
+			return hex::opcode_optimizer( tables.opcodes, [ this ] ( mblock_t* blk, minsn_t* ins, int ) { return apply( blk, ins ); } );
+		}
+
+		// Creates an instruction optimizer applying the rule set to every instruction tree bottom-up, so that rules
+		// also match expressions nested in operands such as the (x ^ y) + 2 * (x & y) in "mov ..., eax".
+		//
+		auto nested_optimizer()
+		{
+			return hex::insn_optimizer( [ this ] ( mblock_t* blk, minsn_t* ins, int ) { return apply_nested( blk, ins ); } );
+		}
+	};
+	template<typename... Rx> rule_set( Rx... )->rule_set<Rx...>;
+};
\ No newline at end of file
@@ -1,11 +1,20 @@
 #pragma once
+#include <string>
+#include <string_view>
 #include "ida.hpp"
+#if __has_include( <format> )
+	#include <format>
+#endif
 
 namespace hex
 {
 	// Prints a qstring into a std::string.
 	//
-	inline std::string to_string( const qstring& s ) { return std::string{ s.c_str(), s.size() }; }
+	inline std::string to_string( const qstring& s ) { return std::string{ s.c_str(), s.length() }; }
+
+	// Removes the color tags of the string in place.
+	//
+	inline qstring& strip_tags( qstring& s ) { tag_remove( &s ); return s; }
 
 	// Wrapper around T::print(&Qstring) -> std::string.
 	//
@@ -20,4 +29,109 @@ namespace hex
 	}
 	template<Printable T>
 	inline std::string to_string( T* x ) { return to_string( *x ); }
-};
\ No newline at end of file
+
+	// Appends the text to a caller owned buffer, printing through a per-thread scratch string so that no allocations
+	// are made once both buffers have grown.
+	//
+	template<Printable T>
+	inline std::string& to_string( T&& x, std::string& out, bool remove_tags = false )
+	{
+		thread_local qstring scratch = {};
+		scratch.clear();
+		x.print( &scratch );
+		if ( remove_tags )
+			strip_tags( scratch );
+		out.append( scratch.c_str(), scratch.length() );
+		return out;
+	}
+	template<Printable T>
+	inline std::string& to_string( T* x, std::string& out, bool remove_tags = false ) { return to_string( *x, out, remove_tags ); }
+
+	// Streams the text of anything printable through a vd_printer_t (such as an mba_t or mblock_t) into the sink, which
+	// is invoked as sink( std::string_view ) with chunks ending at line boundaries. All lines are formatted into a single
+	// buffer that is flushed when it grows past the threshold.
+	//
+	template<typename T>
+	concept Dumpable = requires( T&& x, vd_printer_t& p ) { x.print( p ); };
+
+	template<typename F>
+	struct stream_printer : vd_printer_t
+	{
+		F& sink;
+		bool remove_tags;
+		size_t threshold;
+		qstring buffer = {};
+
+		stream_printer( F& sink, bool remove_tags, size_t threshold ) : sink( sink ), remove_tags( remove_tags ), threshold( threshold ) { buffer.reserve( threshold ); }
+		~stream_printer() { flush(); }
+
+		void flush()
+		{
+			if ( buffer.empty() )
+				return;
+			if ( remove_tags )
+				strip_tags( buffer );
+			sink( std::string_view{ buffer.c_str(), buffer.length() } );
+			buffer.clear();
+		}
+
+		AS_PRINTF( 3, 4 ) int print( int indent, const char* format, ... ) override
+		{
+			size_t start = buffer.length();
+			for ( int i = 0; i < indent; i++ )
+				buffer.append( ' ' );
+			va_list va;
+			va_start( va, format );
+			buffer.cat_vsprnt( format, va );
+			va_end( va );
+			if ( buffer.empty() || buffer[ buffer.length() - 1 ] != '\n' )
+				buffer.append( '\n' );
+
+			int written = ( int ) ( buffer.length() - start );
+			if ( buffer.length() >= threshold )
+				flush();
+			return written;
+		}
+	};
+
+	template<Dumpable T, typename F>
+	inline void dump( T&& x, F&& sink, bool remove_tags = true, size_t threshold = 64 * 1024 )
+	{
+		stream_printer<F> printer{ sink, remove_tags, threshold };
+		x.print( printer );
+	}
+	template<Dumpable T, typename F>
+	inline void dump( T* x, F&& sink, bool remove_tags = true, size_t threshold = 64 * 1024 ) { dump( *x, std::forward<F>( sink ), remove_tags, threshold ); }
+};
+
+// std::format support for printable types, color tags are removed.
+//
+#if __cpp_lib_format
+template<hex::Printable T>
+struct std::formatter<T, char> : std::formatter<std::string_view, char>
+{
+	template<typename Ctx>
+	auto format( const T& x, Ctx& ctx ) const
+	{
+		thread_local std::string buffer = {};
+		buffer.clear();
+		hex::to_string( x, buffer, true );
+		return std::formatter<std::string_view, char>::format( buffer, ctx );
+	}
+};
+template<hex::Printable T>
+struct std::formatter<T*, char> : std::formatter<std::string_view, char>
+{
+	template<typename Ctx>
+	auto format( T* x, Ctx& ctx ) const
+	{
+		thread_local std::string buffer = {};
+		buffer.clear();
+		if ( x )
+			hex::to_string( *x, buffer, true );
+		else
+			buffer = "(null)";
+		return std::formatter<std::string_view, char>::format( buffer, ctx );
+	}
+};
+#endif
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "ida.hpp"
+
+// Opt-in per-component instrumentation, define HEXSUITE_PROFILE to 1 to enable and HEXSUITE_PROFILE_HISTOGRAM to 1
+// to additionally record a log2 histogram of invocation times. When disabled the statistics only count the reported
+// changes and profiled invocations compile down to a direct call and, when a change is reported, a relaxed atomic
+// increment.
+//
+// The macros change the layout of component_stats, which every component embeds, so they must have the same value in
+// every translation unit of the project. Each layout lives in its own inline namespace and MSVC rejects mismatches at
+// link time.
+//
+#ifndef HEXSUITE_PROFILE
+	#define HEXSUITE_PROFILE 0
+#endif
+#ifndef HEXSUITE_PROFILE_HISTOGRAM
+	#define HEXSUITE_PROFILE_HISTOGRAM 0
+#endif
+
+#if HEXSUITE_PROFILE && HEXSUITE_PROFILE_HISTOGRAM
+	#define HEXSUITE_PROFILE_ABI profile_histogram
+#elif HEXSUITE_PROFILE
+	#define HEXSUITE_PROFILE_ABI profile_on
+#else
+	#define HEXSUITE_PROFILE_ABI profile_off
+#endif
+#ifdef _MSC_VER
+	#define HEXSUITE_STRINGIFY_( x ) #x
+	#define HEXSUITE_STRINGIFY( x ) HEXSUITE_STRINGIFY_( x )
+	#pragma detect_mismatch( "HEXSUITE_PROFILE", HEXSUITE_STRINGIFY( HEXSUITE_PROFILE_ABI ) )
+#endif
+
+namespace hex
+{
+	inline namespace HEXSUITE_PROFILE_ABI
+	{
+#if HEXSUITE_PROFILE
+		// Statistics of a single component, kept on their own cache line so that components never share counters.
+		//
+		struct alignas( 64 ) component_stats
+		{
+			const char* name = nullptr;
+			uint64_t invocations = 0;
+			uint64_t changes = 0;
+			uint64_t total_ns = 0;
+			uint64_t max_ns = 0;
+#if HEXSUITE_PROFILE_HISTOGRAM
+			std::array<uint64_t, 40> histogram = {};   // Bucket n counts invocations taking [2^(n-1), 2^n) nanoseconds.
+#endif
+
+			component_stats() { attach(); }
+			component_stats( const component_stats& o ) : name( o.name ) { attach(); }
+			component_stats& operator=( const component_stats& o ) { name = o.name; return *this; }
+			~component_stats() { detach(); }
+
+			// Registry of all live statistics.
+			//
+			static std::mutex& registry_lock() { static std::mutex lock; return lock; }
+			static std::vector<component_stats*>& registry() { static std::vector<component_stats*> list; return list; }
+			void attach() { std::lock_guard _g{ registry_lock() }; registry().push_back( this ); }
+			void detach() { std::lock_guard _g{ registry_lock() }; std::erase( registry(), this ); }
+
+			void record( uint64_t ns, bool changed )
+			{
+				invocations++;
+				changes += changed;
+				total_ns += ns;
+				max_ns = std::max( max_ns, ns );
+#if HEXSUITE_PROFILE_HISTOGRAM
+				histogram[ std::min<size_t>( std::bit_width( ns ), histogram.size() - 1 ) ]++;
+#endif
+			}
+			void reset()
+			{
+				invocations = changes = total_ns = max_ns = 0;
+#if HEXSUITE_PROFILE_HISTOGRAM
+				histogram = {};
+#endif
+			}
+			void set_name( const char* n ) { name = n; }
+		};
+
+		// Invokes the functor, recording the time taken and whether it reported a change.
+		//
+		template<typename F>
+		inline auto profile( component_stats& stats, F&& functor )
+		{
+			auto t0 = std::chrono::steady_clock::now();
+			auto result = functor();
+			auto t1 = std::chrono::steady_clock::now();
+			stats.record( ( uint64_t ) std::chrono::duration_cast<std::chrono::nanoseconds>( t1 - t0 ).count(), result != decltype( result ){} );
+			return result;
+		}
+#else
+		// Change counter used by the scheduler to back off idle components. It is atomic so that it can be read and reset
+		// from any thread while the optimizers run, copies start from zero like the profiled statistics.
+		//
+		struct component_stats
+		{
+			std::atomic<uint64_t> changes = 0;
+
+			component_stats() = default;
+			component_stats( const component_stats& ) {}
+			component_stats& operator=( const component_stats& ) { return *this; }
+
+			void reset() { changes.store( 0, std::memory_order::relaxed ); }
+			constexpr void set_name( const char* ) {}
+		};
+		template<typename F>
+		inline auto profile( component_stats& stats, F&& functor )
+		{
+			auto result = functor();
+			if ( result != decltype( result ){} )
+				stats.changes.fetch_add( 1, std::memory_order::relaxed );
+			return result;
+		}
+#endif
+
+		namespace profiling
+		{
+			// Enumerates the statistics of every live component.
+			//
+			template<typename F>
+			inline void for_each( F&& functor )
+			{
+#if HEXSUITE_PROFILE
+				std::lock_guard _g{ component_stats::registry_lock() };
+				for ( component_stats* s : component_stats::registry() )
+					functor( *s );
+#endif
+			}
+			inline void reset() { for_each( [ ] ( component_stats& s ) { s.reset(); } ); }
+
+			// Text table sorted by cumulative time.
+			//
+			inline std::string report()
+			{
+				std::string result;
+				char line[ 256 ];
+				snprintf( line, sizeof( line ), "%-32s %12s %12s %8s %12s %10s %10s\n", "Component", "Calls", "Changes", "Hit%", "Total(ms)", "Avg(us)", "Max(us)" );
+				result += line;
+				std::vector<const component_stats*> sorted;
+#if HEXSUITE_PROFILE
+				std::lock_guard _g{ component_stats::registry_lock() };
+				sorted.assign( component_stats::registry().begin(), component_stats::registry().end() );
+				std::sort( sorted.begin(), sorted.end(), [ ] ( auto* a, auto* b ) { return a->total_ns > b->total_ns; } );
+				for ( const component_stats* s : sorted )
+				{
+					snprintf( line, sizeof( line ), "%-32s %12llu %12llu %7.2f%% %12.3f %10.3f %10.3f\n",
+						s->name ? s->name : "<unnamed>",
+						( unsigned long long ) s->invocations,
+						( unsigned long long ) s->changes,
+						s->invocations ? 100.0 * s->changes / s->invocations : 0.0,
+						s->total_ns / 1e6,
+						s->invocations ? s->total_ns / 1e3 / s->invocations : 0.0,
+						s->max_ns / 1e3 );
+					result += line;
+				}
+#endif
+				return result;
+			}
+
+			// Machine readable dump as a JSON array.
+			//
+			inline std::string dump_json()
+			{
+				std::string result = "[";
+#if HEXSUITE_PROFILE
+				char buffer[ 256 ];
+				bool first = true;
+				for_each( [ & ] ( const component_stats& s )
+				{
+					result += first ? "\n" : ",\n";
+					first = false;
+					result += "  {\"name\": \"";
+					for ( const char* c = s.name ? s.name : ""; *c; c++ )
+					{
+						if ( *c == '"' || *c == '\\' )
+						{
+							result += '\\';
+							result += *c;
+						}
+						else if ( ( uint8_t ) *c < 0x20 )
+						{
+							snprintf( buffer, sizeof( buffer ), "\\u%04x", ( unsigned ) ( uint8_t ) *c );
+							result += buffer;
+						}
+						else
+						{
+							result += *c;
+						}
+					}
+					snprintf( buffer, sizeof( buffer ), "\", \"invocations\": %llu, \"changes\": %llu, \"total_ns\": %llu, \"max_ns\": %llu",
+						( unsigned long long ) s.invocations, ( unsigned long long ) s.changes, ( unsigned long long ) s.total_ns, ( unsigned long long ) s.max_ns );
+					result += buffer;
+#if HEXSUITE_PROFILE_HISTOGRAM
+					result += ", \"histogram\": [";
+					for ( size_t i = 0; i != s.histogram.size(); i++ )
+					{
+						snprintf( buffer, sizeof( buffer ), i ? ", %llu" : "%llu", ( unsigned long long ) s.histogram[ i ] );
+						result += buffer;
+					}
+					result += "]";
+#endif
+					result += "}";
+				} );
+				result += "\n";
+#endif
+				result += "]";
+				return result;
+			}
+		};
+	};
+};
@@ -1,6 +1,8 @@
 #pragma once
 #include <ranges>
 #include <span>
+#include <vector>
+#include <algorithm>
 #include "ida.hpp"
 
 // Implement range wrappers.
@@ -63,19 +65,129 @@ namespace hex
 			size_t size() const { return std::distance( begin(), end() ); }
 			bool empty() const noexcept { return begin() == end(); }
 		};
+
+		// Random access iteration over the blocks of an mba_t via its block array, or over an explicit block order.
+		//
+		struct block_iterator
+		{
+			using iterator_concept =  std::random_access_iterator_tag;
+			using iterator_category = std::random_access_iterator_tag;
+			using value_type =        mblock_t*;
+			using difference_type =   ptrdiff_t;
+
+			mba_t* mba = nullptr;
+			const int* order = nullptr;
+			ptrdiff_t index = 0;
+
+			// Iteration.
+			//
+			block_iterator& operator++() { index++; return *this; }
+			block_iterator& operator--() { index--; return *this; }
+			block_iterator operator++( int ) { auto s = *this; operator++(); return s; }
+			block_iterator operator--( int ) { auto s = *this; operator--(); return s; }
+			block_iterator& operator+=( difference_type n ) { index += n; return *this; }
+			block_iterator& operator-=( difference_type n ) { index -= n; return *this; }
+			block_iterator operator+( difference_type n ) const { auto s = *this; return s += n; }
+			block_iterator operator-( difference_type n ) const { auto s = *this; return s -= n; }
+			friend block_iterator operator+( difference_type n, const block_iterator& it ) { return it + n; }
+			difference_type operator-( const block_iterator& rhs ) const { return index - rhs.index; }
+
+			// Comparison.
+			//
+			bool operator==( const block_iterator& rhs ) const { return index == rhs.index; }
+			auto operator<=>( const block_iterator& rhs ) const { return index <=> rhs.index; }
+
+			// Redirection to value type.
+			//
+			value_type operator*() const { return mba->get_mblock( order ? order[ index ] : ( int ) index ); }
+			value_type operator[]( difference_type n ) const { return *( *this + n ); }
+		};
 		struct bblock_range : std::ranges::view_base
 		{
-			using iterator = list_iterator<mblock_t>;
+			using iterator = block_iterator;
 
-			mblock_t* blk;
-			iterator begin() const { return iterator{ blk }; }
-			iterator end() const { return iterator{ nullptr }; }
-			size_t size() const { return std::distance( begin(), end() ); }
-			bool empty() const noexcept { return begin() == end(); }
+			mba_t* mba;
+			iterator begin() const { return iterator{ mba, nullptr, 0 }; }
+			iterator end() const { return iterator{ mba, nullptr, mba->qty }; }
+			size_t size() const { return ( size_t ) mba->qty; }
+			bool empty() const noexcept { return mba->qty == 0; }
+			mblock_t* operator[]( size_t n ) const { return mba->get_mblock( ( int ) n ); }
 		};
+		struct block_order_range
+		{
+			using iterator = block_iterator;
+
+			mba_t* mba;
+			std::vector<int> order;
+			iterator begin() const { return iterator{ mba, order.data(), 0 }; }
+			iterator end() const { return iterator{ mba, order.data(), ( ptrdiff_t ) order.size() }; }
+			size_t size() const { return order.size(); }
+			bool empty() const noexcept { return order.empty(); }
+			mblock_t* operator[]( size_t n ) const { return mba->get_mblock( order[ n ] ); }
+		};
+
+		// Iterative depth first post-order of the blocks reachable from the entry block.
+		//
+		inline std::vector<int> post_order( mba_t* mba )
+		{
+			std::vector<int> order;
+			if ( mba->qty <= 0 )
+				return order;
+			order.reserve( mba->qty );
+
+			std::vector<bool> visited( mba->qty );
+			std::vector<std::pair<int, int>> stack;
+			stack.emplace_back( 0, 0 );
+			visited[ 0 ] = true;
+			while ( !stack.empty() )
+			{
+				auto& [id, next] = stack.back();
+				mblock_t* blk = mba->get_mblock( id );
+				if ( next < blk->nsucc() )
+				{
+					int succ = blk->succ( next++ );
+					if ( !visited[ succ ] )
+					{
+						visited[ succ ] = true;
+						stack.emplace_back( succ, 0 );
+					}
+				}
+				else
+				{
+					order.push_back( id );
+					stack.pop_back();
+				}
+			}
+			return order;
+		}
 	};
 	inline auto instructions( mblock_t* blk ) { return detail::instruction_range{ .blk = blk }; }
-	inline auto basic_blocks( mba_t* mba ) { return detail::bblock_range{ .blk = mba->blocks }; }
+	inline auto basic_blocks( mba_t* mba ) { return detail::bblock_range{ .mba = mba }; }
+	inline auto reverse_basic_blocks( mba_t* mba ) { return basic_blocks( mba ) | std::views::reverse; }
+	
+	// Post-order and reverse post-order views, unreachable blocks are not included.
+	//
+	inline auto post_order( mba_t* mba ) { return detail::block_order_range{ .mba = mba, .order = detail::post_order( mba ) }; }
+	inline auto reverse_post_order( mba_t* mba ) 
+	{
+		auto order = detail::post_order( mba );
+		std::reverse( order.begin(), order.end() );
+		return detail::block_order_range{ .mba = mba, .order = std::move( order ) };
+	}
+
+	// Materializes the instructions of a block into a contiguous snapshot, the list is not updated if the block changes.
+	//
+	inline void collect_instructions( mblock_t* blk, std::vector<minsn_t*>& out )
+	{
+		for ( minsn_t* ins = blk->head; ins; ins = ins->next )
+			out.push_back( ins );
+	}
+	inline std::vector<minsn_t*> collect_instructions( mblock_t* blk )
+	{
+		std::vector<minsn_t*> result;
+		collect_instructions( blk, result );
+		return result;
+	}
 
 	// Type iteration.
 	//
@@ -120,4 +232,17 @@ namespace hex
 		};
 	};
 	inline auto named_types( int flags = NTF_TYPE | NTF_SYMM, const til_t* lib = local_type_lib() ) { return detail::type_range{ .library = lib, .flags = flags }; }
+
+	// Random access iteration over the numbered types by ordinal, deleted ordinals have a null name.
+	//
+	struct numbered_type
+	{
+		uint32_t ordinal;
+		const char* name;
+	};
+	inline auto types( const til_t* lib = local_type_lib() )
+	{
+		auto lookup = [ lib ] ( uint32_t ordinal ) { return numbered_type{ ordinal, get_numbered_type_name( lib, ordinal ) }; };
+		return std::views::iota( 1u, ( uint32_t ) get_ordinal_qty( lib ) + 1 ) | std::views::transform( lookup );
+	}
 };
\ No newline at end of file
@@ -0,0 +1,154 @@
+#pragma once
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include "ida.hpp"
+#include "components.hpp"
+#include "events.hpp"
+
+// Maturity-gated component scheduling.
+//
+namespace hex
+{
+	// Conditions under which a scheduled component is installed. The maturity range is checked against the maturity
+	// of the mba_t as observed by the optimizers, the size range against the number of blocks. Hex-Rays raises no event
+	// when entering MMAT_GLBOPT1..3, those maturities are observed at the next phase event (hxe_prealloc, hxe_glbopt).
+	//
+	struct schedule
+	{
+		mba_maturity_t min_maturity = MMAT_GENERATED;
+		mba_maturity_t max_maturity = MMAT_LVARS;
+		int min_blocks = 0;
+		int max_blocks = std::numeric_limits<int>::max();
+		int priority = 0;        // Components with higher priority are installed, and thus run, first.
+		uint32_t backoff = 0;    // Number of consecutive phases without changes after which the component is disabled for
+		                         // the rest of the function, zero disables backing off.
+
+		constexpr bool applies( const mba_t* mba ) const
+		{
+			return min_maturity <= mba->maturity && mba->maturity <= max_maturity && min_blocks <= mba->qty && mba->qty <= max_blocks;
+		}
+	};
+
+	// Scheduler:
+	//  Manages a group of components, re-evaluating the schedules at every microcode phase event and installing the
+	//  components that apply in priority order so that the pass order is the same regardless of how they were toggled.
+	//  Everything is uninstalled once the ctree is built. Backing off requires the component to keep statistics.
+	//
+	struct scheduler : component
+	{
+		struct entry
+		{
+			component* target;
+			schedule when;
+			bool active = false;
+			bool idle = false;          // Backed off for the current function.
+			uint32_t idle_phases = 0;
+			uint64_t last_changes = 0;
+		};
+		std::vector<entry> entries;
+		std::vector<entry*> order;      // Entries sorted by priority.
+		const mba_t* current = nullptr;
+		ea_t current_ea = BADADDR;
+		bool installed = false;
+
+		static constexpr hexrays_event_t phase_events[] = { hxe_microcode, hxe_preoptimized, hxe_locopt, hxe_calls_done, hxe_prealloc, hxe_glbopt };
+
+		scheduler() = default;
+		scheduler( const scheduler& ) = delete;
+		scheduler& operator=( const scheduler& ) = delete;
+		~scheduler() { uninstall(); }
+
+		// Adds a component, equal priorities keep the order they were added in.
+		//
+		scheduler& add( component& c, const schedule& when )
+		{
+			entries.push_back( { &c, when } );
+			order.clear();
+			for ( entry& e : entries )
+				order.push_back( &e );
+			std::stable_sort( order.begin(), order.end(), [ ] ( const entry* a, const entry* b ) { return a->when.priority > b->when.priority; } );
+			return *this;
+		}
+
+		static uint64_t changes_of( entry& e )
+		{
+			component_stats* stats = e.target->statistics();
+			return stats ? ( uint64_t ) stats->changes : 0;
+		}
+
+		// Re-evaluates the schedules for the current phase.
+		//
+		void update( mba_t* mba )
+		{
+			bool new_function = mba != current || mba->entry_ea != current_ea || mba->maturity == MMAT_GENERATED;
+			current = mba;
+			current_ea = mba->entry_ea;
+
+			bool changed = false;
+			for ( entry* e : order )
+			{
+				uint64_t changes = changes_of( *e );
+				if ( new_function )
+				{
+					e->idle = false;
+					e->idle_phases = 0;
+				}
+				else if ( e->active && e->when.backoff && e->target->statistics() )
+				{
+					e->idle_phases = changes == e->last_changes ? e->idle_phases + 1 : 0;
+					e->idle = e->idle_phases >= e->when.backoff;
+				}
+				e->last_changes = changes;
+
+				bool active = !e->idle && e->when.applies( mba );
+				changed |= active != e->active;
+				e->active = active;
+			}
+
+			// Reinstall in order, optimizers are invoked in the order they were installed.
+			//
+			if ( changed )
+			{
+				for ( entry* e : order )
+					e->target->uninstall();
+				for ( entry* e : order )
+					if ( e->active )
+						e->target->install();
+			}
+		}
+		void reset()
+		{
+			for ( entry* e : order )
+			{
+				if ( std::exchange( e->active, false ) )
+					e->target->uninstall();
+			}
+			current = nullptr;
+			current_ea = BADADDR;
+		}
+
+		static ssize_t on_phase( void* ctx, const void* args )
+		{
+			( ( scheduler* ) ctx )->update( std::get<0>( *( const std::tuple<mba_t*>* ) args ) );
+			return 0;
+		}
+		static ssize_t on_ctree( void* ctx, const void* )
+		{
+			( ( scheduler* ) ctx )->reset();
+			return 0;
+		}
+
+		void set_state( bool enable ) override
+		{
+			if ( std::exchange( installed, enable ) == enable )
+				return;
+			auto& bus = event_bus::instance();
+			for ( hexrays_event_t evt : phase_events )
+				enable ? bus.subscribe( evt, { std::numeric_limits<int>::max(), &detail::decode_args<std::tuple<mba_t*>>, &on_phase, this } ) : bus.unsubscribe( evt, this );
+			enable ? bus.subscribe( hxe_maturity, { std::numeric_limits<int>::max(), &detail::decode_args<std::tuple<>>, &on_ctree, this } ) : bus.unsubscribe( hxe_maturity, this );
+			if ( !enable )
+				reset();
+		}
+	};
+};
\ No newline at end of file
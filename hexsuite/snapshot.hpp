@@ -0,0 +1,248 @@
+#pragma once
+#include <span>
+#include <array>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "ida.hpp"
+#include "use_def.hpp"
+
+// Immutable copies of microcode for analysis away from the main thread.
+//
+namespace hex
+{
+	// Structure-of-arrays copy of an mba_t. Instructions, including sub-instructions, and operands are identified by
+	// their indices; registers, stack variables and globals are interned into location ids and strings into string ids.
+	// The snapshot references no IDA objects so any number of threads can read it concurrently once it is built.
+	//
+	struct mba_snapshot
+	{
+		static constexpr uint32_t none = ~0u;
+
+		ea_t entry_ea = BADADDR;
+		int maturity = 0;
+
+		// Instructions.
+		//
+		std::vector<uint8_t> opcode;
+		std::vector<ea_t> ea;
+		std::vector<int32_t> size;        // Size of the destination.
+		std::vector<uint32_t> l, r, d;    // Operand indices or none.
+		std::vector<uint32_t> parent;     // Instruction containing a sub-instruction, none for top-level instructions.
+		std::vector<uint32_t> block;      // Block of each instruction.
+
+		// Operands, the value depends on the type:
+		//  mop_r, mop_S, mop_v: location id.
+		//  mop_n:               constant value.
+		//  mop_d:               instruction index.
+		//  mop_b:               block number.
+		//  mop_a:               operand index of the referenced operand.
+		//  mop_p:               operand index of the low part, followed by the high part.
+		//  mop_f:               call index.
+		//  mop_h, mop_str:      string id.
+		//  mop_l:               local variable index.
+		//  mop_c:               switch index.
+		//  mop_fn:              floating point constant index.
+		//  mop_sc:              none, scattered operands are not encoded and are counted in unsupported_operands.
+		//
+		std::vector<uint8_t> operand_type;
+		std::vector<int32_t> operand_size;
+		std::vector<uint64_t> operand_value;
+
+		// Interned entities and call arguments.
+		//
+		std::vector<location_key> locations;
+		std::vector<std::string> strings;
+		std::vector<uint32_t> call_offsets = { 0 };
+		std::vector<uint32_t> call_args;
+		std::vector<ea_t> call_callee;
+		std::vector<std::array<uint16_t, 6>> fp_constants;   // Internal representation of the decompiler.
+		uint32_t unsupported_operands = 0;
+
+		// Switch targets, the cases of switch n are switch_offsets[ n ] .. switch_offsets[ n + 1 ) and each case has
+		// a target block and a list of values.
+		//
+		std::vector<uint32_t> switch_offsets = { 0 };
+		std::vector<uint32_t> case_targets;
+		std::vector<uint32_t> case_value_offsets = { 0 };
+		std::vector<uint64_t> case_values;
+
+		// Blocks and the CFG in compressed sparse row form.
+		//
+		std::vector<ea_t> block_start, block_end;
+		std::vector<uint32_t> insn_offsets = { 0 };   // Top-level instructions of block b are insns[ insn_offsets[ b ] .. insn_offsets[ b + 1 ] ).
+		std::vector<uint32_t> insns;
+		std::vector<uint32_t> succ_offsets = { 0 };
+		std::vector<uint32_t> succs;
+		std::vector<uint32_t> pred_offsets = { 0 };
+		std::vector<uint32_t> preds;
+
+		size_t block_count() const { return block_start.size(); }
+		size_t insn_count() const { return opcode.size(); }
+		size_t operand_count() const { return operand_type.size(); }
+
+		std::span<const uint32_t> instructions( uint32_t b ) const { return slice( insns, insn_offsets, b ); }
+		std::span<const uint32_t> successors( uint32_t b ) const { return slice( succs, succ_offsets, b ); }
+		std::span<const uint32_t> predecessors( uint32_t b ) const { return slice( preds, pred_offsets, b ); }
+		std::span<const uint32_t> arguments( uint32_t call ) const { return slice( call_args, call_offsets, call ); }
+		std::span<const uint32_t> targets( uint32_t sw ) const { return slice( case_targets, switch_offsets, sw ); }
+		std::span<const uint64_t> values( uint32_t c ) const { return slice( case_values, case_value_offsets, c ); }
+
+		template<typename T>
+		static std::span<const T> slice( const std::vector<T>& list, const std::vector<uint32_t>& offsets, uint32_t n )
+		{
+			return { list.data() + offsets[ n ], list.data() + offsets[ n + 1 ] };
+		}
+	};
+
+	namespace detail
+	{
+		struct snapshot_builder
+		{
+			mba_snapshot& s;
+			std::unordered_map<location_key, uint32_t, location_hash> location_ids;
+			std::unordered_map<std::string, uint32_t> string_ids;
+
+			uint32_t intern( const location_key& key )
+			{
+				auto [it, inserted] = location_ids.try_emplace( key, ( uint32_t ) s.locations.size() );
+				if ( inserted )
+					s.locations.push_back( key );
+				return it->second;
+			}
+			uint32_t intern( const char* str )
+			{
+				auto [it, inserted] = string_ids.try_emplace( str ? str : "", ( uint32_t ) s.strings.size() );
+				if ( inserted )
+					s.strings.push_back( it->first );
+				return it->second;
+			}
+
+			uint32_t allocate_operands( size_t n )
+			{
+				uint32_t index = ( uint32_t ) s.operand_type.size();
+				s.operand_type.resize( index + n );
+				s.operand_size.resize( index + n );
+				s.operand_value.resize( index + n );
+				return index;
+			}
+			uint32_t add_operand( const mop_t& op, uint32_t blk, uint32_t owner )
+			{
+				if ( op.t == mop_z )
+					return mba_snapshot::none;
+				uint32_t index = allocate_operands( 1 );
+				fill_operand( index, op, blk, owner );
+				return index;
+			}
+			void fill_operand( uint32_t index, const mop_t& op, uint32_t blk, uint32_t owner )
+			{
+				s.operand_type[ index ] = op.t;
+				s.operand_size[ index ] = op.size;
+
+				uint64_t value = 0;
+				switch ( op.t )
+				{
+					case mop_r:
+					case mop_S:
+					case mop_v:   value = intern( location_key::of( op ) ); break;
+					case mop_n:   value = op.nnn->value; break;
+					case mop_d:   value = add_insn( op.d, blk, owner ); break;
+					case mop_b:   value = ( uint64_t ) op.b; break;
+					case mop_l:   value = ( uint64_t ) op.l->idx; break;
+					case mop_h:   value = intern( op.helper ); break;
+					case mop_str: value = intern( op.cstr ); break;
+					case mop_a:   value = add_operand( *op.a, blk, owner ); break;
+					case mop_p:
+						value = allocate_operands( 2 );
+						fill_operand( ( uint32_t ) value, op.pair->lop, blk, owner );
+						fill_operand( ( uint32_t ) value + 1, op.pair->hop, blk, owner );
+						break;
+					case mop_f:
+					{
+						std::vector<uint32_t> args;
+						args.reserve( op.f->args.size() );
+						for ( const mcallarg_t& arg : op.f->args )
+							args.push_back( add_operand( arg, blk, owner ) );
+						value = s.call_callee.size();
+						s.call_callee.push_back( op.f->callee );
+						s.call_args.insert( s.call_args.end(), args.begin(), args.end() );
+						s.call_offsets.push_back( ( uint32_t ) s.call_args.size() );
+						break;
+					}
+					case mop_c:
+						value = s.switch_offsets.size() - 1;
+						for ( size_t i = 0; i != op.c->targets.size(); i++ )
+						{
+							s.case_targets.push_back( ( uint32_t ) op.c->targets[ i ] );
+							if ( i < op.c->values.size() )
+								s.case_values.insert( s.case_values.end(), op.c->values[ i ].begin(), op.c->values[ i ].end() );
+							s.case_value_offsets.push_back( ( uint32_t ) s.case_values.size() );
+						}
+						s.switch_offsets.push_back( ( uint32_t ) s.case_targets.size() );
+						break;
+					case mop_fn:
+						value = s.fp_constants.size();
+						std::copy_n( op.fpc->fnum, 6, s.fp_constants.emplace_back().begin() );
+						break;
+					default:
+						value = mba_snapshot::none;
+						s.unsupported_operands++;
+						break;
+				}
+				s.operand_value[ index ] = value;
+			}
+
+			uint32_t add_insn( const minsn_t* ins, uint32_t blk, uint32_t owner )
+			{
+				uint32_t index = ( uint32_t ) s.opcode.size();
+				s.opcode.push_back( ( uint8_t ) ins->opcode );
+				s.ea.push_back( ins->ea );
+				s.size.push_back( ins->d.size );
+				s.parent.push_back( owner );
+				s.block.push_back( blk );
+				s.l.push_back( mba_snapshot::none );
+				s.r.push_back( mba_snapshot::none );
+				s.d.push_back( mba_snapshot::none );
+
+				uint32_t lop = add_operand( ins->l, blk, index );
+				uint32_t rop = add_operand( ins->r, blk, index );
+				uint32_t dop = add_operand( ins->d, blk, index );
+				s.l[ index ] = lop;
+				s.r[ index ] = rop;
+				s.d[ index ] = dop;
+				return index;
+			}
+		};
+	};
+
+	// Copies the microcode of the function, must be called on the main thread.
+	//
+	inline std::shared_ptr<const mba_snapshot> snapshot( mba_t* mba )
+	{
+		auto result = std::make_shared<mba_snapshot>();
+		mba_snapshot& s = *result;
+		s.entry_ea = mba->entry_ea;
+		s.maturity = ( int ) mba->maturity;
+
+		detail::snapshot_builder builder{ s };
+		for ( int b = 0; b != mba->qty; b++ )
+		{
+			mblock_t* blk = mba->get_mblock( b );
+			s.block_start.push_back( blk->start );
+			s.block_end.push_back( blk->end );
+			for ( minsn_t* ins = blk->head; ins; ins = ins->next )
+				s.insns.push_back( builder.add_insn( ins, ( uint32_t ) b, mba_snapshot::none ) );
+			s.insn_offsets.push_back( ( uint32_t ) s.insns.size() );
+
+			for ( int succ : blk->succset )
+				s.succs.push_back( ( uint32_t ) succ );
+			s.succ_offsets.push_back( ( uint32_t ) s.succs.size() );
+			for ( int pred : blk->predset )
+				s.preds.push_back( ( uint32_t ) pred );
+			s.pred_offsets.push_back( ( uint32_t ) s.preds.size() );
+		}
+		return result;
+	}
+};
\ No newline at end of file
@@ -0,0 +1,235 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include "ida.hpp"
+#include "opcodes.hpp"
+#include "mapped_file.hpp"
+#include "hash.hpp"
+
+// Rewrite trace recorder, see trace_source.hpp for the hooks and the macros enabling them. Entries are appended to a
+// per-thread ring which is copied into a memory mapped file when full, when the thread exits or when flushed
+// explicitly; with no file open the ring simply keeps the latest entries.
+//
+
+namespace hex
+{
+	struct trace_entry
+	{
+		uint64_t ea;
+		uint32_t hash;        // Low bits of the structural hash of the result or zero.
+		uint16_t component;   // Index into the name table, zero if the component is unnamed.
+		uint8_t before;       // Opcode before the change, for blocks the opcode of the tail instruction.
+		uint8_t after;
+	};
+	static_assert( sizeof( trace_entry ) == 16, "Trace entries should stay compact." );
+
+	namespace trace
+	{
+		static constexpr uint32_t magic = 0x52545848;   // 'HXTR'
+		static constexpr uint32_t version = 1;
+		static constexpr size_t max_components = 256;
+		static constexpr size_t name_length = 32;
+
+		// File layout, the entries form a ring indexed by cursor modulo capacity.
+		//
+		struct file_header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint64_t capacity;
+			uint64_t cursor;      // Total number of entries written.
+			char names[ max_components ][ name_length ];
+		};
+		inline trace_entry* file_entries( file_header* h ) { return ( trace_entry* ) ( h + 1 ); }
+
+		// Process-wide component names and output file. The header is published atomically and writers announce
+		// themselves in a counter so that closing the file can wait for in-flight copies before unmapping it.
+		//
+		struct sink
+		{
+			std::mutex lock;
+			std::vector<std::string> names = { "<unnamed>" };
+			mapped_file file;
+			std::atomic<file_header*> header = nullptr;
+			std::atomic<uint32_t> writers = 0;
+
+			static sink& instance() { static sink s = {}; return s; }
+
+			uint16_t register_name( const char* name )
+			{
+				std::lock_guard _g{ lock };
+				auto it = std::find( names.begin(), names.end(), name );
+				if ( it != names.end() )
+					return ( uint16_t ) ( it - names.begin() );
+				if ( names.size() == max_components )
+					return 0;
+				names.emplace_back( name );
+				if ( file_header* h = header.load() )
+					write_name( h, names.size() - 1 );
+				return ( uint16_t ) ( names.size() - 1 );
+			}
+			void write_name( file_header* h, size_t id )
+			{
+				auto& dst = h->names[ id ];
+				size_t n = std::min( names[ id ].size(), name_length - 1 );
+				std::copy_n( names[ id ].data(), n, dst );
+				dst[ n ] = 0;
+			}
+
+			// Opens the output file holding the given number of entries, existing traces are overwritten.
+			//
+			bool open( const char* path, size_t capacity = 1 << 20 )
+			{
+				std::lock_guard _g{ lock };
+				detach();
+				if ( !capacity || !file.open( path, sizeof( file_header ) + capacity * sizeof( trace_entry ) ) )
+					return false;
+				std::fill_n( file.data, sizeof( file_header ), 0 );
+				auto* h = ( file_header* ) file.data;
+				h->magic = magic;
+				h->version = version;
+				h->capacity = ( file.size - sizeof( file_header ) ) / sizeof( trace_entry );
+				for ( size_t i = 0; i != names.size(); i++ )
+					write_name( h, i );
+				header.store( h );
+				return true;
+			}
+			void close()
+			{
+				std::lock_guard _g{ lock };
+				detach();
+				file.flush();
+				file.close();
+			}
+
+			// Unpublishes the header and waits for the writers that already loaded it, must hold the lock.
+			//
+			void detach()
+			{
+				header.store( nullptr );
+				while ( writers.load() )
+					std::this_thread::yield();
+			}
+
+			// Reserves a range of the ring with a single atomic increment and copies the entries, returns false if no file
+			// was open.
+			//
+			bool write( const trace_entry* entries, size_t n )
+			{
+				if ( !n )
+					return true;
+				writers.fetch_add( 1 );
+				file_header* h = header.load();
+				if ( h )
+				{
+					uint64_t start = std::atomic_ref<uint64_t>{ h->cursor }.fetch_add( n, std::memory_order::relaxed );
+					trace_entry* ring = file_entries( h );
+					for ( size_t i = 0; i != n; i++ )
+						ring[ ( start + i ) % h->capacity ] = entries[ i ];
+				}
+				writers.fetch_sub( 1, std::memory_order::release );
+				return h != nullptr;
+			}
+		};
+
+		// Ring of the calling thread, only ever touched by its owner.
+		//
+		struct thread_ring
+		{
+			static constexpr size_t capacity = 4096;
+			std::array<trace_entry, capacity> entries;
+			uint64_t count = 0;
+			uint64_t flushed = 0;
+
+			~thread_ring() { flush(); }
+
+			void push( const trace_entry& e )
+			{
+				entries[ count++ % capacity ] = e;
+				if ( count - flushed >= capacity && sink::instance().header.load() )
+					flush();
+			}
+			// Only what reached a file counts as flushed, entries pushed while none is open are kept until the ring wraps.
+			//
+			void flush()
+			{
+				uint64_t first = std::max( flushed, count > capacity ? count - capacity : 0 );
+				auto& out = sink::instance();
+				while ( first != count )
+				{
+					size_t offset = first % capacity;
+					size_t n = ( size_t ) std::min<uint64_t>( count - first, capacity - offset );
+					if ( !out.write( &entries[ offset ], n ) )
+						break;
+					first += n;
+				}
+				flushed = first;
+			}
+
+			static thread_ring& local() { thread_local thread_ring ring; return ring; }
+		};
+
+		inline bool open( const char* path, size_t capacity = 1 << 20 ) { return sink::instance().open( path, capacity ); }
+		inline void flush() { thread_ring::local().flush(); }
+		inline void close() { flush(); sink::instance().close(); }
+
+		// Entries recorded by the calling thread that are still in its ring, oldest first.
+		//
+		template<typename F>
+		inline void for_each_recent( F&& functor )
+		{
+			auto& ring = thread_ring::local();
+			for ( uint64_t i = ring.count > ring.capacity ? ring.count - ring.capacity : 0; i != ring.count; i++ )
+				functor( ring.entries[ i % ring.capacity ] );
+		}
+
+		// Formats a single entry.
+		//
+		inline std::string format( const trace_entry& e, std::string_view component )
+		{
+			auto op = [ ] ( uint8_t o ) { const char* n = opcode_name( ( mcode_t ) o ); return n ? n : "?"; };
+			char line[ 128 ];
+			snprintf( line, sizeof( line ), "%-24.*s %016llx %-6s -> %-6s %08x", ( int ) component.size(), component.data(),
+				( unsigned long long ) e.ea, op( e.before ), op( e.after ), e.hash );
+			return line;
+		}
+
+		// Decodes a trace file, invoking output( std::string_view ) for each entry oldest first. Returns false if the
+		// file could not be read.
+		//
+		template<typename F>
+		inline bool decode( const char* path, F&& output )
+		{
+			mapped_file file;
+			if ( !file.open( path, 0, true ) || file.size < sizeof( file_header ) )
+				return false;
+			auto* h = ( file_header* ) file.data;
+			if ( h->magic != magic || h->version != version || !h->capacity || file.size < sizeof( file_header ) + h->capacity * sizeof( trace_entry ) )
+				return false;
+
+			auto name = [ & ] ( uint16_t id ) -> std::string_view
+			{
+				if ( id >= max_components || !h->names[ id ][ 0 ] )
+					return "<unnamed>";
+				const char* n = h->names[ id ];
+				return { n, ( size_t ) ( std::find( n, n + name_length, 0 ) - n ) };
+			};
+			const trace_entry* ring = file_entries( h );
+			uint64_t cursor = h->cursor;
+			for ( uint64_t i = cursor > h->capacity ? cursor - h->capacity : 0; i != cursor; i++ )
+			{
+				const trace_entry& e = ring[ i % h->capacity ];
+				output( std::string_view{ format( e, name( e.component ) ) } );
+			}
+			return true;
+		}
+	};
+};
+
+#include "trace_source.hpp"
@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include "ida.hpp"
+
+// Opt-in rewrite tracing, define HEXSUITE_TRACE to 1 to record an entry every time an instruction or block optimizer
+// reports a change and HEXSUITE_TRACE_HASH to 1 to additionally record the structural hash of the result. This header
+// only declares the hooks used by the components, the recorder itself lives in trace.hpp and is only pulled in when
+// tracing is enabled. When disabled trace sources are empty and traced invocations compile down to a direct call.
+//
+#ifndef HEXSUITE_TRACE
+	#define HEXSUITE_TRACE 0
+#endif
+#ifndef HEXSUITE_TRACE_HASH
+	#define HEXSUITE_TRACE_HASH 0
+#endif
+
+#if HEXSUITE_TRACE
+	#include "trace.hpp"
+#endif
+
+namespace hex
+{
+	// Identity of a traced component.
+	//
+#if HEXSUITE_TRACE
+	struct trace_source
+	{
+		uint16_t id = 0;
+		void set_name( const char* name ) { id = trace::sink::instance().register_name( name ); }
+	};
+
+	// Invokes the optimizer, recording an entry if it reports a change.
+	//
+	template<typename F>
+	inline auto trace_insn( const trace_source& src, const minsn_t* ins, F&& functor )
+	{
+		ea_t ea = ins->ea;
+		uint8_t before = ( uint8_t ) ins->opcode;
+		auto result = functor();
+		if ( result != decltype( result ){} )
+		{
+			uint32_t hash = 0;
+#if HEXSUITE_TRACE_HASH
+			hash = ( uint32_t ) hash_insn( *ins );
+#endif
+			trace::thread_ring::local().push( { ( uint64_t ) ea, hash, src.id, before, ( uint8_t ) ins->opcode } );
+		}
+		return result;
+	}
+	template<typename F>
+	inline auto trace_block( const trace_source& src, const mblock_t* blk, F&& functor )
+	{
+		auto tail = [ & ] { return ( uint8_t ) ( blk->tail ? blk->tail->opcode : m_nop ); };
+		uint8_t before = tail();
+		auto result = functor();
+		if ( result != decltype( result ){} )
+		{
+			uint32_t hash = 0;
+#if HEXSUITE_TRACE_HASH
+			if ( blk->tail )
+				hash = ( uint32_t ) hash_insn( *blk->tail );
+#endif
+			trace::thread_ring::local().push( { ( uint64_t ) blk->start, hash, src.id, before, tail() } );
+		}
+		return result;
+	}
+#else
+	struct trace_source
+	{
+		constexpr void set_name( const char* ) {}
+	};
+	template<typename F>
+	inline auto trace_insn( const trace_source&, const minsn_t*, F&& functor ) { return functor(); }
+	template<typename F>
+	inline auto trace_block( const trace_source&, const mblock_t*, F&& functor ) { return functor(); }
+#endif
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include "ida.hpp"
+#include "ranges.hpp"
+#include "components.hpp"
+
+// Indexed snapshots of type libraries.
+//
+namespace hex
+{
+	namespace detail
+	{
+		struct string_hash
+		{
+			using is_transparent = void;
+			size_t operator()( std::string_view s ) const { return std::hash<std::string_view>{}( s ); }
+		};
+	};
+
+	// Snapshot of the numbered types of a library mapping each name to its ordinal and type, resolved once when the
+	// snapshot is taken so that lookups are a single hash probe.
+	//
+	struct type_index
+	{
+		struct entry
+		{
+			uint32_t ordinal;
+			tinfo_t type;
+		};
+
+		const til_t* library = nullptr;
+		std::unordered_map<std::string, entry, detail::string_hash, std::equal_to<>> by_name;
+		std::vector<const std::string*> names;   // Name of each ordinal or null, points into the keys of by_name.
+
+		// Moves keep the nodes of by_name and with them the names, copies would leave them pointing into the source.
+		//
+		type_index() = default;
+		type_index( type_index&& ) = default;
+		type_index& operator=( type_index&& ) = default;
+		type_index( const type_index& ) = delete;
+		type_index& operator=( const type_index& ) = delete;
+		type_index( const til_t* lib ) : library( lib )
+		{
+			auto range = types( lib );
+			by_name.reserve( range.size() );
+			names.assign( range.size() + 1, nullptr );
+			for ( numbered_type t : range )
+			{
+				if ( !t.name )
+					continue;
+				tinfo_t type;
+				type.get_numbered_type( lib, t.ordinal );
+				auto [it, inserted] = by_name.try_emplace( t.name, entry{ t.ordinal, std::move( type ) } );
+				if ( inserted )
+					names[ t.ordinal ] = &it->first;
+			}
+		}
+
+		const entry* find( std::string_view name ) const
+		{
+			auto it = by_name.find( name );
+			return it == by_name.end() ? nullptr : &it->second;
+		}
+		uint32_t ordinal( std::string_view name ) const
+		{
+			auto* e = find( name );
+			return e ? e->ordinal : 0;
+		}
+		const tinfo_t* type( std::string_view name ) const
+		{
+			auto* e = find( name );
+			return e ? &e->type : nullptr;
+		}
+		const std::string* name( uint32_t ordinal ) const { return ordinal < names.size() ? names[ ordinal ] : nullptr; }
+		size_t size() const { return by_name.size(); }
+	};
+
+	// Shared snapshot of the local type library, rebuilt on the first lookup after IDA reports a change to the local
+	// types or the database is closed. The IDB hook is installed on first use and removed by release().
+	//
+	namespace detail
+	{
+		struct local_type_cache
+		{
+			type_index index = {};
+			bool valid = false;
+			idb_callback<ssize_t( * )( idb_event::event_code_t, va_list )> hook{ &on_event };
+
+			static local_type_cache& instance() { static local_type_cache cache = {}; return cache; }
+			static ssize_t on_event( idb_event::event_code_t code, va_list )
+			{
+				if ( code == idb_event::local_types_changed || code == idb_event::closebase )
+					instance().valid = false;
+				return 0;
+			}
+
+			const type_index& get()
+			{
+				hook.install();
+				if ( !valid )
+				{
+					index = type_index{ local_type_lib() };
+					valid = true;
+				}
+				return index;
+			}
+			void release()
+			{
+				hook.uninstall();
+				index = {};
+				valid = false;
+			}
+		};
+	};
+	inline const type_index& local_types() { return detail::local_type_cache::instance().get(); }
+	inline void release_local_types() { detail::local_type_cache::instance().release(); }
+};
\ No newline at end of file
@@ -0,0 +1,253 @@
+#pragma once
+#include <span>
+#include <vector>
+#include <map>
+#include <algorithm>
+#include <unordered_map>
+#include "ida.hpp"
+#include "hash.hpp"
+#include "ranges.hpp"
+#include "architecture.hpp"
+
+// Def-use index of microcode locations.
+//
+namespace hex
+{
+	// Register, stack variable or global variable referenced by an operand, identified by its type, start and size.
+	// Differently sized accesses to the same location have distinct keys and are related through overlaps().
+	//
+	struct location_key
+	{
+		mopt_t t;
+		uint64_t value;
+		int size;
+
+		static bool is_location( const mop_t& op ) { return op.t == mop_r || op.t == mop_S || op.t == mop_v; }
+		static location_key of( const mop_t& op )
+		{
+			int size = std::max( op.size, 1 );
+			switch ( op.t )
+			{
+				case mop_r: return { op.t, ( uint64_t ) op.r, size };
+				case mop_S: return { op.t, ( uint64_t ) op.s->off, size };
+				default:    return { op.t, ( uint64_t ) op.g, size };
+			}
+		}
+		bool overlaps( const location_key& o ) const { return t == o.t && value < o.value + o.size && o.value < value + size; }
+		bool operator==( const location_key& o ) const = default;
+	};
+	struct location_hash
+	{
+		size_t operator()( const location_key& k ) const { return ( size_t ) detail::hash_mix( detail::hash_mix( k.t, k.value ), ( uint64_t ) k.size ); }
+	};
+
+	// Index mapping each location to the top-level instructions defining and using it, built in a single pass. Queries
+	// match every indexed location overlapping the operand, so a use of al finds the definitions of eax. References are
+	// kept in arrays sorted by instruction pointer (not program order) so that updates are logarithmic, and each indexed
+	// instruction records its locations so it can be re-indexed after being rewritten.
+	//
+	struct use_def_index
+	{
+		struct site
+		{
+			minsn_t* ins;
+			mblock_t* blk;
+
+			bool operator<( const site& o ) const { return ins < o.ins; }
+		};
+		struct references
+		{
+			std::vector<site> defs;
+			std::vector<site> uses;
+		};
+		struct reference
+		{
+			uint32_t slot;
+			bool def;
+		};
+
+		std::unordered_map<location_key, uint32_t, location_hash> slots;
+		std::vector<location_key> keys;                                     // Key of each slot.
+		std::multimap<std::pair<mopt_t, uint64_t>, uint32_t> by_start;      // Slots ordered by type and start.
+		int max_size = 0;
+		std::vector<references> table;
+		std::unordered_map<const minsn_t*, std::vector<reference>> by_insn;
+
+		use_def_index() = default;
+		use_def_index( mba_t* mba )
+		{
+			for ( mblock_t* blk : basic_blocks( mba ) )
+				for ( minsn_t* ins = blk->head; ins; ins = ins->next )
+					collect( blk, ins, false );
+			for ( references& r : table )
+			{
+				std::sort( r.defs.begin(), r.defs.end() );
+				std::sort( r.uses.begin(), r.uses.end() );
+			}
+		}
+
+		// Queries over the locations overlapping the operand, results are sorted by instruction pointer.
+		//
+		std::vector<site> defs( const mop_t& op ) const { return lookup( op, true ); }
+		std::vector<site> uses( const mop_t& op ) const { return lookup( op, false ); }
+		bool is_used( const mop_t& op ) const
+		{
+			bool used = false;
+			for_each_overlap( op, [ & ] ( uint32_t slot ) { used |= !table[ slot ].uses.empty(); } );
+			return used;
+		}
+		bool contains( const minsn_t* ins ) const { return by_insn.contains( ins ); }
+
+		// Removes the references of an instruction, must be called before it is deleted.
+		//
+		void erase( const minsn_t* ins )
+		{
+			auto it = by_insn.find( ins );
+			if ( it == by_insn.end() )
+				return;
+			for ( const reference& ref : it->second )
+			{
+				auto& list = ref.def ? table[ ref.slot ].defs : table[ ref.slot ].uses;
+				auto pos = std::lower_bound( list.begin(), list.end(), site{ ( minsn_t* ) ins, nullptr } );
+				if ( pos != list.end() && pos->ins == ins )
+					list.erase( pos );
+			}
+			by_insn.erase( it );
+		}
+
+		// Re-indexes an instruction that was rewritten in place or newly inserted into the block.
+		//
+		void update( mblock_t* blk, minsn_t* ins )
+		{
+			erase( ins );
+			collect( blk, ins, true );
+		}
+
+		// Builder integration, splices a sequence into the block indexing each instruction and rewrites an instruction
+		// in place with a new one.
+		//
+		minsn_t* insert( mblock_t* blk, minsn_t* after, insn_sequence& seq )
+		{
+			std::vector<minsn_t*> inserted;
+			inserted.reserve( seq.size() );
+			for ( minsn_t* ins = seq.head; ins; ins = ins->next )
+				inserted.push_back( ins );
+			minsn_t* last = seq.insert_into( blk, after );
+			for ( minsn_t* ins : inserted )
+				collect( blk, ins, true );
+			return last;
+		}
+		void replace( mblock_t* blk, minsn_t* ins, std::unique_ptr<minsn_t> with )
+		{
+			with->setaddr( ins->ea );
+			ins->swap( *with );
+			update( blk, ins );
+		}
+
+		// Internal helpers.
+		//
+		template<typename F>
+		void for_each_overlap( const mop_t& op, F&& functor ) const
+		{
+			if ( !location_key::is_location( op ) )
+				return;
+			location_key key = location_key::of( op );
+			uint64_t first = key.value > ( uint64_t ) max_size ? key.value - max_size + 1 : 0;
+			for ( auto it = by_start.lower_bound( { key.t, first } ); it != by_start.end() && it->first.first == key.t && it->first.second < key.value + key.size; ++it )
+				if ( keys[ it->second ].overlaps( key ) )
+					functor( it->second );
+		}
+		std::vector<site> lookup( const mop_t& op, bool def ) const
+		{
+			std::vector<site> result;
+			size_t matches = 0;
+			for_each_overlap( op, [ & ] ( uint32_t slot )
+			{
+				auto& list = def ? table[ slot ].defs : table[ slot ].uses;
+				result.insert( result.end(), list.begin(), list.end() );
+				matches++;
+			} );
+			if ( matches > 1 )
+			{
+				std::sort( result.begin(), result.end() );
+				result.erase( std::unique( result.begin(), result.end(), [ ] ( const site& a, const site& b ) { return a.ins == b.ins; } ), result.end() );
+			}
+			return result;
+		}
+
+		void add( mblock_t* blk, minsn_t* ins, const mop_t& op, bool def, bool sorted, std::vector<reference>& refs )
+		{
+			location_key key = location_key::of( op );
+			auto [it, inserted] = slots.try_emplace( key, ( uint32_t ) table.size() );
+			if ( inserted )
+			{
+				table.emplace_back();
+				keys.push_back( key );
+				by_start.emplace( std::pair{ key.t, key.value }, it->second );
+				max_size = std::max( max_size, key.size );
+			}
+			uint32_t slot = it->second;
+
+			// Skip duplicate references within the same instruction.
+			//
+			for ( const reference& ref : refs )
+				if ( ref.slot == slot && ref.def == def )
+					return;
+			refs.push_back( { slot, def } );
+
+			auto& list = def ? table[ slot ].defs : table[ slot ].uses;
+			if ( sorted )
+				list.insert( std::upper_bound( list.begin(), list.end(), site{ ins, blk } ), site{ ins, blk } );
+			else
+				list.push_back( { ins, blk } );
+		}
+
+		void collect( mblock_t* blk, minsn_t* ins, bool sorted )
+		{
+			std::vector<reference> refs;
+			auto use = [ & ] ( auto& self, const mop_t& op ) -> void
+			{
+				switch ( op.t )
+				{
+					case mop_r:
+					case mop_S:
+					case mop_v:
+						add( blk, ins, op, false, sorted, refs );
+						break;
+					case mop_d:
+						self( self, op.d->l );
+						self( self, op.d->r );
+						self( self, op.d->d );
+						break;
+					case mop_a:   self( self, *op.a ); break;
+					case mop_p:   self( self, op.pair->lop ); self( self, op.pair->hop ); break;
+					case mop_f:
+						for ( const mcallarg_t& arg : op.f->args )
+							self( self, arg );
+						break;
+					default:
+						break;
+				}
+			};
+			use( use, ins->l );
+			use( use, ins->r );
+			if ( ins->d.t == mop_f )
+			{
+				use( use, ins->d );
+				for ( const mop_t& ret : ins->d.f->retregs )
+					if ( location_key::is_location( ret ) )
+						add( blk, ins, ret, true, sorted, refs );
+			}
+			else if ( ins->modifies_d() && location_key::is_location( ins->d ) )
+			{
+				add( blk, ins, ins->d, true, sorted, refs );
+			}
+			else
+			{
+				use( use, ins->d );
+			}
+			if ( !refs.empty() )
+				by_insn[ ins ] = std::move( refs );
+		}
+	};
+};
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
+#include <vector>
+#include <algorithm>
 #include "ida.hpp"
+#include "bitset.hpp"
 
 // Lambda wrappers around common visitor types.
 //
@@ -69,9 +72,9 @@ namespace hex
 		}
 		int leave_insn( cinsn_t* e ) override
 		{
-			if constexpr ( Pre && detail::CtreeCallableWith<F, ctree_visitor_t&, cinsn_t*> )
+			if constexpr ( Post && detail::CtreeCallableWith<F, ctree_visitor_t&, cinsn_t*> )
 				return functor( *this, e );
-			else if constexpr ( Pre && detail::CtreeCallableWith<F, cinsn_t*> )
+			else if constexpr ( Post && detail::CtreeCallableWith<F, cinsn_t*> )
 				return functor( e );
 			return 0;
 		}
@@ -97,4 +100,157 @@ namespace hex
 		ctree_post_visitor( F&& functor, int flags = CV_FAST ) : basic_ctree_visitor<false, true, F>( flags | CV_POST, std::forward<F>( functor ) ) {}
 	};
 	template<typename F> ctree_post_visitor( F&& )->ctree_post_visitor<F>;
-};
+
+	// Kind-filtered ctree traversal:
+	//  Walks the tree in pre-order using an explicit stack, invoking the functor only for the node kinds in the set and
+	//  without any virtual dispatch. If the set contains no expression kinds, expressions are not descended into at all,
+	//  which also skips statements nested in expressions via cot_insn.
+	//
+	using ctype_set = static_bitset<cit_end>;
+	template<ctype_t... Kx>
+	constexpr ctype_set ctypes = ctype_set{ std::in_place, Kx... };
+
+	enum class walk_result
+	{
+		proceed,   // Visit children.
+		prune,     // Skip the children of this node.
+		stop,      // Terminate the traversal.
+	};
+
+	namespace detail
+	{
+		template<typename F>
+		inline walk_result invoke_walker( F& functor, citem_t* item )
+		{
+			auto invoke = [ & ] ( auto* x ) -> walk_result
+			{
+				if constexpr ( std::is_void_v<decltype( functor( x ) )> )
+					return functor( x ), walk_result::proceed;
+				else
+					return functor( x );
+			};
+			if constexpr ( CtreeCallableWith<F, cexpr_t*> || CtreeCallableWith<F, cinsn_t*> )
+			{
+				if ( item->is_expr() )
+				{
+					if constexpr ( CtreeCallableWith<F, cexpr_t*> )
+						return invoke( ( cexpr_t* ) item );
+				}
+				else
+				{
+					if constexpr ( CtreeCallableWith<F, cinsn_t*> )
+						return invoke( ( cinsn_t* ) item );
+				}
+				return walk_result::proceed;
+			}
+			else
+			{
+				return invoke( item );
+			}
+		}
+	};
+
+	template<ctype_set Kinds, typename F>
+	inline bool walk_ctree( citem_t* root, F&& functor )
+	{
+		constexpr bool has_exprs = [ ] ()
+		{
+			for ( size_t i = cot_empty; i <= cot_last; i++ )
+				if ( Kinds.test( i ) )
+					return true;
+			return false;
+		}( );
+		if ( !root )
+			return true;
+
+		std::vector<citem_t*> stack;
+		stack.reserve( 64 );
+		stack.push_back( root );
+
+		// Pushes children so that they are popped in their natural order.
+		//
+		auto push = [ & ] ( citem_t* item ) { if ( item ) stack.push_back( item ); };
+		auto push_expr = [ & ] ( cexpr_t* item ) { if constexpr ( has_exprs ) push( item ); };
+
+		while ( !stack.empty() )
+		{
+			citem_t* item = stack.back();
+			stack.pop_back();
+
+			if ( Kinds.test( item->op ) )
+			{
+				walk_result result = detail::invoke_walker( functor, item );
+				if ( result == walk_result::stop )
+					return false;
+				if ( result == walk_result::prune )
+					continue;
+			}
+
+			size_t first = stack.size();
+			if ( item->is_expr() )
+			{
+				auto* e = ( cexpr_t* ) item;
+				if ( e->op == cot_insn )
+				{
+					push( e->insn );
+				}
+				else
+				{
+					if ( op_uses_x( e->op ) ) push( e->x );
+					if ( e->op == cot_call )
+						for ( carg_t& arg : *e->a )
+							push( &arg );
+					if ( op_uses_y( e->op ) ) push( e->y );
+					if ( op_uses_z( e->op ) ) push( e->z );
+				}
+			}
+			else
+			{
+				auto* i = ( cinsn_t* ) item;
+				switch ( i->op )
+				{
+					case cit_block:
+						for ( cinsn_t& sub : *i->cblock )
+							push( &sub );
+						break;
+					case cit_expr:
+						push_expr( i->cexpr );
+						break;
+					case cit_if:
+						push_expr( &i->cif->expr );
+						push( i->cif->ithen );
+						push( i->cif->ielse );
+						break;
+					case cit_for:
+						push_expr( &i->cfor->init );
+						push_expr( &i->cfor->expr );
+						push_expr( &i->cfor->step );
+						push( i->cfor->body );
+						break;
+					case cit_while:
+						push_expr( &i->cwhile->expr );
+						push( i->cwhile->body );
+						break;
+					case cit_do:
+						push( i->cdo->body );
+						push_expr( &i->cdo->expr );
+						break;
+					case cit_switch:
+						push_expr( &i->cswitch->expr );
+						for ( ccase_t& c : i->cswitch->cases )
+							push( &c );
+						break;
+					case cit_return:
+						push_expr( &i->creturn->expr );
+						break;
+					default:
+						break;
+				}
+			}
+			std::reverse( stack.begin() + first, stack.end() );
+		}
+		return true;
+	}
+	template<ctype_t... Kx, typename F>
+	inline bool walk_ctree( citem_t* root, F&& functor ) { return walk_ctree<ctypes<Kx...>>( root, std::forward<F>( functor ) ); }
+};
\ No newline at end of file
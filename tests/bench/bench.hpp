@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <atomic>
+#include <vector>
+#include <string>
+
+// Minimal benchmark harness, every benchmark reports the time and the number of heap allocations per operation.
+//
+namespace bench
+{
+	struct entry
+	{
+		const char* name;
+		void( *fn )();
+	};
+	inline std::vector<entry>& registry() { static std::vector<entry> list; return list; }
+	struct registrar
+	{
+		registrar( const char* name, void( *fn )() ) { registry().push_back( { name, fn } ); }
+	};
+
+	// Counter incremented by the replaced global operator new of the benchmark executable.
+	//
+	inline std::atomic<size_t> allocations = 0;
+
+	// Divisor applied to the iteration counts, set by --quick for smoke runs.
+	//
+	inline size_t scale = 1;
+
+	template<typename T>
+	inline void do_not_optimize( T&& value ) { asm volatile( "" : : "r,m"( value ) : "memory" ); }
+	inline void clobber() { asm volatile( "" : : : "memory" ); }
+
+	// Runs the functor the given number of times after a warm up run and prints the averages.
+	//
+	template<typename F>
+	inline void run( const char* label, size_t iterations, F&& functor )
+	{
+		iterations = std::max<size_t>( iterations / scale, 1 );
+		functor();
+
+		size_t allocs = allocations.load( std::memory_order_relaxed );
+		auto t0 = std::chrono::steady_clock::now();
+		for ( size_t i = 0; i != iterations; i++ )
+			functor();
+		auto t1 = std::chrono::steady_clock::now();
+		allocs = allocations.load( std::memory_order_relaxed ) - allocs;
+
+		double ns = std::chrono::duration<double, std::nano>( t1 - t0 ).count() / iterations;
+		printf( "  %-48s %12.1f ns/op %10.1f allocs/op\n", label, ns, ( double ) allocs / iterations );
+	}
+};
+
+#define BENCHMARK( name )                                                      \
+	static void bench_##name();                                                \
+	static bench::registrar bench_registrar_##name{ #name, &bench_##name };    \
+	static void bench_##name()
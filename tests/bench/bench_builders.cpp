@@ -0,0 +1,81 @@
+#include <hexsuite/architecture.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Instruction construction through the architecture builders against direct SDK calls.
+//
+BENCHMARK( builders )
+{
+	constexpr ea_t ea = 0x1000;
+
+	bench::run( "raw: new minsn_t + make_*", 200000, [ & ]
+	{
+		minsn_t* ins = new minsn_t( ea );
+		ins->opcode = m_add;
+		ins->l.make_reg( 8, 4 );
+		ins->r.make_number( 5, 4 );
+		ins->d.make_reg( 16, 4 );
+		bench::do_not_optimize( ins );
+		delete ins;
+	} );
+	bench::run( "hex::make_add", 200000, [ & ]
+	{
+		auto ins = hex::make_add( ea, hex::reg( 8, 4 ), hex::operand( 5, 4 ), hex::reg( 16, 4 ) );
+		bench::do_not_optimize( ins.get() );
+	} );
+	bench::run( "hex::make<m_add>", 200000, [ & ]
+	{
+		auto ins = hex::make<m_add>( ea, hex::reg( 8, 4 ), hex::operand( 5, 4 ), hex::reg( 16, 4 ) );
+		bench::do_not_optimize( ins.get() );
+	} );
+	bench::run( "nested: make_mov( make_xor( ... ) )", 200000, [ & ]
+	{
+		auto ins = hex::make_mov( ea, hex::make_xor( ea, hex::reg( 8, 4 ), hex::reg( 16, 4 ), hex::reg( 24, 4 ) ), hex::reg( 32, 4 ) );
+		bench::do_not_optimize( ins.get() );
+	} );
+
+	using signature = hex::signature<int32_t( int32_t, int32_t )>;
+	bench::run( "call: hex::call_info( args... )", 100000, [ & ]
+	{
+		auto ci = hex::call_info( tinfo_t{ BT_INT32 }, hex::call_arg{ hex::reg( 8, 4 ), tinfo_t{ BT_INT32 } }, hex::call_arg{ hex::reg( 16, 4 ), tinfo_t{ BT_INT32 } } );
+		bench::do_not_optimize( ci.get() );
+	} );
+	bench::run( "call: hex::signature::call_info", 100000, [ & ]
+	{
+		auto ci = signature::call_info( hex::reg( 8, 4 ), hex::reg( 16, 4 ) );
+		bench::do_not_optimize( ci.get() );
+	} );
+
+	// Building and inserting a run of instructions one by one against an insn_sequence spliced at once, the block is
+	// emptied again after every run.
+	//
+	mba_t* mba = stub::create_mba( 1 );
+	mblock_t* blk = mba->get_mblock( 0 );
+	auto empty = [ & ]
+	{
+		while ( minsn_t* ins = blk->head )
+		{
+			blk->remove_from_block( ins );
+			delete ins;
+		}
+	};
+	bench::run( "64 x insert_into_block", 20000, [ & ]
+	{
+		for ( int i = 0; i != 64; i++ )
+		{
+			auto ins = hex::make_add( ea, hex::reg( 8, 4 ), hex::operand( i, 4 ), hex::reg( 16, 4 ) );
+			blk->insert_into_block( ins.release(), blk->tail );
+			blk->mark_lists_dirty();
+		}
+		empty();
+	} );
+	bench::run( "64 x hex::insn_sequence::emit + append_to", 20000, [ & ]
+	{
+		hex::insn_sequence seq{ ea };
+		for ( int i = 0; i != 64; i++ )
+			seq.emit( m_add, hex::reg( 8, 4 ), hex::operand( i, 4 ), hex::reg( 16, 4 ) );
+		seq.append_to( blk );
+		empty();
+	} );
+	delete mba;
+}
@@ -0,0 +1,58 @@
+#include <vector>
+#include <memory>
+#include <hexsuite/components.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Optimizers each registered as their own optinsn_t against the same optimizers behind the opcode dispatcher.
+//
+static size_t run_all( mba_t* mba )
+{
+	size_t changes = 0;
+	for ( int i = 0; i != mba->qty; i++ )
+		for ( minsn_t* ins = mba->get_mblock( i )->head; ins; ins = ins->next )
+			changes += stub::run_optinsn( mba->get_mblock( i ), ins );
+	return changes;
+}
+
+struct opcode_check
+{
+	mcode_t op;
+	int operator()( mblock_t*, minsn_t* ins, int ) const { return ins->opcode == op && ins->l.t == mop_z; }
+};
+
+BENCHMARK( components )
+{
+	auto mba = fixture::flattened( 64, 16 );
+	static constexpr mcode_t targets[] = { m_xor, m_sub, m_or, m_and, m_shl, m_mul, m_add, m_neg };
+
+	for ( size_t count : { 8, 32 } )
+	{
+		using plain_t = hex::insn_optimizer<opcode_check>;
+		std::vector<std::unique_ptr<plain_t>> plain;
+		for ( size_t i = 0; i != count; i++ )
+		{
+			mcode_t op = targets[ i % std::size( targets ) ];
+			plain.push_back( std::make_unique<plain_t>( opcode_check{ op } ) );
+			plain.back()->install();
+		}
+		char label[ 64 ];
+		snprintf( label, sizeof( label ), "%zu x insn_optimizer", count );
+		bench::run( label, 2000, [ & ] { bench::do_not_optimize( run_all( mba.get() ) ); } );
+		for ( auto& p : plain )
+			p->uninstall();
+
+		using dispatched_t = hex::opcode_optimizer<opcode_check>;
+		std::vector<std::unique_ptr<dispatched_t>> dispatched;
+		for ( size_t i = 0; i != count; i++ )
+		{
+			mcode_t op = targets[ i % std::size( targets ) ];
+			dispatched.push_back( std::make_unique<dispatched_t>( hex::opcode_set{ std::in_place, op }, opcode_check{ op } ) );
+			dispatched.back()->install();
+		}
+		snprintf( label, sizeof( label ), "%zu x opcode_optimizer", count );
+		bench::run( label, 2000, [ & ] { bench::do_not_optimize( run_all( mba.get() ) ); } );
+		for ( auto& d : dispatched )
+			d->uninstall();
+	}
+}
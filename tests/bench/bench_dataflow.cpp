@@ -0,0 +1,73 @@
+#include <hexsuite/dataflow.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Worklist liveness against round-robin iteration over the blocks in their natural order until nothing changes, both
+// sharing the block use/def sets.
+//
+BENCHMARK( dataflow )
+{
+	for ( int states : { 16, 256 } )
+	{
+		auto mba = fixture::flattened( states, 16 );
+		hex::cfg_order order{ mba.get() };
+		hex::liveness live{ mba.get(), order };
+		size_t n = live.locations.size();
+		hex::dense_bitset everything{ n };
+		everything.set_range( 0, n );
+
+		auto transfer = [ & ] ( mblock_t* blk, const hex::dense_bitset& out, hex::dense_bitset& in )
+		{
+			in = out;
+			in.subtract( live.def[ blk->serial ] );
+			in.merge( live.use[ blk->serial ] );
+		};
+		auto meet = [ ] ( hex::dense_bitset& acc, const hex::dense_bitset& x ) { acc.merge( x ); };
+
+		size_t worklist_visits = 0, round_robin_visits = 0;
+		char label[ 64 ];
+		snprintf( label, sizeof( label ), "liveness %d states: worklist", states );
+		bench::run( label, 2000, [ & ]
+		{
+			hex::dataflow_solver<hex::direction::backward, hex::dense_bitset, decltype( transfer ), decltype( meet )> solver{ mba.get(), order, transfer, meet };
+			solver.solve( everything, hex::dense_bitset{ n } );
+			worklist_visits = solver.iterations;
+			bench::do_not_optimize( solver.in.data() );
+		} );
+		snprintf( label, sizeof( label ), "liveness %d states: round-robin", states );
+		bench::run( label, 2000, [ & ]
+		{
+			std::vector<hex::dense_bitset> in( mba->qty, hex::dense_bitset{ n } ), out( mba->qty, hex::dense_bitset{ n } );
+			round_robin_visits = 0;
+			for ( bool changed = true; changed; )
+			{
+				changed = false;
+				for ( int i = mba->qty - 1; i >= 0; i-- )
+				{
+					mblock_t* blk = mba->get_mblock( i );
+					round_robin_visits++;
+					if ( blk->succset.empty() )
+						out[ i ] = everything;
+					for ( int succ : blk->succset )
+						out[ i ].merge( in[ succ ] );
+					hex::dense_bitset result{ n };
+					transfer( blk, out[ i ], result );
+					if ( result != in[ i ] )
+					{
+						in[ i ] = std::move( result );
+						changed = true;
+					}
+				}
+			}
+			bench::do_not_optimize( in.data() );
+		} );
+		printf( "    block visits: worklist %zu, round-robin %zu\n", worklist_visits, round_robin_visits );
+
+		snprintf( label, sizeof( label ), "liveness %d states: hex::liveness", states );
+		bench::run( label, 200, [ & ]
+		{
+			hex::liveness result{ mba.get(), order };
+			bench::do_not_optimize( result.live_in.data() );
+		} );
+	}
+}
@@ -0,0 +1,31 @@
+#include <hexsuite/evaluator.hpp>
+#include <hexsuite/expressions.hpp>
+#include "bench.hpp"
+
+// Evaluation of a small expression tree, single vectors and full batches reuse the per-thread slot buffer.
+//
+BENCHMARK( evaluator )
+{
+	// ((r8 ^ r16) + 5) & (r8 | r16)
+	//
+	auto e = ( ( hex::x<4>( hex::reg( 8, 4 ) ) ^ hex::x<4>( hex::reg( 16, 4 ) ) ) + 5 ) & ( hex::x<4>( hex::reg( 8, 4 ) ) | hex::x<4>( hex::reg( 16, 4 ) ) );
+	auto ins = hex::build( 0x1000, e, hex::reg( 24, 4 ) );
+	hex::evaluator ev{ ins.get() };
+
+	uint64_t values[] = { 0x1234, 0x5678 };
+	bench::run( "evaluate: 1 vector", 200000, [ & ]
+	{
+		values[ 0 ]++;
+		bench::do_not_optimize( ev.evaluate( values ) );
+	} );
+
+	std::vector<uint64_t> a( 1024 ), b( 1024 ), out( 1024 );
+	for ( size_t i = 0; i != a.size(); i++ )
+		a[ i ] = i * 0x9E3779B97F4A7C15ull, b[ i ] = ~a[ i ];
+	const uint64_t* columns[] = { a.data(), b.data() };
+	bench::run( "evaluate: 1024 vectors", 20000, [ & ]
+	{
+		ev.evaluate( columns, out.data(), out.size() );
+		bench::do_not_optimize( out.data() );
+	} );
+}
@@ -0,0 +1,33 @@
+#include <hexsuite/hash.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Structural hashing of every instruction of a function and memoized simplification of a stream with repeats.
+//
+BENCHMARK( hash )
+{
+	auto mba = fixture::flattened( 64, 16 );
+	std::vector<minsn_t*> insns;
+	for ( int i = 0; i != mba->qty; i++ )
+		for ( minsn_t* ins = mba->get_mblock( i )->head; ins; ins = ins->next )
+			insns.push_back( ins );
+
+	bench::run( "hash_insn: flattened 64 states", 2000, [ & ]
+	{
+		uint64_t h = 0;
+		for ( minsn_t* ins : insns )
+			h ^= hex::hash_insn( *ins );
+		bench::do_not_optimize( h );
+	} );
+
+	hex::memo_cache cache{ 1024 };
+	bench::run( "memo_cache: simplify", 2000, [ & ]
+	{
+		for ( minsn_t* ins : insns )
+		{
+			minsn_t copy = *ins;
+			cache.simplify( &copy, [ ] ( const minsn_t* ) { return std::unique_ptr<minsn_t>{}; } );
+		}
+	} );
+	printf( "    hit rate %.1f%%, %llu collisions\n", cache.stats.hit_rate() * 100, ( unsigned long long ) cache.stats.collisions );
+}
@@ -0,0 +1,75 @@
+#include <tuple>
+#include <hexsuite/patterns.hpp>
+#include <hexsuite/expressions.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+using namespace hex::pat;
+
+// A rule set of common peephole and MBA rules matched over a corpus of flattened code with nested MBA expressions,
+// through the rule set's dispatch tables against trying every rule in turn. Rewrites only count matches so that the
+// corpus stays the same between runs.
+//
+BENCHMARK( patterns )
+{
+	size_t hits = 0;
+	auto count = [ &hits ] ( minsn_t*, captures& ) { hits++; return false; };
+	rule_set rules{
+		rule<insn<m_xor, cap<0>, cap<0>>>( count ),
+		rule<insn<m_sub, cap<0>, cap<0>>>( count ),
+		rule<insn<m_and, cap<0>, num<0>>>( count ),
+		rule<insn<m_or, cap<0>, num<0>>>( count ),
+		rule<insn<m_mul, cap<0>, num<1>>>( count ),
+		rule<insn<m_add, insn<m_xor, cap<0>, cap<1>>, insn<m_mul, num<2>, insn<m_and, cap<0>, cap<1>>>>>( count ),
+		rule<insn<m_sub, insn<m_or, cap<0>, cap<1>>, insn<m_and, cap<0>, cap<1>>>>( count ),
+		rule<insn<m_add, insn<m_and, cap<0>, cap<1>>, insn<m_or, cap<0>, cap<1>>>>( count ),
+	};
+
+	// Corpus, every state block of the flattened function additionally gets a few MBA expressions.
+	//
+	auto mba = fixture::flattened( 64, 16 );
+	mop_t a, b;
+	a.make_reg( 8, 4 );
+	b.make_reg( 16, 4 );
+	for ( int i = 2; i != mba->qty - 1; i++ )
+	{
+		hex::insn_sequence seq{ mba->get_mblock( i )->start };
+		seq.append( hex::make_mov( seq.ea, hex::build_operand( seq.ea, ( hex::x( a ) ^ hex::x( b ) ) + 2 * ( hex::x( a ) & hex::x( b ) ) ), hex::reg( 24, 4 ) ) );
+		seq.append( hex::make_mov( seq.ea, hex::build_operand( seq.ea, ( hex::x( a ) | hex::x( b ) ) - ( hex::x( a ) & hex::x( b ) ) ), hex::reg( 24, 4 ) ) );
+		seq.append( hex::build( seq.ea, hex::x( a ) ^ hex::x( a ), hex::reg( 24, 4 ) ) );
+		seq.append_to( mba->get_mblock( i ) );
+	}
+	auto each_insn = [ & ] ( auto&& functor )
+	{
+		for ( int i = 0; i != mba->qty; i++ )
+			for ( minsn_t* ins = mba->get_mblock( i )->head; ins; ins = ins->next )
+				functor( mba->get_mblock( i ), ins );
+	};
+
+	auto sequential = [ & ] ( minsn_t* ins )
+	{
+		return std::apply( [ & ] ( auto&... r )
+		{
+			bool changed = false;
+			( ( changed = changed || [ & ] { captures c = {}; return std::remove_cvref_t<decltype( r )>::pattern::match_insn( ins, c ) && r.rewrite( ins, c ); }( ) ), ... );
+			return changed;
+		}, rules.rules );
+	};
+	bench::run( "top-level: every rule in turn", 2000, [ & ]
+	{
+		each_insn( [ & ] ( mblock_t*, minsn_t* ins ) { sequential( ins ); } );
+	} );
+	bench::run( "top-level: rule_set::apply", 2000, [ & ]
+	{
+		each_insn( [ & ] ( mblock_t* blk, minsn_t* ins ) { rules.apply( blk, ins ); } );
+	} );
+	bench::run( "nested: every rule in turn", 2000, [ & ]
+	{
+		each_insn( [ & ] ( mblock_t*, minsn_t* ins ) { ins->for_all_insns( hex::minsn_visitor( [ & ] ( minsn_t* sub ) { return ( int ) sequential( sub ); } ) ); } );
+	} );
+	bench::run( "nested: rule_set::apply_nested", 2000, [ & ]
+	{
+		each_insn( [ & ] ( mblock_t* blk, minsn_t* ins ) { rules.apply_nested( blk, ins ); } );
+	} );
+	bench::do_not_optimize( hits );
+}
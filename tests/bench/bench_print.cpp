@@ -0,0 +1,36 @@
+#include <hexsuite/print.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Printing helpers, allocating to_string against the buffer reusing overload and streaming dumps.
+//
+BENCHMARK( print )
+{
+	auto mba = fixture::flattened( 64, 16 );
+	minsn_t* ins = mba->get_mblock( 2 )->head;
+
+	bench::run( "hex::to_string( minsn_t* )", 100000, [ & ]
+	{
+		std::string s = hex::to_string( ins );
+		bench::do_not_optimize( s.data() );
+	} );
+	std::string out;
+	bench::run( "hex::to_string( minsn_t*, out )", 100000, [ & ]
+	{
+		out.clear();
+		hex::to_string( ins, out );
+		bench::do_not_optimize( out.data() );
+	} );
+	bench::run( "hex::to_string( minsn_t*, out, strip )", 100000, [ & ]
+	{
+		out.clear();
+		hex::to_string( ins, out, true );
+		bench::do_not_optimize( out.data() );
+	} );
+	bench::run( "hex::dump( mba_t* )", 500, [ & ]
+	{
+		size_t n = 0;
+		hex::dump( mba.get(), [ & ] ( std::string_view chunk ) { n += chunk.size(); } );
+		bench::do_not_optimize( n );
+	} );
+}
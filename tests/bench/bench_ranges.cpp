@@ -0,0 +1,43 @@
+#include <hexsuite/ranges.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Range adaptors against the hand written loops they replace.
+//
+BENCHMARK( ranges )
+{
+	auto mba = fixture::flattened( 256, 16 );
+
+	bench::run( "instructions: raw next loop", 20000, [ & ]
+	{
+		for ( int i = 0; i != mba->qty; i++ )
+			for ( minsn_t* ins = mba->get_mblock( i )->head; ins; ins = ins->next )
+				bench::do_not_optimize( ins );
+	} );
+	bench::run( "instructions: hex::instructions", 20000, [ & ]
+	{
+		for ( mblock_t* blk : hex::basic_blocks( mba.get() ) )
+			for ( minsn_t* ins : hex::instructions( blk ) )
+				bench::do_not_optimize( ins );
+	} );
+	bench::run( "successors: raw succset loop", 20000, [ & ]
+	{
+		for ( int i = 0; i != mba->qty; i++ )
+		{
+			mblock_t* blk = mba->get_mblock( i );
+			for ( int j = 0; j != blk->nsucc(); j++ )
+				bench::do_not_optimize( mba->get_mblock( blk->succ( j ) ) );
+		}
+	} );
+	bench::run( "successors: hex::successors", 20000, [ & ]
+	{
+		for ( mblock_t* blk : hex::basic_blocks( mba.get() ) )
+			for ( mblock_t* succ : hex::successors( blk ) )
+				bench::do_not_optimize( succ );
+	} );
+	bench::run( "hex::reverse_post_order", 20000, [ & ]
+	{
+		for ( mblock_t* blk : hex::reverse_post_order( mba.get() ) )
+			bench::do_not_optimize( blk );
+	} );
+}
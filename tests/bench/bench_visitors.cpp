@@ -0,0 +1,50 @@
+#include <hexsuite/visitors.hpp>
+#include "bench.hpp"
+#include "../fixtures.hpp"
+
+// Lambda visitors against hand written visitor classes.
+//
+BENCHMARK( visitors )
+{
+	auto mba = fixture::flattened( 256, 16 );
+
+	struct counting_visitor : minsn_visitor_t
+	{
+		size_t n = 0;
+		int idaapi visit_minsn() override { n += curins->opcode == m_add; return 0; }
+	};
+	bench::run( "minsn: minsn_visitor_t subclass", 5000, [ & ]
+	{
+		counting_visitor v;
+		mba->for_all_insns( v );
+		bench::do_not_optimize( v.n );
+	} );
+	bench::run( "minsn: hex::minsn_visitor", 5000, [ & ]
+	{
+		size_t n = 0;
+		mba->for_all_insns( hex::minsn_visitor( [ & ] ( minsn_t* ins ) { n += ins->opcode == m_add; return 0; } ) );
+		bench::do_not_optimize( n );
+	} );
+	bench::run( "mop: hex::mop_visitor", 5000, [ & ]
+	{
+		size_t n = 0;
+		for ( int i = 0; i != mba->qty; i++ )
+			for ( minsn_t* ins = mba->get_mblock( i )->head; ins; ins = ins->next )
+				ins->for_all_ops( hex::mop_visitor( [ & ] ( mop_t* op, const tinfo_t*, bool ) { n += op->t == mop_r; return 0; } ) );
+		bench::do_not_optimize( n );
+	} );
+
+	auto tree = fixture::body( 4096 );
+	bench::run( "ctree: hex::ctree_pre_visitor", 2000, [ & ]
+	{
+		size_t n = 0;
+		hex::ctree_pre_visitor( [ & ] ( cexpr_t* e ) { n += e->op == cot_var; return 0; } ).apply_to( tree->root, nullptr );
+		bench::do_not_optimize( n );
+	} );
+	bench::run( "ctree: hex::walk_ctree<cot_var>", 2000, [ & ]
+	{
+		size_t n = 0;
+		hex::walk_ctree<cot_var>( tree->root, [ & ] ( cexpr_t* ) { n++; } );
+		bench::do_not_optimize( n );
+	} );
+}
@@ -0,0 +1,35 @@
+#include <new>
+#include <cstdlib>
+#include "bench.hpp"
+
+// Counting allocator.
+//
+void* operator new( size_t n )
+{
+	bench::allocations.fetch_add( 1, std::memory_order_relaxed );
+	if ( void* p = malloc( n ? n : 1 ) )
+		return p;
+	throw std::bad_alloc{};
+}
+void operator delete( void* p ) noexcept { free( p ); }
+void operator delete( void* p, size_t ) noexcept { free( p ); }
+
+int main( int argc, const char** argv )
+{
+	const char* filter = nullptr;
+	for ( int i = 1; i != argc; i++ )
+	{
+		if ( !strcmp( argv[ i ], "--quick" ) )
+			bench::scale = 1000;
+		else
+			filter = argv[ i ];
+	}
+	for ( auto& [name, fn] : bench::registry() )
+	{
+		if ( filter && !strstr( name, filter ) )
+			continue;
+		printf( "%s\n", name );
+		fn();
+	}
+	return 0;
+}
@@ -0,0 +1,158 @@
+#pragma once
+#include <deque>
+#include <memory>
+#include <hexrays.hpp>
+
+// Synthetic microcode and ctree inputs shared by the tests and the benchmarks.
+//
+namespace fixture
+{
+	using mba_ptr = std::unique_ptr<mba_t>;
+
+	// Appends "op #k, reg, reg" style instructions to a block, cycling through a handful of opcodes and registers.
+	//
+	inline minsn_t* emit( mblock_t* blk, mcode_t opcode, int l, int r, int d, int size = 4 )
+	{
+		minsn_t* ins = new minsn_t( blk->start + ( blk->tail ? 4 : 0 ) );
+		ins->opcode = opcode;
+		if ( l >= 0 ) ins->l.make_reg( l * 8, size );
+		if ( r >= 0 ) ins->r.make_number( ( uint64 ) r, size );
+		if ( d >= 0 ) ins->d.make_reg( d * 8, size );
+		return blk->insert_into_block( ins, blk->tail );
+	}
+	inline void fill( mblock_t* blk, int count, int seed = 0 )
+	{
+		static constexpr mcode_t opcodes[] = { m_mov, m_add, m_xor, m_sub, m_and, m_or, m_mul, m_shl };
+		for ( int i = 0; i != count; i++ )
+		{
+			mcode_t op = opcodes[ ( i + seed ) % std::size( opcodes ) ];
+			int a = ( i + seed ) % 6, b = ( i * 3 + seed + 1 ) % 6;
+			if ( op == m_mov )
+				emit( blk, op, a, -1, b );
+			else
+				emit( blk, op, a, i + 1, b );
+		}
+	}
+
+	// Straight line function of blocks each falling through to the next.
+	//
+	inline mba_ptr chain( int blocks, int insns_per_block )
+	{
+		mba_ptr mba{ stub::create_mba( blocks ) };
+		for ( int i = 0; i != blocks; i++ )
+		{
+			fill( mba->get_mblock( i ), insns_per_block, i );
+			if ( i + 1 != blocks )
+				stub::add_edge( mba.get(), i, i + 1 );
+		}
+		return mba;
+	}
+
+	// Control flow flattened function: entry -> dispatcher -> one of the state blocks -> dispatcher, with the last
+	// state leaving to the exit block. Every state reads and writes the state register, the dispatcher compares it.
+	//
+	inline mba_ptr flattened( int states, int insns_per_state )
+	{
+		int dispatcher = 1, exit = states + 2;
+		mba_ptr mba{ stub::create_mba( states + 3 ) };
+		fill( mba->get_mblock( 0 ), insns_per_state );
+		emit( mba->get_mblock( 0 ), m_mov, -1, -1, 7 )->l.make_number( 0, 4 );
+		stub::add_edge( mba.get(), 0, dispatcher );
+		for ( int i = 0; i != states; i++ )
+			emit( mba->get_mblock( dispatcher ), m_setz, 7, i, 6, 4 );
+		for ( int i = 0; i != states; i++ )
+		{
+			mblock_t* blk = mba->get_mblock( i + 2 );
+			stub::add_edge( mba.get(), dispatcher, i + 2 );
+			fill( blk, insns_per_state, i );
+			emit( blk, m_add, 7, 1, 7 );
+			stub::add_edge( mba.get(), i + 2, i + 1 == states ? exit : dispatcher );
+		}
+		emit( mba->get_mblock( exit ), m_mov, 0, -1, 0 );
+		return mba;
+	}
+
+	// Owner of a synthetic ctree, nodes live until the tree is destroyed.
+	//
+	struct ctree
+	{
+		std::deque<cexpr_t> exprs;
+		std::deque<cinsn_t> insns;
+		std::deque<cblock_t> blocks;
+		std::deque<cif_t> ifs;
+		std::deque<cnumber_t> numbers;
+		cinsn_t* root = nullptr;
+
+		cexpr_t* var( int idx )
+		{
+			cexpr_t* e = &exprs.emplace_back();
+			e->op = cot_var;
+			e->v = { nullptr, idx };
+			return e;
+		}
+		cexpr_t* num( uint64 v )
+		{
+			cexpr_t* e = &exprs.emplace_back();
+			e->op = cot_num;
+			e->n = &numbers.emplace_back( cnumber_t{ v } );
+			return e;
+		}
+		cexpr_t* binary( ctype_t op, cexpr_t* x, cexpr_t* y )
+		{
+			cexpr_t* e = &exprs.emplace_back();
+			e->op = op;
+			e->x = x;
+			e->y = y;
+			return e;
+		}
+		cinsn_t* expr( cexpr_t* x )
+		{
+			cinsn_t* i = &insns.emplace_back();
+			i->op = cit_expr;
+			i->cexpr = x;
+			return i;
+		}
+		cinsn_t* block()
+		{
+			cinsn_t* i = &insns.emplace_back();
+			i->op = cit_block;
+			i->cblock = &blocks.emplace_back();
+			return i;
+		}
+		cinsn_t* if_( cexpr_t* cond, cinsn_t* then, cinsn_t* otherwise = nullptr )
+		{
+			cinsn_t* i = &insns.emplace_back();
+			i->op = cit_if;
+			i->cif = &ifs.emplace_back();
+			i->cif->expr = *cond;
+			i->cif->ithen = then;
+			i->cif->ielse = otherwise;
+			return i;
+		}
+	};
+
+	// Function body of the given number of statements, alternating between "vN = vN + k" assignments and if
+	// statements nesting a block of two assignments.
+	//
+	inline std::unique_ptr<ctree> body( int statements )
+	{
+		auto tree = std::make_unique<ctree>();
+		tree->root = tree->block();
+		auto assign = [ & ] ( int i ) { return tree->expr( tree->binary( cot_asg, tree->var( i % 8 ), tree->binary( cot_add, tree->var( ( i + 1 ) % 8 ), tree->num( i ) ) ) ); };
+		for ( int i = 0; i != statements; i++ )
+		{
+			if ( i % 4 != 3 )
+			{
+				tree->root->cblock->push_back( *assign( i ) );
+			}
+			else
+			{
+				cinsn_t* then = tree->block();
+				then->cblock->push_back( *assign( i ) );
+				then->cblock->push_back( *assign( i + 1 ) );
+				tree->root->cblock->push_back( *tree->if_( tree->binary( cot_ult, tree->var( i % 8 ), tree->num( i ) ), then ) );
+			}
+		}
+		return tree;
+	}
+};
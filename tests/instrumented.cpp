@@ -0,0 +1,7 @@
+// Builds the umbrella header with every optional instrumentation enabled.
+//
+#define HEXSUITE_PROFILE 1
+#define HEXSUITE_PROFILE_HISTOGRAM 1
+#define HEXSUITE_TRACE 1
+#define HEXSUITE_TRACE_HASH 1
+#include <hexsuite.hpp>
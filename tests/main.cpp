@@ -0,0 +1,20 @@
+#include <cstring>
+#include "test.hpp"
+#include <hexrays.hpp>
+
+int main( int argc, const char** argv )
+{
+	size_t ran = 0;
+	for ( auto& [name, fn] : test::registry() )
+	{
+		if ( argc > 1 && !strstr( name, argv[ 1 ] ) )
+			continue;
+		int before = test::failures;
+		stub::reset();
+		fn();
+		printf( "%s %s\n", test::failures == before ? "[ OK ]" : "[FAIL]", name );
+		ran++;
+	}
+	printf( "%zu tests, %d failed checks\n", ran, test::failures );
+	return test::failures ? 1 : 0;
+}
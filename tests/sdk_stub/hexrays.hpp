@@ -0,0 +1,1041 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdarg>
+#include <cstring>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <map>
+#include <iterator>
+#include <utility>
+#include <sys/types.h>
+
+// Offline stand-in for the subset of the IDA / Hex-Rays SDK used by HexSuite, so that the library can be built, tested
+// and benchmarked without an IDA installation. Only the shapes HexSuite touches are declared; the behaviour is a
+// simplified model backed by the in-memory database in namespace stub, not the decompiler.
+//
+#define idaapi
+#define AS_PRINTF( a, b )
+
+// Basic types.
+//
+typedef uint64_t ea_t;
+typedef uint64_t uval_t;
+typedef int64_t sval_t;
+typedef uint64_t uint64;
+typedef int64_t int64;
+typedef uint32_t uint32;
+typedef uint16_t uint16;
+typedef uint8_t uint8;
+typedef uint8_t uchar;
+typedef uint8_t type_t;
+typedef uint8_t p_list;
+typedef int mreg_t;
+
+constexpr ea_t BADADDR = ~ea_t( 0 );
+constexpr int NOSIZE = -1;
+constexpr mreg_t mr_none = -1;
+
+// Containers.
+//
+struct qstring
+{
+	std::string s;
+
+	qstring() = default;
+	qstring( const char* p ) : s( p ) {}
+	qstring( const char* p, size_t n ) : s( p, n ) {}
+
+	const char* c_str() const { return s.c_str(); }
+	size_t size() const { return s.empty() ? 0 : s.size() + 1; }   // Includes the terminator like qvector.
+	size_t length() const { return s.size(); }
+	bool empty() const { return s.empty(); }
+	size_t capacity() const { return s.capacity(); }
+	char* begin() { return s.data(); }
+	char* end() { return s.data() + s.size(); }
+	const char* begin() const { return s.data(); }
+	const char* end() const { return s.data() + s.size(); }
+	char& operator[]( size_t i ) { return s[ i ]; }
+	char operator[]( size_t i ) const { return s[ i ]; }
+
+	void clear() { s.clear(); }
+	void qclear() { s.clear(); }
+	void resize( size_t n ) { s.resize( n ); }
+	void reserve( size_t n ) { s.reserve( n ); }
+	void swap( qstring& o ) { s.swap( o.s ); }
+	qstring& append( const char* p, size_t n ) { s.append( p, n ); return *this; }
+	qstring& append( char c ) { s += c; return *this; }
+	qstring& operator+=( const qstring& o ) { s += o.s; return *this; }
+	bool operator==( const qstring& o ) const { return s == o.s; }
+
+	size_t cat_vsprnt( const char* format, va_list va );
+	size_t cat_sprnt( const char* format, ... );
+};
+template<typename T>
+struct qvector : std::vector<T>
+{
+	using std::vector<T>::vector;
+	void add( const T& v ) { this->push_back( v ); }
+	bool has( const T& v ) const
+	{
+		for ( auto& x : *this )
+			if ( x == v )
+				return true;
+		return false;
+	}
+	void qclear() { this->clear(); }
+};
+template<typename T>
+struct qlist : std::vector<T> {};
+struct intvec_t : qvector<int> {};
+typedef qvector<ea_t> eavec_t;
+typedef qvector<uint64> uint64vec_t;
+
+// Types, a tinfo_t is modelled as its serialized type string.
+//
+constexpr type_t BT_UNK = 0x00, BT_VOID = 0x01, BT_INT8 = 0x02, BT_INT16 = 0x03, BT_INT32 = 0x04, BT_INT64 = 0x05,
+	BT_INT128 = 0x06, BT_INT = 0x07, BT_BOOL = 0x08, BT_FLOAT = 0x09, BT_PTR = 0x0A, BT_TYPE_MASK = 0x0F;
+constexpr type_t BTMT_SIGNED = 0x10, BTMT_UNSIGNED = 0x20, BTMT_CHAR = 0x30, BTMT_DOUBLE = 0x10, BTMT_BOOL1 = 0x10, BTMT_BOOL4 = 0x30;
+constexpr type_t BTF_VOID = 0x01, BTF_INT8 = 0x12, BTF_INT16 = 0x13, BTF_INT32 = 0x14, BTF_INT64 = 0x15, BTF_UINT8 = 0x22,
+	BTF_UINT16 = 0x23, BTF_UINT32 = 0x24, BTF_UINT64 = 0x25, BTF_CHAR = 0x32, BTF_UCHAR = 0x22, BTF_SINT = 0x17, BTF_UINT = 0x27,
+	BTF_BOOL = 0x08, BTF_FLOAT = 0x09, BTF_DOUBLE = 0x19, BTF_TYPEDEF = 0x3D, BT_UNK_BYTE = 0x11;
+typedef uint8_t cm_t;
+constexpr cm_t CM_CC_CDECL = 0x30, CM_CC_STDCALL = 0x50, CM_CC_FASTCALL = 0x70;
+constexpr int NTF_TYPE = 0x01, NTF_SYMM = 0x00;
+
+struct til_t {};
+struct func_type_data_t;
+struct tinfo_t
+{
+	std::string repr;
+
+	tinfo_t() = default;
+	tinfo_t( type_t t ) : repr( 1, ( char ) t ) {}
+
+	bool empty() const { return repr.empty(); }
+	bool is_void() const { return repr.size() == 1 && ( type_t ) repr[ 0 ] == BTF_VOID; }
+	size_t get_size() const;
+	bool create_ptr( const tinfo_t& target );
+	bool get_numbered_type( const til_t* til, uint32 ordinal, type_t decl_type = 0, bool resolve = true );
+	bool get_named_type( const til_t* til, const char* name, type_t decl_type = 0, bool resolve = true );
+	bool print( qstring* out, const char* name = nullptr, int flags = 0 ) const;
+	bool serialize( qstring* type, qstring* fields = nullptr, qstring* fldcmts = nullptr, int flags = 0 ) const;
+	bool operator==( const tinfo_t& o ) const { return repr == o.repr; }
+};
+const til_t* get_idati();
+uint32 get_ordinal_qty( const til_t* til );
+const char* get_numbered_type_name( const til_t* til, uint32 ordinal );
+const char* first_named_type( const til_t* til, int flags );
+const char* next_named_type( const til_t* til, const char* name, int flags );
+bool get_tinfo( tinfo_t* out, ea_t ea );
+
+// Location lists.
+//
+struct bitset_t
+{
+	std::vector<uint64_t> words;
+	bool has( int bit ) const { return ( size_t ) bit / 64 < words.size() && ( ( words[ bit / 64 ] >> ( bit % 64 ) ) & 1 ); }
+	bool empty() const
+	{
+		for ( uint64_t w : words )
+			if ( w )
+				return false;
+		return true;
+	}
+	bool add( int bit )
+	{
+		if ( has( bit ) )
+			return false;
+		if ( ( size_t ) bit / 64 >= words.size() )
+			words.resize( bit / 64 + 1 );
+		words[ bit / 64 ] |= 1ull << ( bit % 64 );
+		return true;
+	}
+	bool add( int bit, int width )
+	{
+		bool added = false;
+		for ( int i = bit; i < bit + width; i++ )
+			added |= add( i );
+		return added;
+	}
+	int last() const
+	{
+		for ( size_t i = words.size(); i != 0; i-- )
+			if ( words[ i - 1 ] )
+				return int( ( i - 1 ) * 64 + 63 - __builtin_clzll( words[ i - 1 ] ) );
+		return -1;
+	}
+
+	// Iteration over the set bits, end() is one past the highest bit the set can hold.
+	//
+	struct iterator
+	{
+		int i;
+		iterator( int n = -1 ) : i( n ) {}
+		bool operator==( const iterator& n ) const { return i == n.i; }
+		bool operator!=( const iterator& n ) const { return i != n.i; }
+		int operator*() const { return i; }
+	};
+	using const_iterator = iterator;
+	iterator itat( int n ) const { return iterator( goup( n ) ); }
+	iterator begin() const { return itat( 0 ); }
+	iterator end() const { return iterator( ( int ) words.size() * 64 ); }
+	void inc( iterator& p, int n = 1 ) const { p.i = goup( p.i + n ); }
+	int goup( int reg ) const
+	{
+		for ( size_t i = ( size_t ) reg / 64; i < words.size(); i++ )
+		{
+			uint64_t w = words[ i ] & ( i == ( size_t ) reg / 64 ? ~0ull << ( reg % 64 ) : ~0ull );
+			if ( w )
+				return int( i * 64 + __builtin_ctzll( w ) );
+		}
+		return ( int ) words.size() * 64;
+	}
+};
+struct rlist_t : bitset_t {};
+struct ivl_t
+{
+	uval_t off;
+	uval_t size;
+};
+struct ivlset_t : qvector<ivl_t>
+{
+	bool add( const ivl_t& ivl ) { push_back( ivl ); return true; }
+};
+struct mlist_t
+{
+	rlist_t reg;
+	ivlset_t mem;
+
+	bool empty() const { return reg.empty() && mem.empty(); }
+	bool add( const mlist_t& o )
+	{
+		bool added = false;
+		for ( int i = 0, last = o.reg.last(); i <= last; i++ )
+			if ( o.reg.has( i ) )
+				added |= reg.add( i );
+		for ( const ivl_t& ivl : o.mem )
+			added |= mem.add( ivl );
+		return added;
+	}
+};
+
+// Microcode.
+//
+enum mba_maturity_t { MMAT_ZERO, MMAT_GENERATED, MMAT_PREOPTIMIZED, MMAT_LOCOPT, MMAT_CALLS, MMAT_GLBOPT1, MMAT_GLBOPT2, MMAT_GLBOPT3, MMAT_LVARS };
+enum mcode_t : uint8_t
+{
+	m_nop, m_stx, m_ldx, m_ldc, m_mov, m_neg, m_lnot, m_bnot, m_xds, m_xdu, m_low, m_high, m_add, m_sub, m_mul, m_udiv,
+	m_sdiv, m_umod, m_smod, m_or, m_and, m_xor, m_shl, m_shr, m_sar, m_cfadd, m_ofadd, m_cfshl, m_cfshr, m_sets, m_seto,
+	m_setp, m_setnz, m_setz, m_setae, m_setb, m_seta, m_setbe, m_setg, m_setge, m_setl, m_setle, m_jcnd, m_jnz, m_jz,
+	m_jae, m_jb, m_ja, m_jbe, m_jg, m_jge, m_jl, m_jle, m_jtbl, m_ijmp, m_goto, m_call, m_icall, m_ret, m_push, m_pop,
+	m_und, m_ext, m_f2i, m_f2u, m_i2f, m_u2f, m_f2f, m_fneg, m_fadd, m_fsub, m_fmul, m_fdiv
+};
+typedef uint8_t mopt_t;
+constexpr mopt_t mop_z = 0, mop_r = 1, mop_n = 2, mop_str = 3, mop_d = 4, mop_S = 5, mop_v = 6, mop_b = 7, mop_f = 8,
+	mop_l = 9, mop_a = 10, mop_h = 11, mop_c = 12, mop_fn = 13, mop_p = 14, mop_sc = 15;
+constexpr int SHINS_SHORT = 0x02;
+constexpr int EQ_IGNSIZE = 0x01, EQ_IGNCODE = 0x02, EQ_CMPDEST = 0x04, EQ_OPTINSN = 0x08;
+
+struct minsn_t;
+struct mblock_t;
+struct mba_t;
+struct mcallinfo_t;
+struct mcases_t;
+struct mop_pair_t;
+struct mop_addr_t;
+struct mop_visitor_t;
+struct minsn_visitor_t;
+
+struct mnumber_t
+{
+	uint64 value;
+	uint64 org_value;
+};
+struct fnumber_t
+{
+	uint16 fnum[ 6 ];
+	int nbytes;
+};
+struct stkvar_ref_t
+{
+	mba_t* const mba;
+	sval_t off;
+};
+struct lvar_ref_t
+{
+	mba_t* const mba;
+	sval_t off;
+	int idx;
+};
+
+// Operands own the objects they point to, copies are deep.
+//
+struct mop_t
+{
+	mopt_t t;
+	uint8 oprops;
+	uint16 valnum;
+	int size;
+	union
+	{
+		mreg_t r;
+		mnumber_t* nnn;
+		minsn_t* d;
+		stkvar_ref_t* s;
+		ea_t g;
+		int b;
+		mcallinfo_t* f;
+		lvar_ref_t* l;
+		mop_addr_t* a;
+		char* helper;
+		char* cstr;
+		mcases_t* c;
+		fnumber_t* fpc;
+		mop_pair_t* pair;
+		void* scif;
+	};
+
+	mop_t();
+	mop_t( const mop_t& o );
+	mop_t& operator=( const mop_t& o );
+	~mop_t();
+
+	void make_number( uint64 value, int size, ea_t ea = BADADDR, int opnum = 0 );
+	bool make_fpnum( const void* bytes, size_t n );
+	void make_reg( mreg_t reg, int size );
+	void make_reg_pair( int lo, int hi, int halfsize );
+	void make_insn( minsn_t* ins );
+	void make_blkref( int serial );
+	void make_helper( const char* name );
+	void make_gvar( ea_t ea );
+	void make_stkvar( mba_t* mba, sval_t off );
+
+	void swap( mop_t& o );
+	mop_t& assign( const mop_t& o );
+	void erase();
+	bool empty() const { return t == mop_z; }
+	bool is_reg() const { return t == mop_r; }
+	bool is_insn() const { return t == mop_d; }
+	bool is_insn( mcode_t code ) const;
+	bool is_constant( uint64* out = nullptr, bool is_signed = true ) const;
+	uint64 value( bool is_signed ) const;
+
+	bool equal_mops( const mop_t& o, int eqflags ) const;
+	bool operator==( const mop_t& o ) const { return equal_mops( o, 0 ); }
+	void print( qstring* out, int flags = SHINS_SHORT ) const;
+	const char* dstr() const;
+	int for_all_ops( mop_visitor_t& v, const tinfo_t* type = nullptr, bool is_target = false );
+};
+struct mop_pair_t
+{
+	mop_t lop;
+	mop_t hop;
+};
+struct mop_addr_t : mop_t
+{
+	int insize;
+	int outsize;
+};
+struct mcallarg_t : mop_t
+{
+	ea_t ea = BADADDR;
+	tinfo_t type;
+	qstring name;
+	int argloc = 0;
+	uint32 flags = 0;
+};
+struct mcallargs_t : qvector<mcallarg_t> {};
+enum funcrole_t { ROLE_UNK };
+constexpr int FCI_PROP = 0x01, FCI_DEAD = 0x02, FCI_FINAL = 0x04, FCI_NORET = 0x08, FCI_PURE = 0x10, FCI_NOSIDE = 0x20, FCI_SPLOK = 0x40;
+struct mcallinfo_t
+{
+	ea_t callee;
+	int solid_args;
+	int call_spd = 0;
+	int stkargs_top = 0;
+	cm_t cc = CM_CC_FASTCALL;
+	mcallargs_t args;
+	qvector<mop_t> retregs;
+	tinfo_t return_type;
+	int flags = 0;
+	funcrole_t role = ROLE_UNK;
+	mlist_t spoiled;
+	mlist_t pass_regs;
+	mlist_t return_regs;
+
+	mcallinfo_t( ea_t callee = BADADDR, int solid_args = 0 ) : callee( callee ), solid_args( solid_args ) {}
+};
+struct mcases_t
+{
+	qvector<uint64vec_t> values;
+	intvec_t targets;
+};
+
+struct minsn_t
+{
+	mcode_t opcode;
+	int iprops;
+	minsn_t* next;
+	minsn_t* prev;
+	ea_t ea;
+	mop_t l;
+	mop_t r;
+	mop_t d;
+
+	explicit minsn_t( ea_t ea );
+	minsn_t( const minsn_t& o );
+	minsn_t& operator=( const minsn_t& o );
+	~minsn_t();
+
+	void* operator new( size_t n );
+	void operator delete( void* p );
+
+	bool equal_insns( const minsn_t& o, int eqflags ) const;
+	bool modifies_d() const;
+	bool is_like_move() const { return opcode == m_mov || ( opcode >= m_xds && opcode <= m_high ); }
+	bool is_assert() const { return false; }
+	void setaddr( ea_t new_ea );
+	void swap( minsn_t& o );
+	int optimize_solo( int flags = 0 ) { return 0; }
+	int for_all_insns( minsn_visitor_t& v );
+	int for_all_ops( mop_visitor_t& v );
+	void print( qstring* out, int flags = SHINS_SHORT ) const;
+	const char* dstr() const;
+};
+
+struct vd_printer_t
+{
+	void* tmpbuf = nullptr;
+	int hdrlines = 0;
+	virtual AS_PRINTF( 3, 4 ) int print( int indent, const char* format, ... );
+	virtual ~vd_printer_t() = default;
+};
+
+enum mblock_type_t { BLT_NONE, BLT_STOP, BLT_0WAY, BLT_1WAY, BLT_2WAY, BLT_NWAY, BLT_XTRN };
+enum maymust_t { MUST_ACCESS = 0, MAY_ACCESS = 1 };
+
+// Blocks own their instructions and the mba_t owns its blocks.
+//
+struct mblock_t
+{
+	mblock_t* nextb = nullptr;
+	mblock_t* prevb = nullptr;
+	uint32 flags = 0;
+	ea_t start = 0;
+	ea_t end = 0;
+	minsn_t* head = nullptr;
+	minsn_t* tail = nullptr;
+	mba_t* mba = nullptr;
+	int serial = 0;
+	mblock_type_t type = BLT_NONE;
+	mlist_t dead_at_start, mustbuse, maybuse, mustbdef, maybdef, dnu;
+	intvec_t predset;
+	intvec_t succset;
+
+	mblock_t() = default;
+	mblock_t( const mblock_t& ) = delete;
+	mblock_t& operator=( const mblock_t& ) = delete;
+	~mblock_t();
+
+	minsn_t* insert_into_block( minsn_t* nm, minsn_t* om );
+	minsn_t* remove_from_block( minsn_t* m );
+	void mark_lists_dirty() { flags |= 1; }
+	void make_lists_ready() { flags &= ~1u; }
+	int npred() const { return ( int ) predset.size(); }
+	int nsucc() const { return ( int ) succset.size(); }
+	int pred( int n ) const { return predset[ n ]; }
+	int succ( int n ) const { return succset[ n ]; }
+	int for_all_insns( minsn_visitor_t& v );
+	void print( vd_printer_t& vp ) const;
+
+	// Locations accessed by an operand or an instruction, calls use their arguments and passed registers and define
+	// their return registers (must) as well as the spoiled ones (may). Accesses through pointers and unresolved calls
+	// may access all of memory, unresolved calls also every register.
+	//
+	void append_use_list( mlist_t* list, const mop_t& op, maymust_t maymust ) const;
+	void append_def_list( mlist_t* list, const mop_t& op, maymust_t maymust ) const;
+	mlist_t build_use_list( const minsn_t& ins, maymust_t maymust ) const;
+	mlist_t build_def_list( const minsn_t& ins, maymust_t maymust ) const;
+};
+struct mba_t
+{
+	ea_t entry_ea = 0;
+	int qty = 0;
+	mblock_t* blocks = nullptr;
+	mblock_t** natural = nullptr;
+	mba_maturity_t maturity = MMAT_GENERATED;
+	sval_t minstkref = 0;
+
+	mba_t() = default;
+	mba_t( const mba_t& ) = delete;
+	mba_t& operator=( const mba_t& ) = delete;
+	~mba_t();
+
+	mblock_t* get_mblock( int n ) const { return natural[ n ]; }
+	int for_all_insns( minsn_visitor_t& v );
+	void print( vd_printer_t& vp ) const;
+	void mark_chains_dirty() {}
+	bool build_graph() { return true; }
+};
+
+struct minsn_visitor_t
+{
+	mba_t* mba = nullptr;
+	mblock_t* blk = nullptr;
+	minsn_t* topins = nullptr;
+	minsn_t* curins = nullptr;
+	virtual int idaapi visit_minsn() = 0;
+};
+struct mop_visitor_t
+{
+	mba_t* mba = nullptr;
+	mblock_t* blk = nullptr;
+	minsn_t* topins = nullptr;
+	minsn_t* curins = nullptr;
+	bool prune = false;
+	virtual int idaapi visit_mop( mop_t* op, const tinfo_t* type, bool is_target ) = 0;
+};
+
+// Optimizers and microcode generation.
+//
+struct optinsn_t
+{
+	virtual int idaapi func( mblock_t* blk, minsn_t* ins, int optflags ) = 0;
+};
+struct optblock_t
+{
+	virtual int idaapi func( mblock_t* blk ) = 0;
+};
+void install_optinsn_handler( optinsn_t* opt );
+bool remove_optinsn_handler( optinsn_t* opt );
+void install_optblock_handler( optblock_t* opt );
+bool remove_optblock_handler( optblock_t* opt );
+
+enum merror_t { MERR_OK = 0, MERR_BLOCK = 1, MERR_INTERR = -1, MERR_INSN = -2, MERR_LOOP = -34 };
+struct insn_t
+{
+	ea_t ea;
+	uint16 itype;
+	uint16 size;
+};
+struct codegen_t
+{
+	mba_t* mba;
+	mblock_t* mb;
+	insn_t insn;
+	char ignore_micro;
+	minsn_t* emit( mcode_t code, int width, uval_t l, uval_t r, uval_t d, int offsize );
+};
+struct microcode_filter_t
+{
+	virtual bool match( codegen_t& cdg ) = 0;
+	virtual merror_t apply( codegen_t& cdg ) = 0;
+};
+bool install_microcode_filter( microcode_filter_t* filter, bool install = true );
+int reg2mreg( int reg );
+
+// Decompiler events.
+//
+enum hexrays_event_t
+{
+	hxe_flowchart, hxe_stkpnts, hxe_prolog, hxe_microcode, hxe_preoptimized, hxe_locopt, hxe_prealloc, hxe_glbopt,
+	hxe_structural, hxe_maturity, hxe_interr, hxe_combine, hxe_print_func, hxe_func_printed, hxe_resolve_stkaddrs,
+	hxe_calls_done,
+	hxe_open_pseudocode = 100, hxe_switch_pseudocode, hxe_refresh_pseudocode, hxe_close_pseudocode, hxe_keyboard,
+	hxe_right_click, hxe_double_click, hxe_curpos, hxe_create_hint, hxe_text_ready, hxe_populating_popup,
+	lxe_lvar_name_changed, lxe_lvar_type_changed, lxe_lvar_cmt_changed, lxe_lvar_mapping_changed, hxe_cmt_changed
+};
+typedef ssize_t idaapi hexrays_cb_t( void* ud, hexrays_event_t event, va_list va );
+bool install_hexrays_callback( hexrays_cb_t* callback, void* ud );
+int remove_hexrays_callback( hexrays_cb_t* callback, void* ud );
+bool init_hexrays_plugin( int flags = 0 );
+const char* get_hexrays_version();
+
+// Ctree.
+//
+enum ctree_maturity_t { CMAT_ZERO, CMAT_BUILT, CMAT_TRANS1, CMAT_NICE, CMAT_TRANS2, CMAT_CPA, CMAT_TRANS3, CMAT_CASTED, CMAT_FINAL };
+enum ctype_t
+{
+	cot_empty, cot_comma, cot_asg, cot_asgbor, cot_asgxor, cot_asgband, cot_asgadd, cot_asgsub, cot_asgmul, cot_asgsshr,
+	cot_asgushr, cot_asgshl, cot_asgsdiv, cot_asgudiv, cot_asgsmod, cot_asgumod, cot_tern, cot_lor, cot_land, cot_bor,
+	cot_xor, cot_band, cot_eq, cot_ne, cot_sge, cot_uge, cot_sle, cot_ule, cot_sgt, cot_ugt, cot_slt, cot_ult, cot_sshr,
+	cot_ushr, cot_shl, cot_add, cot_sub, cot_mul, cot_sdiv, cot_udiv, cot_smod, cot_umod, cot_fadd, cot_fsub, cot_fmul,
+	cot_fdiv, cot_fneg, cot_neg, cot_cast, cot_lnot, cot_bnot, cot_ptr, cot_ref, cot_postinc, cot_postdec, cot_preinc,
+	cot_predec, cot_call, cot_idx, cot_memref, cot_memptr, cot_num, cot_fnum, cot_str, cot_obj, cot_var, cot_insn,
+	cot_sizeof, cot_helper, cot_type, cot_last = cot_type, cit_empty, cit_block, cit_expr, cit_if, cit_for, cit_while,
+	cit_do, cit_switch, cit_break, cit_continue, cit_return, cit_goto, cit_asm, cit_end
+};
+inline bool op_uses_x( ctype_t op ) { return ( op >= cot_comma && op <= cot_memptr ) || op == cot_sizeof; }
+inline bool op_uses_y( ctype_t op ) { return ( op >= cot_comma && op <= cot_fdiv ) || op == cot_idx; }
+inline bool op_uses_z( ctype_t op ) { return op == cot_tern; }
+
+struct citem_t
+{
+	ea_t ea = BADADDR;
+	ctype_t op = cot_empty;
+	int label_num = -1;
+	int index = -1;
+	bool is_expr() const { return op <= cot_last; }
+};
+struct cinsn_t;
+struct carglist_t;
+struct cnumber_t
+{
+	uint64 _value;
+};
+struct var_ref_t
+{
+	mba_t* mba;
+	int idx;
+};
+struct cexpr_t : citem_t
+{
+	union
+	{
+		cnumber_t* n;
+		fnumber_t* fpc;
+		struct
+		{
+			union
+			{
+				var_ref_t v;
+				ea_t obj_ea;
+			};
+			int refwidth;
+		};
+		struct
+		{
+			cexpr_t* x;
+			union
+			{
+				cexpr_t* y;
+				carglist_t* a;
+				uint32 m;
+			};
+			union
+			{
+				cexpr_t* z;
+				int ptrsize;
+			};
+		};
+		cinsn_t* insn;
+		char* helper;
+		char* string;
+	};
+	tinfo_t type;
+	uint32 exflags = 0;
+
+	cexpr_t() : x( nullptr ), y( nullptr ), z( nullptr ) {}
+};
+struct carg_t : cexpr_t
+{
+	bool is_vararg = false;
+	tinfo_t formal_type;
+};
+struct carglist_t : qvector<carg_t>
+{
+	tinfo_t functype;
+	int flags = 0;
+};
+struct ceinsn_t
+{
+	cexpr_t expr;
+};
+struct cif_t : ceinsn_t
+{
+	cinsn_t* ithen = nullptr;
+	cinsn_t* ielse = nullptr;
+};
+struct cloop_t : ceinsn_t
+{
+	cinsn_t* body = nullptr;
+};
+struct cfor_t : cloop_t
+{
+	cexpr_t init;
+	cexpr_t step;
+};
+struct cwhile_t : cloop_t {};
+struct cdo_t : cloop_t {};
+struct creturn_t : ceinsn_t {};
+struct cgoto_t
+{
+	int label_num;
+};
+struct casm_t : eavec_t {};
+struct cblock_t;
+struct cswitch_t;
+struct cinsn_t : citem_t
+{
+	union
+	{
+		cblock_t* cblock;
+		cexpr_t* cexpr;
+		cif_t* cif;
+		cfor_t* cfor;
+		cwhile_t* cwhile;
+		cdo_t* cdo;
+		cswitch_t* cswitch;
+		creturn_t* creturn;
+		cgoto_t* cgoto;
+		casm_t* casm;
+	};
+	cinsn_t() : cblock( nullptr ) {}
+};
+struct cblock_t : qlist<cinsn_t> {};
+struct ccase_t : cinsn_t
+{
+	uint64vec_t values;
+};
+struct ccases_t : qvector<ccase_t> {};
+struct cswitch_t : ceinsn_t
+{
+	cnumber_t mvnf;
+	ccases_t cases;
+};
+
+constexpr int CV_FAST = 0x00, CV_PRUNE = 0x01, CV_PARENTS = 0x02, CV_POST = 0x04, CV_RESTART = 0x08, CV_INSNS = 0x10;
+struct ctree_visitor_t
+{
+	int cv_flags;
+
+	ctree_visitor_t( int flags ) : cv_flags( flags ) {}
+	virtual ~ctree_visitor_t() = default;
+
+	virtual int idaapi visit_insn( cinsn_t* ) { return 0; }
+	virtual int idaapi visit_expr( cexpr_t* ) { return 0; }
+	virtual int idaapi leave_insn( cinsn_t* ) { return 0; }
+	virtual int idaapi leave_expr( cexpr_t* ) { return 0; }
+	int apply_to( citem_t* item, citem_t* parent );
+	void prune_now() { cv_flags |= CV_PRUNE; }
+};
+
+struct simpleline_t
+{
+	qstring line;
+	int color = 0;
+	int bgcolor = 0;
+};
+typedef qvector<simpleline_t> strvec_t;
+struct cfunc_t
+{
+	ea_t entry_ea = BADADDR;
+	mba_t* mba = nullptr;
+	cinsn_t body;
+	strvec_t sv;
+	int refcnt = 0;
+	const strvec_t& get_pseudocode() { return sv; }
+};
+template<typename T>
+struct qrefcnt_t
+{
+	T* ptr = nullptr;
+
+	qrefcnt_t() = default;
+	explicit qrefcnt_t( T* p ) : ptr( p ) { if ( ptr ) ptr->refcnt++; }
+	qrefcnt_t( const qrefcnt_t& o ) : qrefcnt_t( o.ptr ) {}
+	qrefcnt_t& operator=( const qrefcnt_t& o ) { qrefcnt_t copy{ o }; std::swap( ptr, copy.ptr ); return *this; }
+	~qrefcnt_t() { if ( ptr && !--ptr->refcnt ) delete ptr; }
+
+	T* operator->() const { return ptr; }
+	T& operator*() const { return *ptr; }
+	explicit operator bool() const { return ptr != nullptr; }
+};
+typedef qrefcnt_t<cfunc_t> cfuncptr_t;
+struct vdui_t
+{
+	cfuncptr_t cfunc;
+};
+struct lvar_t;
+struct qflow_chart_t;
+
+// Functions and decompilation.
+//
+struct func_t
+{
+	ea_t start_ea;
+	ea_t end_ea;
+};
+struct hexrays_failure_t
+{
+	merror_t code = MERR_OK;
+	ea_t errea = BADADDR;
+	qstring str;
+};
+func_t* get_func( ea_t ea );
+size_t get_func_qty();
+func_t* getn_func( size_t n );
+int get_func_num( ea_t ea );
+inline bool func_contains( func_t* pfn, ea_t ea ) { return pfn && ea >= pfn->start_ea && ea < pfn->end_ea; }
+cfuncptr_t decompile_func( func_t* pfn, hexrays_failure_t* hf = nullptr, int flags = 0 );
+void mark_cfunc_dirty( ea_t ea, bool close_views = false );
+void clear_cached_cfuncs();
+
+struct func_tail_iterator_t
+{
+	struct range_t
+	{
+		ea_t start_ea;
+		ea_t end_ea;
+	};
+	func_t* pfn;
+	bool done = false;
+
+	func_tail_iterator_t( func_t* pfn ) : pfn( pfn ) {}
+	bool main() { done = !pfn; return !done; }
+	bool next() { return false; }
+	range_t chunk() const { return { pfn->start_ea, pfn->end_ea }; }
+};
+
+// Function items, every address of the function is modelled as an item head.
+//
+struct func_item_iterator_t
+{
+	func_t* pfn = nullptr;
+	ea_t ea = BADADDR;
+
+	bool set( func_t* f ) { pfn = f; ea = f ? f->start_ea : BADADDR; return f && ea < f->end_ea; }
+	ea_t current() const { return ea; }
+	bool next_head() { return pfn && ++ea < pfn->end_ea; }
+	bool next_code() { return next_head(); }
+};
+
+// User data saved by the decompiler per function.
+//
+struct vdloc_t
+{
+	int type = 0;    // 0 = stack, 1 = register.
+	sval_t value = 0;
+
+	int atype() const { return type; }
+	bool is_reg1() const { return type == 1; }
+	int reg1() const { return ( int ) value; }
+	bool is_stkoff() const { return type == 0; }
+	sval_t stkoff() const { return value; }
+	bool operator<( const vdloc_t& o ) const { return type != o.type ? type < o.type : value < o.value; }
+};
+struct lvar_locator_t
+{
+	vdloc_t location;
+	ea_t defea = BADADDR;
+
+	bool operator<( const lvar_locator_t& o ) const { return defea != o.defea ? defea < o.defea : location < o.location; }
+};
+struct lvar_saved_info_t
+{
+	lvar_locator_t ll;
+	qstring name;
+	tinfo_t type;
+	qstring cmt;
+	ssize_t size = -1;
+	int flags = 0;
+};
+typedef qvector<lvar_saved_info_t> lvar_saved_infos_t;
+typedef std::map<lvar_locator_t, lvar_locator_t> lvar_mapping_t;
+struct lvar_mapping_iterator_t { lvar_mapping_t::iterator x; bool operator!=( const lvar_mapping_iterator_t& o ) const { return x != o.x; } };
+inline lvar_mapping_iterator_t lvar_mapping_begin( const lvar_mapping_t* map ) { return { const_cast< lvar_mapping_t* >( map )->begin() }; }
+inline lvar_mapping_iterator_t lvar_mapping_end( const lvar_mapping_t* map ) { return { const_cast< lvar_mapping_t* >( map )->end() }; }
+inline lvar_mapping_iterator_t lvar_mapping_next( lvar_mapping_iterator_t p ) { return { std::next( p.x ) }; }
+inline const lvar_locator_t& lvar_mapping_first( lvar_mapping_iterator_t p ) { return p.x->first; }
+inline lvar_locator_t& lvar_mapping_second( lvar_mapping_iterator_t p ) { return p.x->second; }
+struct lvar_uservec_t
+{
+	lvar_saved_infos_t lvvec;
+	lvar_mapping_t lmaps;
+	uval_t stkoff_delta = 0;
+	int ulv_flags = 0;
+};
+bool restore_user_lvar_settings( lvar_uservec_t* lvinf, ea_t func_ea );
+
+enum item_preciser_t { ITP_EMPTY, ITP_ARG1, ITP_ASM = 65, ITP_ELSE, ITP_DO, ITP_SEMI, ITP_CURLY1, ITP_CURLY2, ITP_BRACE1, ITP_BRACE2, ITP_COLON, ITP_BLOCK1, ITP_BLOCK2 };
+struct treeloc_t
+{
+	ea_t ea;
+	item_preciser_t itp;
+	bool operator<( const treeloc_t& o ) const { return ea != o.ea ? ea < o.ea : itp < o.itp; }
+};
+struct citem_cmt_t : qstring
+{
+	using qstring::qstring;
+};
+typedef std::map<treeloc_t, citem_cmt_t> user_cmts_t;
+struct user_cmts_iterator_t { user_cmts_t::iterator x; bool operator!=( const user_cmts_iterator_t& o ) const { return x != o.x; } };
+inline user_cmts_iterator_t user_cmts_begin( const user_cmts_t* map ) { return { const_cast< user_cmts_t* >( map )->begin() }; }
+inline user_cmts_iterator_t user_cmts_end( const user_cmts_t* map ) { return { const_cast< user_cmts_t* >( map )->end() }; }
+inline user_cmts_iterator_t user_cmts_next( user_cmts_iterator_t p ) { return { std::next( p.x ) }; }
+inline const treeloc_t& user_cmts_first( user_cmts_iterator_t p ) { return p.x->first; }
+inline citem_cmt_t& user_cmts_second( user_cmts_iterator_t p ) { return p.x->second; }
+inline void user_cmts_free( user_cmts_t* map ) { delete map; }
+user_cmts_t* restore_user_cmts( ea_t func_ea );
+
+struct operand_locator_t
+{
+	ea_t ea;
+	int opnum;
+	bool operator<( const operand_locator_t& o ) const { return ea != o.ea ? ea < o.ea : opnum < o.opnum; }
+};
+struct number_format_t
+{
+	uint32 flags32 = 0;
+	char opnum = 0;
+	char props = 0;
+	uchar serial = 0;
+	char org_nbytes = 0;
+	qstring type_name;
+};
+typedef std::map<operand_locator_t, number_format_t> user_numforms_t;
+struct user_numforms_iterator_t { user_numforms_t::iterator x; bool operator!=( const user_numforms_iterator_t& o ) const { return x != o.x; } };
+inline user_numforms_iterator_t user_numforms_begin( const user_numforms_t* map ) { return { const_cast< user_numforms_t* >( map )->begin() }; }
+inline user_numforms_iterator_t user_numforms_end( const user_numforms_t* map ) { return { const_cast< user_numforms_t* >( map )->end() }; }
+inline user_numforms_iterator_t user_numforms_next( user_numforms_iterator_t p ) { return { std::next( p.x ) }; }
+inline const operand_locator_t& user_numforms_first( user_numforms_iterator_t p ) { return p.x->first; }
+inline number_format_t& user_numforms_second( user_numforms_iterator_t p ) { return p.x->second; }
+inline void user_numforms_free( user_numforms_t* map ) { delete map; }
+user_numforms_t* restore_user_numforms( ea_t func_ea );
+
+// Database contents.
+//
+typedef uint64 flags64_t;
+constexpr flags64_t FF_NAME = 0x4000, FF_LABL = 0x8000, FF_ANYNAME = FF_LABL | FF_NAME;
+flags64_t get_flags( ea_t ea );
+inline bool has_user_name( flags64_t f ) { return ( f & FF_ANYNAME ) == FF_NAME; }
+ssize_t get_bytes( void* buf, ssize_t size, ea_t ea, int flags = 0, void* mask = nullptr );
+ssize_t get_name( qstring* out, ea_t ea, int flags = 0 );
+ea_t get_first_fixup_ea();
+ea_t get_next_fixup_ea( ea_t ea );
+struct fixup_data_t
+{
+	uint16 type = 0;
+	uint32 flags = 0;
+	uval_t off = 0;
+	sval_t displacement = 0;
+
+	bool get( ea_t source );
+	uint16 get_type() const { return type; }
+	ea_t get_base() const { return 0; }
+};
+int calc_fixup_size( uint16 type );
+
+constexpr int XREF_ALL = 0x00, XREF_FAR = 0x01, XREF_DATA = 0x02;
+struct xrefblk_t
+{
+	ea_t from;
+	ea_t to;
+	uchar iscode;
+	uchar type;
+	uchar user;
+	size_t cursor;
+	ea_t key;
+	bool forward;
+
+	bool first_to( ea_t to, int flags );
+	bool next_to();
+	bool first_from( ea_t from, int flags );
+	bool next_from();
+};
+
+// Notifications.
+//
+enum hook_type_t { HT_IDP, HT_UI, HT_DBG, HT_IDB, HT_DEV, HT_VIEW, HT_OUTPUT, HT_GRAPH, HT_IDD };
+typedef ssize_t idaapi hook_cb_t( void* ud, int code, va_list va );
+bool hook_to_notification_point( hook_type_t type, hook_cb_t* cb, void* ud = nullptr );
+int unhook_from_notification_point( hook_type_t type, hook_cb_t* cb, void* ud = nullptr );
+namespace idb_event
+{
+	enum event_code_t
+	{
+		closebase, savebase, upgraded, auto_empty, auto_empty_finally, determined_main, local_types_changed,
+		extlang_changed, idasgn_loaded, kernel_config_loaded, loader_finished, flow_chart_created, compiler_changed,
+		changing_ti, ti_changed, changing_op_ti, op_ti_changed, changing_op_type, op_type_changed, enum_created,
+		func_added = 20, func_updated, set_func_start, set_func_end, deleting_func, frame_deleted, thunk_func_created,
+		func_tail_appended, deleting_func_tail, func_tail_deleted, tail_owner_changed, func_noret_changed,
+		stkpnts_changed, updating_tryblks, tryblks_updated, deleting_tryblks, sgr_changed, make_code, make_data,
+		destroyed_items, renamed, byte_patched, changing_cmt, cmt_changed, changing_range_cmt, range_cmt_changed,
+		extra_cmt_changed, item_color_changed, callee_addr_changed, bookmark_changed, sgr_deleted, adding_segm,
+		func_deleted
+	};
+};
+
+// Threading.
+//
+struct exec_request_t
+{
+	virtual int idaapi execute() = 0;
+	virtual ~exec_request_t() = default;
+};
+constexpr int MFF_FAST = 0x00, MFF_READ = 0x01, MFF_WRITE = 0x02, MFF_NOWAIT = 0x04;
+int execute_sync( exec_request_t& req, int flags );
+bool is_main_thread();
+typedef void* qtimer_t;
+qtimer_t register_timer( int interval, int ( idaapi* callback )( void* ud ), void* ud );
+bool unregister_timer( qtimer_t t );
+
+// Misc.
+//
+struct plugmod_t
+{
+	virtual bool idaapi run( size_t arg ) = 0;
+	virtual ~plugmod_t() = default;
+};
+void msg( const char* format, ... );
+ssize_t tag_remove( qstring* buf, const char* str, int init_level = 0 );
+inline ssize_t tag_remove( qstring* buf, int init_level = 0 ) { return tag_remove( buf, qstring{ *buf }.c_str(), init_level ); }
+
+// Controls of the stand-in, not part of the SDK.
+//
+namespace stub
+{
+	struct xref
+	{
+		ea_t from;
+		ea_t to;
+		bool code;
+	};
+	struct database
+	{
+		std::vector<func_t> functions;                     // Sorted by start.
+		std::vector<std::pair<ea_t, std::string>> names;
+		std::vector<std::pair<ea_t, tinfo_t>> types;
+		std::vector<std::pair<ea_t, fixup_data_t>> fixups; // Sorted by address.
+		std::vector<std::pair<ea_t, uint8_t>> bytes;       // Sparse, missing bytes read as zero.
+		std::vector<xref> xrefs;
+		std::vector<std::pair<std::string, tinfo_t>> local_types;   // Indexed by ordinal - 1.
+		std::vector<ea_t> dirty_cfuncs;
+		size_t cfunc_cache_clears = 0;
+		std::map<ea_t, lvar_uservec_t> user_lvars;         // Keyed by function entry.
+		std::map<ea_t, user_cmts_t> user_cmts;
+		std::map<ea_t, user_numforms_t> user_numforms;
+	};
+	database& db();
+	void reset();
+
+	// Function table.
+	//
+	func_t* add_func( ea_t start, ea_t end );
+	void set_name( ea_t ea, const char* name );
+	void set_type( ea_t ea, const tinfo_t& type );
+
+	// Raises events to every installed callback, returning the first non-zero result.
+	//
+	ssize_t raise_hexrays( hexrays_event_t event, ... );
+	ssize_t raise_idb( idb_event::event_code_t code, ... );
+	size_t hexrays_callback_count();
+	size_t idb_hook_count();
+
+	// Invokes the installed optimizers the way the decompiler does, returns the number of changes.
+	//
+	int run_optinsn( mblock_t* blk, minsn_t* ins, int optflags = 0 );
+	int run_optblock( mblock_t* blk );
+	size_t optinsn_count();
+
+	// Runs the requests queued with MFF_NOWAIT on the calling thread which becomes the main thread.
+	//
+	size_t run_requests();
+
+	// Creates an mba_t with the given number of empty blocks and no edges.
+	//
+	mba_t* create_mba( int qty, ea_t entry = 0x1000 );
+	void add_edge( mba_t* mba, int from, int to );
+};
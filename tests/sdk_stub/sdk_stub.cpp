@@ -0,0 +1,1096 @@
+#include <hexrays.hpp>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
+
+// Implementation of the SDK stand-in.
+//
+namespace stub
+{
+	database& db() { static database d = {}; return d; }
+
+	struct callback_state
+	{
+		std::vector<std::pair<hexrays_cb_t*, void*>> hexrays;
+		std::vector<std::pair<hook_cb_t*, void*>> idb;
+		std::vector<optinsn_t*> optinsn;
+		std::vector<optblock_t*> optblock;
+		std::vector<microcode_filter_t*> filters;
+		std::mutex request_lock;
+		std::deque<exec_request_t*> requests;
+		std::thread::id main_thread = std::this_thread::get_id();
+	};
+	static callback_state& callbacks() { static callback_state s = {}; return s; }
+
+	void reset() { db() = {}; }
+
+	func_t* add_func( ea_t start, ea_t end )
+	{
+		auto& list = db().functions;
+		auto it = std::lower_bound( list.begin(), list.end(), start, [ ] ( const func_t& f, ea_t ea ) { return f.start_ea < ea; } );
+		return &*list.insert( it, func_t{ start, end } );
+	}
+	template<typename T>
+	static void set_entry( std::vector<std::pair<ea_t, T>>& list, ea_t ea, T value )
+	{
+		for ( auto& [key, v] : list )
+			if ( key == ea )
+				return void( v = std::move( value ) );
+		list.emplace_back( ea, std::move( value ) );
+	}
+	void set_name( ea_t ea, const char* name ) { set_entry( db().names, ea, std::string{ name } ); }
+	void set_type( ea_t ea, const tinfo_t& type ) { set_entry( db().types, ea, type ); }
+
+	ssize_t raise_hexrays( hexrays_event_t event, ... )
+	{
+		auto list = callbacks().hexrays;
+		ssize_t result = 0;
+		for ( auto [cb, ud] : list )
+		{
+			va_list va;
+			va_start( va, event );
+			result = cb( ud, event, va );
+			va_end( va );
+			if ( result )
+				break;
+		}
+		return result;
+	}
+	ssize_t raise_idb( idb_event::event_code_t code, ... )
+	{
+		auto list = callbacks().idb;
+		ssize_t result = 0;
+		for ( auto [cb, ud] : list )
+		{
+			va_list va;
+			va_start( va, code );
+			result = cb( ud, code, va );
+			va_end( va );
+			if ( result )
+				break;
+		}
+		return result;
+	}
+	size_t hexrays_callback_count() { return callbacks().hexrays.size(); }
+	size_t idb_hook_count() { return callbacks().idb.size(); }
+
+	int run_optinsn( mblock_t* blk, minsn_t* ins, int optflags )
+	{
+		int changes = 0;
+		for ( optinsn_t* opt : callbacks().optinsn )
+			changes += opt->func( blk, ins, optflags );
+		return changes;
+	}
+	int run_optblock( mblock_t* blk )
+	{
+		int changes = 0;
+		for ( optblock_t* opt : callbacks().optblock )
+			changes += opt->func( blk );
+		return changes;
+	}
+	size_t optinsn_count() { return callbacks().optinsn.size(); }
+
+	size_t run_requests()
+	{
+		auto& s = callbacks();
+		s.main_thread = std::this_thread::get_id();
+		size_t n = 0;
+		while ( true )
+		{
+			exec_request_t* req;
+			{
+				std::lock_guard _g{ s.request_lock };
+				if ( s.requests.empty() )
+					break;
+				req = s.requests.front();
+				s.requests.pop_front();
+			}
+			req->execute();
+			delete req;
+			n++;
+		}
+		return n;
+	}
+
+	mba_t* create_mba( int qty, ea_t entry )
+	{
+		mba_t* mba = new mba_t;
+		mba->entry_ea = entry;
+		mba->qty = qty;
+		mba->natural = new mblock_t*[ qty ];
+		mblock_t* prev = nullptr;
+		for ( int i = 0; i != qty; i++ )
+		{
+			mblock_t* blk = new mblock_t;
+			blk->mba = mba;
+			blk->serial = i;
+			blk->start = entry + i * 0x10;
+			blk->end = blk->start + 0x10;
+			blk->prevb = prev;
+			( prev ? prev->nextb : mba->blocks ) = blk;
+			mba->natural[ i ] = prev = blk;
+		}
+		return mba;
+	}
+	void add_edge( mba_t* mba, int from, int to )
+	{
+		mba->get_mblock( from )->succset.push_back( to );
+		mba->get_mblock( to )->predset.push_back( from );
+	}
+};
+
+// qstring.
+//
+size_t qstring::cat_vsprnt( const char* format, va_list va )
+{
+	va_list copy;
+	va_copy( copy, va );
+	int n = vsnprintf( nullptr, 0, format, copy );
+	va_end( copy );
+	if ( n <= 0 )
+		return 0;
+	size_t at = s.size();
+	s.resize( at + n + 1 );
+	vsnprintf( s.data() + at, n + 1, format, va );
+	s.resize( at + n );
+	return n;
+}
+size_t qstring::cat_sprnt( const char* format, ... )
+{
+	va_list va;
+	va_start( va, format );
+	size_t n = cat_vsprnt( format, va );
+	va_end( va );
+	return n;
+}
+
+// Types.
+//
+static til_t local_til = {};
+const til_t* get_idati() { return &local_til; }
+size_t tinfo_t::get_size() const
+{
+	if ( repr.empty() )
+		return BADADDR;
+	type_t t = ( type_t ) repr[ 0 ];
+	switch ( t & BT_TYPE_MASK )
+	{
+		case BT_VOID:   return 0;
+		case BT_INT8:   return 1;
+		case BT_INT16:  return 2;
+		case BT_INT32:  return 4;
+		case BT_INT64:  return 8;
+		case BT_INT128: return 16;
+		case BT_INT:    return 4;
+		case BT_BOOL:   return 1;
+		case BT_FLOAT:  return t == BTF_DOUBLE ? 8 : 4;
+		case BT_PTR:    return 8;
+		default:        return 1;
+	}
+}
+bool tinfo_t::create_ptr( const tinfo_t& target )
+{
+	repr = std::string( 1, ( char ) BT_PTR ) + target.repr;
+	return true;
+}
+bool tinfo_t::get_numbered_type( const til_t*, uint32 ordinal, type_t, bool )
+{
+	auto& list = stub::db().local_types;
+	if ( !ordinal || ordinal > list.size() || list[ ordinal - 1 ].first.empty() )
+		return false;
+	*this = list[ ordinal - 1 ].second;
+	return true;
+}
+bool tinfo_t::get_named_type( const til_t*, const char* name, type_t, bool )
+{
+	for ( auto& [n, type] : stub::db().local_types )
+		if ( n == name )
+			return *this = type, true;
+	return false;
+}
+bool tinfo_t::print( qstring* out, const char* name, int ) const
+{
+	out->clear();
+	for ( char c : repr )
+		out->cat_sprnt( "%02x", ( uint8_t ) c );
+	if ( name )
+		out->cat_sprnt( " %s", name );
+	return true;
+}
+bool tinfo_t::serialize( qstring* type, qstring* fields, qstring*, int ) const
+{
+	if ( repr.empty() )
+		return false;
+	*type = qstring{ repr.data(), repr.size() };
+	if ( fields )
+		fields->clear();
+	return true;
+}
+uint32 get_ordinal_qty( const til_t* ) { return ( uint32 ) stub::db().local_types.size(); }
+const char* get_numbered_type_name( const til_t*, uint32 ordinal )
+{
+	auto& list = stub::db().local_types;
+	if ( !ordinal || ordinal > list.size() || list[ ordinal - 1 ].first.empty() )
+		return nullptr;
+	return list[ ordinal - 1 ].first.c_str();
+}
+const char* first_named_type( const til_t* til, int flags ) { return next_named_type( til, nullptr, flags ); }
+const char* next_named_type( const til_t*, const char* name, int )
+{
+	auto& list = stub::db().local_types;
+	size_t i = 0;
+	if ( name )
+	{
+		while ( i != list.size() && list[ i ].first.c_str() != name )
+			i++;
+		i++;
+	}
+	for ( ; i < list.size(); i++ )
+		if ( !list[ i ].first.empty() )
+			return list[ i ].first.c_str();
+	return nullptr;
+}
+bool get_tinfo( tinfo_t* out, ea_t ea )
+{
+	for ( auto& [key, type] : stub::db().types )
+		if ( key == ea )
+			return *out = type, true;
+	return false;
+}
+
+// Operands.
+//
+static char* copy_string( const char* s )
+{
+	size_t n = strlen( s ) + 1;
+	char* r = new char[ n ];
+	memcpy( r, s, n );
+	return r;
+}
+mop_t::mop_t() : t( mop_z ), oprops( 0 ), valnum( 0 ), size( NOSIZE ) { scif = nullptr; }
+mop_t::mop_t( const mop_t& o ) : mop_t() { assign( o ); }
+mop_t& mop_t::operator=( const mop_t& o ) { return assign( o ); }
+mop_t::~mop_t() { erase(); }
+
+mop_t& mop_t::assign( const mop_t& o )
+{
+	if ( this == &o )
+		return *this;
+	erase();
+	t = o.t;
+	oprops = o.oprops;
+	valnum = o.valnum;
+	size = o.size;
+	switch ( t )
+	{
+		case mop_n:   nnn = new mnumber_t( *o.nnn ); break;
+		case mop_d:   d = new minsn_t( *o.d ); break;
+		case mop_S:   s = new stkvar_ref_t( *o.s ); break;
+		case mop_f:   f = new mcallinfo_t( *o.f ); break;
+		case mop_l:   l = new lvar_ref_t( *o.l ); break;
+		case mop_a:   a = new mop_addr_t( *o.a ); break;
+		case mop_h:   helper = copy_string( o.helper ); break;
+		case mop_str: cstr = copy_string( o.cstr ); break;
+		case mop_c:   c = new mcases_t( *o.c ); break;
+		case mop_fn:  fpc = new fnumber_t( *o.fpc ); break;
+		case mop_p:   pair = new mop_pair_t( *o.pair ); break;
+		default:      scif = o.scif; break;
+	}
+	return *this;
+}
+void mop_t::erase()
+{
+	switch ( t )
+	{
+		case mop_n:   delete nnn; break;
+		case mop_d:   delete d; break;
+		case mop_S:   delete s; break;
+		case mop_f:   delete f; break;
+		case mop_l:   delete l; break;
+		case mop_a:   delete a; break;
+		case mop_h:   delete[] helper; break;
+		case mop_str: delete[] cstr; break;
+		case mop_c:   delete c; break;
+		case mop_fn:  delete fpc; break;
+		case mop_p:   delete pair; break;
+		default:      break;
+	}
+	t = mop_z;
+	size = NOSIZE;
+	scif = nullptr;
+}
+void mop_t::swap( mop_t& o )
+{
+	std::swap( t, o.t );
+	std::swap( oprops, o.oprops );
+	std::swap( valnum, o.valnum );
+	std::swap( size, o.size );
+	std::swap( scif, o.scif );
+	static_assert( sizeof( scif ) == sizeof( ea_t ), "The union is swapped through its widest member." );
+}
+
+void mop_t::make_number( uint64 value, int sz, ea_t, int )
+{
+	erase();
+	t = mop_n;
+	size = sz;
+	uint64 mask = sz >= 8 ? ~0ull : ( ( 1ull << ( sz * 8 ) ) - 1 );
+	nnn = new mnumber_t{ value & mask, value };
+}
+bool mop_t::make_fpnum( const void* bytes, size_t n )
+{
+	erase();
+	t = mop_fn;
+	size = ( int ) n;
+	fpc = new fnumber_t{};
+	fpc->nbytes = ( int ) n;
+	memcpy( fpc->fnum, bytes, std::min( n, sizeof( fpc->fnum ) ) );
+	return true;
+}
+void mop_t::make_reg( mreg_t reg, int sz ) { erase(); t = mop_r; r = reg; size = sz; }
+void mop_t::make_reg_pair( int lo, int hi, int halfsize )
+{
+	erase();
+	t = mop_p;
+	size = halfsize * 2;
+	pair = new mop_pair_t;
+	pair->lop.make_reg( lo, halfsize );
+	pair->hop.make_reg( hi, halfsize );
+}
+void mop_t::make_insn( minsn_t* ins ) { erase(); t = mop_d; d = ins; }
+void mop_t::make_blkref( int serial ) { erase(); t = mop_b; b = serial; }
+void mop_t::make_helper( const char* name ) { erase(); t = mop_h; helper = copy_string( name ); }
+void mop_t::make_gvar( ea_t ea ) { erase(); t = mop_v; g = ea; }
+void mop_t::make_stkvar( mba_t* mba, sval_t off ) { erase(); t = mop_S; s = new stkvar_ref_t{ mba, off }; }
+
+bool mop_t::is_insn( mcode_t code ) const { return t == mop_d && d->opcode == code; }
+bool mop_t::is_constant( uint64* out, bool is_signed ) const
+{
+	if ( t != mop_n )
+		return false;
+	if ( out )
+		*out = value( is_signed );
+	return true;
+}
+uint64 mop_t::value( bool is_signed ) const
+{
+	uint64 v = nnn->value;
+	if ( is_signed && size > 0 && size < 8 && ( v >> ( size * 8 - 1 ) ) & 1 )
+		v |= ~0ull << ( size * 8 );
+	return v;
+}
+
+bool mop_t::equal_mops( const mop_t& o, int eqflags ) const
+{
+	if ( t != o.t || ( !( eqflags & EQ_IGNSIZE ) && size != o.size ) )
+		return false;
+	switch ( t )
+	{
+		case mop_z:   return true;
+		case mop_r:   return r == o.r;
+		case mop_n:   return nnn->value == o.nnn->value;
+		case mop_d:   return d->equal_insns( *o.d, eqflags );
+		case mop_S:   return s->off == o.s->off;
+		case mop_v:   return g == o.g;
+		case mop_b:   return b == o.b;
+		case mop_l:   return l->idx == o.l->idx && l->off == o.l->off;
+		case mop_a:   return a->equal_mops( *o.a, eqflags );
+		case mop_h:   return !strcmp( helper, o.helper );
+		case mop_str: return !strcmp( cstr, o.cstr );
+		case mop_fn:  return !memcmp( fpc->fnum, o.fpc->fnum, sizeof( fpc->fnum ) );
+		case mop_p:   return pair->lop.equal_mops( o.pair->lop, eqflags ) && pair->hop.equal_mops( o.pair->hop, eqflags );
+		case mop_c:   return c->targets == o.c->targets;
+		case mop_f:
+			if ( f->callee != o.f->callee || f->args.size() != o.f->args.size() )
+				return false;
+			for ( size_t i = 0; i != f->args.size(); i++ )
+				if ( !f->args[ i ].equal_mops( o.f->args[ i ], eqflags ) )
+					return false;
+			return true;
+		default:
+			return false;
+	}
+}
+
+int mop_t::for_all_ops( mop_visitor_t& v, const tinfo_t* type, bool is_target )
+{
+	v.prune = false;
+	if ( int r = v.visit_mop( this, type, is_target ) )
+		return r;
+	if ( std::exchange( v.prune, false ) )
+		return 0;
+	switch ( t )
+	{
+		case mop_d:
+			return d->for_all_ops( v );
+		case mop_a:
+			return a->for_all_ops( v );
+		case mop_p:
+			if ( int r = pair->lop.for_all_ops( v ) )
+				return r;
+			return pair->hop.for_all_ops( v );
+		case mop_f:
+			for ( mcallarg_t& arg : f->args )
+				if ( int r = arg.for_all_ops( v, &arg.type ) )
+					return r;
+			return 0;
+		default:
+			return 0;
+	}
+}
+
+// Instructions.
+//
+static const char* const opcode_text[] = {
+	"nop", "stx", "ldx", "ldc", "mov", "neg", "lnot", "bnot", "xds", "xdu", "low", "high", "add", "sub", "mul", "udiv",
+	"sdiv", "umod", "smod", "or", "and", "xor", "shl", "shr", "sar", "cfadd", "ofadd", "cfshl", "cfshr", "sets", "seto",
+	"setp", "setnz", "setz", "setae", "setb", "seta", "setbe", "setg", "setge", "setl", "setle", "jcnd", "jnz", "jz",
+	"jae", "jb", "ja", "jbe", "jg", "jge", "jl", "jle", "jtbl", "ijmp", "goto", "call", "icall", "ret", "push", "pop",
+	"und", "ext", "f2i", "f2u", "i2f", "u2f", "f2f", "fneg", "fadd", "fsub", "fmul", "fdiv"
+};
+
+minsn_t::minsn_t( ea_t ea ) : opcode( m_nop ), iprops( 0 ), next( nullptr ), prev( nullptr ), ea( ea ) {}
+minsn_t::minsn_t( const minsn_t& o ) : opcode( o.opcode ), iprops( o.iprops ), next( nullptr ), prev( nullptr ), ea( o.ea ), l( o.l ), r( o.r ), d( o.d ) {}
+minsn_t& minsn_t::operator=( const minsn_t& o )
+{
+	opcode = o.opcode;
+	iprops = o.iprops;
+	ea = o.ea;
+	l = o.l;
+	r = o.r;
+	d = o.d;
+	return *this;
+}
+minsn_t::~minsn_t() {}
+void* minsn_t::operator new( size_t n ) { return ::operator new( n ); }
+void minsn_t::operator delete( void* p ) { ::operator delete( p ); }
+
+bool minsn_t::equal_insns( const minsn_t& o, int eqflags ) const
+{
+	if ( !( eqflags & EQ_IGNCODE ) && opcode != o.opcode )
+		return false;
+	if ( !l.equal_mops( o.l, eqflags ) || !r.equal_mops( o.r, eqflags ) )
+		return false;
+	return !( eqflags & EQ_CMPDEST ) || d.equal_mops( o.d, eqflags );
+}
+bool minsn_t::modifies_d() const
+{
+	switch ( opcode )
+	{
+		case m_stx: case m_jcnd: case m_jnz: case m_jz: case m_jae: case m_jb: case m_ja: case m_jbe: case m_jg: case m_jge:
+		case m_jl: case m_jle: case m_jtbl: case m_ijmp: case m_goto: case m_ret: case m_push: case m_nop:
+			return false;
+		case m_call: case m_icall:
+			return d.t != mop_f;
+		default:
+			return true;
+	}
+}
+void minsn_t::setaddr( ea_t new_ea )
+{
+	ea = new_ea;
+	for ( mop_t* op : { &l, &r, &d } )
+		if ( op->t == mop_d )
+			op->d->setaddr( new_ea );
+}
+void minsn_t::swap( minsn_t& o )
+{
+	std::swap( opcode, o.opcode );
+	std::swap( iprops, o.iprops );
+	std::swap( ea, o.ea );
+	l.swap( o.l );
+	r.swap( o.r );
+	d.swap( o.d );
+}
+int minsn_t::for_all_insns( minsn_visitor_t& v )
+{
+	for ( mop_t* op : { &l, &r, &d } )
+	{
+		if ( op->t == mop_d )
+		{
+			if ( int r = op->d->for_all_insns( v ) )
+				return r;
+		}
+		else if ( op->t == mop_f )
+		{
+			for ( mcallarg_t& arg : op->f->args )
+				if ( arg.t == mop_d )
+					if ( int r = arg.d->for_all_insns( v ) )
+						return r;
+		}
+	}
+	v.curins = this;
+	return v.visit_minsn();
+}
+int minsn_t::for_all_ops( mop_visitor_t& v )
+{
+	v.curins = this;
+	if ( int r = l.for_all_ops( v ) )
+		return r;
+	if ( int r = this->r.for_all_ops( v ) )
+		return r;
+	return d.for_all_ops( v, nullptr, modifies_d() );
+}
+
+void mop_t::print( qstring* out, int ) const
+{
+	switch ( t )
+	{
+		case mop_z:   break;
+		case mop_r:   out->cat_sprnt( "r%d.%d", r, size ); break;
+		case mop_n:   out->cat_sprnt( "#0x%llx.%d", ( unsigned long long ) nnn->value, size ); break;
+		case mop_str: out->cat_sprnt( "\"%s\"", cstr ); break;
+		case mop_S:   out->cat_sprnt( "%%var_%llx.%d", ( unsigned long long ) s->off, size ); break;
+		case mop_v:   out->cat_sprnt( "$0x%llx.%d", ( unsigned long long ) g, size ); break;
+		case mop_b:   out->cat_sprnt( "@%d", b ); break;
+		case mop_l:   out->cat_sprnt( "lvar%d.%d", l->idx, size ); break;
+		case mop_h:   out->cat_sprnt( "!%s", helper ); break;
+		case mop_d:
+			out->append( '(' );
+			d->print( out );
+			out->cat_sprnt( ").%d", size );
+			break;
+		case mop_a:
+			out->append( '&' );
+			a->print( out );
+			break;
+		case mop_p:
+			pair->hop.print( out );
+			out->append( ':' );
+			pair->lop.print( out );
+			break;
+		case mop_f:
+			out->append( '<' );
+			for ( size_t i = 0; i != f->args.size(); i++ )
+			{
+				if ( i )
+					out->append( ", ", 2 );
+				f->args[ i ].print( out );
+			}
+			out->append( '>' );
+			break;
+		default:
+			out->cat_sprnt( "<mop %d>", t );
+			break;
+	}
+}
+void minsn_t::print( qstring* out, int ) const
+{
+	out->cat_sprnt( "%s", opcode < std::size( opcode_text ) ? opcode_text[ opcode ] : "?" );
+	bool first = true;
+	for ( const mop_t* op : { &l, &r, &d } )
+	{
+		if ( op->t == mop_z )
+			continue;
+		out->append( first ? " " : ", ", first ? 1 : 2 );
+		first = false;
+		op->print( out );
+	}
+}
+const char* mop_t::dstr() const
+{
+	thread_local qstring buffer;
+	buffer.clear();
+	print( &buffer );
+	return buffer.c_str();
+}
+const char* minsn_t::dstr() const
+{
+	thread_local qstring buffer;
+	buffer.clear();
+	print( &buffer );
+	return buffer.c_str();
+}
+
+// Blocks.
+//
+int vd_printer_t::print( int, const char*, ... ) { return 0; }
+
+mblock_t::~mblock_t()
+{
+	while ( head )
+		delete std::exchange( head, head->next );
+}
+minsn_t* mblock_t::insert_into_block( minsn_t* nm, minsn_t* om )
+{
+	nm->prev = om;
+	nm->next = om ? om->next : head;
+	( nm->next ? nm->next->prev : tail ) = nm;
+	( om ? om->next : head ) = nm;
+	return nm;
+}
+minsn_t* mblock_t::remove_from_block( minsn_t* m )
+{
+	minsn_t* next = m->next;
+	( m->prev ? m->prev->next : head ) = m->next;
+	( m->next ? m->next->prev : tail ) = m->prev;
+	m->next = m->prev = nullptr;
+	return next;
+}
+int mblock_t::for_all_insns( minsn_visitor_t& v )
+{
+	v.blk = this;
+	v.mba = mba;
+	for ( minsn_t* ins = head; ins; ins = ins->next )
+	{
+		v.topins = ins;
+		if ( int r = ins->for_all_insns( v ) )
+			return r;
+	}
+	return 0;
+}
+void mblock_t::print( vd_printer_t& vp ) const
+{
+	vp.print( 0, "; %d-WAY-BLOCK %d [START=%llX END=%llX]\n", nsucc(), serial, ( unsigned long long ) start, ( unsigned long long ) end );
+	qstring line;
+	int index = 0;
+	for ( minsn_t* ins = head; ins; ins = ins->next )
+	{
+		line.clear();
+		ins->print( &line );
+		vp.print( 0, "%d.%2d \x01\x0c%08llX\x02\x0c %s\n", serial, index++, ( unsigned long long ) ins->ea, line.c_str() );
+	}
+}
+
+// Use/def lists, stack variables live in a region of their own above the global addresses.
+//
+static constexpr uval_t stack_region = 0xFFFF000000000000ull;
+static constexpr int register_bytes = 256;
+static void add_all_memory( mlist_t* list ) { list->mem.add( { 0, BADADDR } ); }
+
+void mblock_t::append_use_list( mlist_t* list, const mop_t& op, maymust_t maymust ) const
+{
+	switch ( op.t )
+	{
+		case mop_r: list->reg.add( op.r, op.size ); break;
+		case mop_S: list->mem.add( { stack_region + op.s->off, ( uval_t ) op.size } ); break;
+		case mop_v: list->mem.add( { op.g, ( uval_t ) op.size } ); break;
+		case mop_d: list->add( build_use_list( *op.d, maymust ) ); break;
+		case mop_p: append_use_list( list, op.pair->lop, maymust ); append_use_list( list, op.pair->hop, maymust ); break;
+		case mop_f:
+			for ( const mcallarg_t& arg : op.f->args )
+				append_use_list( list, arg, maymust );
+			list->add( op.f->pass_regs );
+			break;
+		default: break;
+	}
+}
+void mblock_t::append_def_list( mlist_t* list, const mop_t& op, maymust_t maymust ) const
+{
+	switch ( op.t )
+	{
+		case mop_r: list->reg.add( op.r, op.size ); break;
+		case mop_S: list->mem.add( { stack_region + op.s->off, ( uval_t ) op.size } ); break;
+		case mop_v: list->mem.add( { op.g, ( uval_t ) op.size } ); break;
+		case mop_p: append_def_list( list, op.pair->lop, maymust ); append_def_list( list, op.pair->hop, maymust ); break;
+		default: break;
+	}
+}
+mlist_t mblock_t::build_use_list( const minsn_t& ins, maymust_t maymust ) const
+{
+	mlist_t list;
+	append_use_list( &list, ins.l, maymust );
+	append_use_list( &list, ins.r, maymust );
+	bool call = ins.opcode == m_call || ins.opcode == m_icall;
+	if ( !ins.modifies_d() || ins.d.t == mop_f )
+		append_use_list( &list, ins.d, maymust );
+	if ( maymust == MAY_ACCESS && ( ins.opcode == m_ldx || call ) )
+		add_all_memory( &list );
+	if ( maymust == MAY_ACCESS && call && ins.d.t != mop_f )
+		list.reg.add( 0, register_bytes );
+	return list;
+}
+mlist_t mblock_t::build_def_list( const minsn_t& ins, maymust_t maymust ) const
+{
+	mlist_t list;
+	bool call = ins.opcode == m_call || ins.opcode == m_icall;
+	if ( call && ins.d.t == mop_f )
+	{
+		list.add( ins.d.f->return_regs );
+		if ( maymust == MAY_ACCESS )
+			list.add( ins.d.f->spoiled );
+	}
+	else if ( ins.modifies_d() )
+	{
+		append_def_list( &list, ins.d, maymust );
+	}
+	if ( maymust == MAY_ACCESS && ( ins.opcode == m_stx || call ) )
+		add_all_memory( &list );
+	if ( maymust == MAY_ACCESS && call && ins.d.t != mop_f )
+		list.reg.add( 0, register_bytes );
+	return list;
+}
+
+mba_t::~mba_t()
+{
+	while ( blocks )
+		delete std::exchange( blocks, blocks->nextb );
+	delete[] natural;
+}
+int mba_t::for_all_insns( minsn_visitor_t& v )
+{
+	for ( mblock_t* blk = blocks; blk; blk = blk->nextb )
+		if ( int r = blk->for_all_insns( v ) )
+			return r;
+	return 0;
+}
+void mba_t::print( vd_printer_t& vp ) const
+{
+	for ( mblock_t* blk = blocks; blk; blk = blk->nextb )
+		blk->print( vp );
+}
+
+// Optimizers and microcode generation.
+//
+template<typename T>
+static bool erase_one( std::vector<T>& list, T value )
+{
+	auto it = std::find( list.begin(), list.end(), value );
+	if ( it == list.end() )
+		return false;
+	list.erase( it );
+	return true;
+}
+void install_optinsn_handler( optinsn_t* opt ) { stub::callbacks().optinsn.push_back( opt ); }
+bool remove_optinsn_handler( optinsn_t* opt ) { return erase_one( stub::callbacks().optinsn, opt ); }
+void install_optblock_handler( optblock_t* opt ) { stub::callbacks().optblock.push_back( opt ); }
+bool remove_optblock_handler( optblock_t* opt ) { return erase_one( stub::callbacks().optblock, opt ); }
+bool install_microcode_filter( microcode_filter_t* filter, bool install )
+{
+	auto& list = stub::callbacks().filters;
+	if ( !install )
+		return erase_one( list, filter );
+	if ( std::find( list.begin(), list.end(), filter ) == list.end() )
+		list.push_back( filter );
+	return true;
+}
+minsn_t* codegen_t::emit( mcode_t code, int width, uval_t l, uval_t r, uval_t d, int )
+{
+	minsn_t* ins = new minsn_t( insn.ea );
+	ins->opcode = code;
+	if ( l != ( uval_t ) mr_none ) ins->l.make_reg( ( mreg_t ) l, width );
+	if ( r != ( uval_t ) mr_none ) ins->r.make_reg( ( mreg_t ) r, width );
+	if ( d != ( uval_t ) mr_none ) ins->d.make_reg( ( mreg_t ) d, width );
+	return mb->insert_into_block( ins, mb->tail );
+}
+int reg2mreg( int reg ) { return reg * 8; }
+
+// Decompiler.
+//
+bool install_hexrays_callback( hexrays_cb_t* callback, void* ud )
+{
+	stub::callbacks().hexrays.emplace_back( callback, ud );
+	return true;
+}
+int remove_hexrays_callback( hexrays_cb_t* callback, void* ud )
+{
+	return erase_one( stub::callbacks().hexrays, std::pair{ callback, ud } ) ? 1 : 0;
+}
+bool init_hexrays_plugin( int ) { return true; }
+const char* get_hexrays_version() { return "0.0.0.0 (stub)"; }
+
+static void apply_children( ctree_visitor_t& v, citem_t* item, int& result );
+static int apply_item( ctree_visitor_t& v, citem_t* item, citem_t* parent )
+{
+	if ( !item )
+		return 0;
+	bool is_expr = item->is_expr();
+	int result = is_expr ? v.visit_expr( ( cexpr_t* ) item ) : v.visit_insn( ( cinsn_t* ) item );
+	if ( result )
+		return result;
+	if ( v.cv_flags & CV_PRUNE )
+	{
+		v.cv_flags &= ~CV_PRUNE;
+	}
+	else
+	{
+		apply_children( v, item, result );
+		if ( result )
+			return result;
+	}
+	if ( v.cv_flags & CV_POST )
+		return is_expr ? v.leave_expr( ( cexpr_t* ) item ) : v.leave_insn( ( cinsn_t* ) item );
+	return 0;
+}
+static void apply_children( ctree_visitor_t& v, citem_t* item, int& result )
+{
+	auto visit = [ & ] ( citem_t* child ) { if ( !result ) result = apply_item( v, child, item ); };
+	if ( item->is_expr() )
+	{
+		auto* e = ( cexpr_t* ) item;
+		if ( e->op == cot_insn )
+			return visit( e->insn );
+		if ( op_uses_x( e->op ) )
+			visit( e->x );
+		if ( e->op == cot_call )
+			for ( carg_t& arg : *e->a )
+				visit( &arg );
+		if ( op_uses_y( e->op ) )
+			visit( e->y );
+		if ( op_uses_z( e->op ) )
+			visit( e->z );
+		return;
+	}
+	auto* i = ( cinsn_t* ) item;
+	switch ( i->op )
+	{
+		case cit_block:
+			for ( cinsn_t& sub : *i->cblock )
+				visit( &sub );
+			break;
+		case cit_expr:
+			visit( i->cexpr );
+			break;
+		case cit_if:
+			visit( &i->cif->expr );
+			visit( i->cif->ithen );
+			visit( i->cif->ielse );
+			break;
+		case cit_for:
+			visit( &i->cfor->init );
+			visit( &i->cfor->expr );
+			visit( &i->cfor->step );
+			visit( i->cfor->body );
+			break;
+		case cit_while:
+			visit( &i->cwhile->expr );
+			visit( i->cwhile->body );
+			break;
+		case cit_do:
+			visit( i->cdo->body );
+			visit( &i->cdo->expr );
+			break;
+		case cit_switch:
+			visit( &i->cswitch->expr );
+			for ( ccase_t& c : i->cswitch->cases )
+				visit( &c );
+			break;
+		case cit_return:
+			visit( &i->creturn->expr );
+			break;
+		default:
+			break;
+	}
+}
+int ctree_visitor_t::apply_to( citem_t* item, citem_t* parent ) { return apply_item( *this, item, parent ); }
+
+// Functions and decompilation.
+//
+func_t* get_func( ea_t ea )
+{
+	auto& list = stub::db().functions;
+	auto it = std::upper_bound( list.begin(), list.end(), ea, [ ] ( ea_t ea, const func_t& f ) { return ea < f.start_ea; } );
+	if ( it == list.begin() )
+		return nullptr;
+	--it;
+	return ea < it->end_ea ? &*it : nullptr;
+}
+size_t get_func_qty() { return stub::db().functions.size(); }
+func_t* getn_func( size_t n ) { return n < get_func_qty() ? &stub::db().functions[ n ] : nullptr; }
+int get_func_num( ea_t ea )
+{
+	func_t* pfn = get_func( ea );
+	return pfn ? ( int ) ( pfn - stub::db().functions.data() ) : -1;
+}
+
+// Decompilation produces one line per byte of the function followed by the name and type of each callee.
+//
+cfuncptr_t decompile_func( func_t* pfn, hexrays_failure_t* hf, int )
+{
+	if ( !pfn )
+	{
+		if ( hf )
+			hf->code = MERR_INTERR;
+		return {};
+	}
+	auto* cfunc = new cfunc_t;
+	cfunc->entry_ea = pfn->start_ea;
+	qstring line;
+	std::vector<uint8_t> bytes( pfn->end_ea - pfn->start_ea );
+	get_bytes( bytes.data(), ( ssize_t ) bytes.size(), pfn->start_ea );
+	for ( size_t i = 0; i != bytes.size(); i++ )
+	{
+		line.clear();
+		line.cat_sprnt( "\x01\x0c" "byte_%llx = %02x;" "\x02\x0c", ( unsigned long long ) ( pfn->start_ea + i ), bytes[ i ] );
+		cfunc->sv.push_back( { line } );
+	}
+	for ( auto& x : stub::db().xrefs )
+	{
+		if ( x.from < pfn->start_ea || x.from >= pfn->end_ea )
+			continue;
+		qstring name, type;
+		tinfo_t t;
+		get_name( &name, x.to );
+		if ( get_tinfo( &t, x.to ) )
+			t.print( &type );
+		line.clear();
+		line.cat_sprnt( "%s %s;", type.c_str(), name.c_str() );
+		cfunc->sv.push_back( { line } );
+	}
+	return cfuncptr_t{ cfunc };
+}
+bool restore_user_lvar_settings( lvar_uservec_t* lvinf, ea_t func_ea )
+{
+	auto it = stub::db().user_lvars.find( func_ea );
+	if ( it == stub::db().user_lvars.end() )
+		return false;
+	*lvinf = it->second;
+	return true;
+}
+user_cmts_t* restore_user_cmts( ea_t func_ea )
+{
+	auto it = stub::db().user_cmts.find( func_ea );
+	return it == stub::db().user_cmts.end() ? nullptr : new user_cmts_t( it->second );
+}
+user_numforms_t* restore_user_numforms( ea_t func_ea )
+{
+	auto it = stub::db().user_numforms.find( func_ea );
+	return it == stub::db().user_numforms.end() ? nullptr : new user_numforms_t( it->second );
+}
+void mark_cfunc_dirty( ea_t ea, bool ) { stub::db().dirty_cfuncs.push_back( ea ); }
+void clear_cached_cfuncs() { stub::db().cfunc_cache_clears++; }
+
+// Database contents.
+//
+ssize_t get_bytes( void* buf, ssize_t size, ea_t ea, int, void* )
+{
+	auto* out = ( uint8_t* ) buf;
+	std::fill_n( out, size, 0 );
+	for ( auto& [key, value] : stub::db().bytes )
+		if ( key >= ea && key < ea + size )
+			out[ key - ea ] = value;
+	return size;
+}
+ssize_t get_name( qstring* out, ea_t ea, int )
+{
+	out->clear();
+	for ( auto& [key, name] : stub::db().names )
+		if ( key == ea )
+			return *out = qstring{ name.c_str() }, ( ssize_t ) name.size();
+	return -1;
+}
+flags64_t get_flags( ea_t ea )
+{
+	for ( auto& [key, name] : stub::db().names )
+		if ( key == ea )
+			return FF_NAME;
+	return 0;
+}
+ea_t get_first_fixup_ea() { return get_next_fixup_ea( 0 ) ; }
+ea_t get_next_fixup_ea( ea_t ea )
+{
+	for ( auto& [key, fd] : stub::db().fixups )
+		if ( key > ea )
+			return key;
+	return BADADDR;
+}
+bool fixup_data_t::get( ea_t source )
+{
+	for ( auto& [key, fd] : stub::db().fixups )
+		if ( key == source )
+			return *this = fd, true;
+	return false;
+}
+int calc_fixup_size( uint16 type ) { return type == 0 ? -1 : type >= 4 ? 8 : 4; }
+
+static bool xref_step( xrefblk_t& xb )
+{
+	auto& list = stub::db().xrefs;
+	for ( ; xb.cursor < list.size(); xb.cursor++ )
+	{
+		auto& x = list[ xb.cursor ];
+		if ( ( xb.forward ? x.from : x.to ) != xb.key )
+			continue;
+		xb.from = x.from;
+		xb.to = x.to;
+		xb.iscode = x.code;
+		xb.type = 0;
+		xb.user = 0;
+		xb.cursor++;
+		return true;
+	}
+	return false;
+}
+bool xrefblk_t::first_to( ea_t ea, int )
+{
+	cursor = 0;
+	key = ea;
+	forward = false;
+	return xref_step( *this );
+}
+bool xrefblk_t::next_to() { return xref_step( *this ); }
+bool xrefblk_t::first_from( ea_t ea, int )
+{
+	cursor = 0;
+	key = ea;
+	forward = true;
+	return xref_step( *this );
+}
+bool xrefblk_t::next_from() { return xref_step( *this ); }
+
+// Notifications.
+//
+bool hook_to_notification_point( hook_type_t type, hook_cb_t* cb, void* ud )
+{
+	if ( type != HT_IDB )
+		return false;
+	stub::callbacks().idb.emplace_back( cb, ud );
+	return true;
+}
+int unhook_from_notification_point( hook_type_t type, hook_cb_t* cb, void* ud )
+{
+	if ( type != HT_IDB )
+		return 0;
+	return erase_one( stub::callbacks().idb, std::pair{ cb, ud } ) ? 1 : 0;
+}
+
+// Threading, requests made from the main thread run immediately and others are queued for stub::run_requests. Like
+// the kernel, requests with MFF_NOWAIT are deleted once executed.
+//
+bool is_main_thread() { return std::this_thread::get_id() == stub::callbacks().main_thread; }
+int execute_sync( exec_request_t& req, int flags )
+{
+	if ( is_main_thread() )
+	{
+		int result = req.execute();
+		if ( flags & MFF_NOWAIT )
+			delete &req;
+		return result;
+	}
+	if ( !( flags & MFF_NOWAIT ) )
+		abort();
+	auto& s = stub::callbacks();
+	std::lock_guard _g{ s.request_lock };
+	s.requests.push_back( &req );
+	return 0;
+}
+qtimer_t register_timer( int, int ( idaapi* )( void* ), void* ud ) { return ud; }
+bool unregister_timer( qtimer_t ) { return true; }
+
+// Misc.
+//
+void msg( const char* format, ... )
+{
+	va_list va;
+	va_start( va, format );
+	vprintf( format, va );
+	va_end( va );
+}
+ssize_t tag_remove( qstring* buf, const char* str, int )
+{
+	std::string result;
+	for ( const char* p = str; *p; p++ )
+	{
+		if ( *p == '\x01' || *p == '\x02' )
+		{
+			if ( p[ 1 ] )
+				p++;
+			continue;
+		}
+		result += *p;
+	}
+	buf->s = std::move( result );
+	return ( ssize_t ) buf->length();
+}
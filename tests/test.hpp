@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdio>
+#include <vector>
+#include <functional>
+
+// Minimal self registering test runner, a failing CHECK reports the location and continues with the test.
+//
+namespace test
+{
+	struct entry
+	{
+		const char* name;
+		void( *fn )();
+	};
+	inline std::vector<entry>& registry() { static std::vector<entry> list; return list; }
+	inline int failures = 0;
+
+	struct registrar
+	{
+		registrar( const char* name, void( *fn )() ) { registry().push_back( { name, fn } ); }
+	};
+	inline void fail( const char* expr, const char* file, int line )
+	{
+		printf( "  %s:%d: CHECK( %s ) failed\n", file, line, expr );
+		failures++;
+	}
+};
+
+#define TEST( name )                                                  \
+	static void test_##name();                                        \
+	static test::registrar test_registrar_##name{ #name, &test_##name }; \
+	static void test_##name()
+#define CHECK( ... ) ( ( __VA_ARGS__ ) ? ( void ) 0 : test::fail( #__VA_ARGS__, __FILE__, __LINE__ ) )
@@ -0,0 +1,94 @@
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <hexsuite/architecture.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+static std::vector<uint64> immediates( mblock_t* blk )
+{
+	std::vector<uint64> result;
+	for ( minsn_t* ins = blk->head; ins; ins = ins->next )
+	{
+		CHECK( ins->next ? ins->next->prev == ins : blk->tail == ins );
+		result.push_back( ins->r.t == mop_n ? ins->r.nnn->value : 0 );
+	}
+	return result;
+}
+
+TEST( sequence_splices_chain )
+{
+	auto mba = fixture::chain( 1, 2 );
+	mblock_t* blk = mba->get_mblock( 0 );
+	auto run = [ ] ( uint64 a, uint64 b )
+	{
+		hex::insn_sequence seq{ 0x1000 };
+		seq.emit( m_add, hex::reg( 8, 4 ), hex::operand( a, 4 ), hex::reg( 8, 4 ) );
+		seq.emit( m_add, hex::reg( 8, 4 ), hex::operand( b, 4 ), hex::reg( 8, 4 ) );
+		return seq;
+	};
+
+	// Existing instructions carry #0 (mov) and #2 (add).
+	//
+	auto front = run( 10, 11 );
+	CHECK( front.size() == 2 );
+	front.insert_into( blk, nullptr );
+	CHECK( front.empty() && front.size() == 0 );
+	auto middle = run( 20, 21 );
+	CHECK( middle.insert_into( blk, blk->head->next->next ) == blk->head->next->next->next->next );
+	auto back = run( 30, 31 );
+	CHECK( back.append_to( blk ) == blk->tail );
+	CHECK( immediates( blk ) == std::vector<uint64>{ 10, 11, 0, 20, 21, 2, 30, 31 } );
+
+	hex::insn_sequence none{ 0x1000 };
+	CHECK( none.append_to( blk ) == blk->tail );
+}
+
+TEST( signature_prototypes )
+{
+	using sig = hex::signature<int32_t( uint8_t*, uint64_t, bool )>;
+	static_assert( sig::arity == 3 );
+	tinfo_t byte_ptr;
+	byte_ptr.create_ptr( tinfo_t{ BT_INT8 | BTMT_UNSIGNED } );
+	CHECK( hex::type_of<uint8_t*>() == byte_ptr );
+	CHECK( hex::type_of<const uint64_t>() == tinfo_t{ BT_INT64 | BTMT_UNSIGNED } );
+	CHECK( &hex::type_of<bool>() == &hex::type_of<bool>() );
+
+	const mcallinfo_t& proto = sig::prototype();
+	CHECK( proto.args.size() == 3 && proto.return_type == tinfo_t{ BT_INT32 | BTMT_SIGNED } );
+	CHECK( proto.args[ 0 ].type == byte_ptr && proto.args[ 1 ].type == hex::type_of<uint64_t>() && proto.args[ 2 ].type == tinfo_t{ BTF_BOOL } );
+	CHECK( proto.cc == CM_CC_FASTCALL && proto.flags == sig::default_flags );
+	CHECK( &sig::prototype() == &proto && &sig::prototype( CM_CC_CDECL ) != &proto );
+
+	// Calls copy the prototype and place the operands in order, keeping the argument types.
+	//
+	auto ci = sig::call_info_ex( CM_CC_CDECL, FCI_FINAL, hex::reg( 8, 8 ), hex::operand( 5u, 8 ), hex::operand( 1, 1 ) );
+	CHECK( ci->cc == CM_CC_CDECL && ci->flags == FCI_FINAL && ci->return_type == proto.return_type );
+	CHECK( ci->args.size() == 3 && ci->args[ 0 ].type == byte_ptr && ci->args[ 2 ].type == tinfo_t{ BTF_BOOL } );
+	CHECK( ci->args[ 0 ].t == mop_r && ci->args[ 0 ].r == 8 && ci->args[ 0 ].size == 8 );
+	CHECK( ci->args[ 1 ].t == mop_n && ci->args[ 1 ].nnn->value == 5 && ci->args[ 1 ].size == 8 );
+	CHECK( ci->args[ 2 ].t == mop_n && ci->args[ 2 ].nnn->value == 1 && ci->args[ 2 ].size == 1 );
+	CHECK( proto.args[ 0 ].t == mop_z );
+
+	auto pure = sig::call_info( hex::pure_t{}, hex::reg( 8, 8 ), hex::reg( 16, 8 ), hex::operand( 0, 1 ) );
+	CHECK( pure->flags == ( sig::default_flags | FCI_PURE ) && pure->cc == CM_CC_FASTCALL && pure->args[ 1 ].r == 16 );
+	CHECK( hex::signature<void()>::prototype().return_type.is_void() && hex::signature<void()>::call_info()->args.empty() );
+
+	// Concurrent lookups of new and existing prototypes agree.
+	//
+	using wide = hex::signature<double( float, int16_t )>;
+	std::vector<std::thread> threads;
+	std::atomic<int> mismatches = 0;
+	for ( int t = 0; t != 8; t++ )
+		threads.emplace_back( [ & ]
+		{
+			for ( int flags = 0; flags != 64; flags++ )
+			{
+				const mcallinfo_t& p = wide::prototype( CM_CC_STDCALL, flags );
+				mismatches += p.flags != flags || p.args.size() != 2 || &wide::prototype( CM_CC_STDCALL, flags ) != &p;
+			}
+		} );
+	for ( auto& t : threads )
+		t.join();
+	CHECK( mismatches == 0 );
+}
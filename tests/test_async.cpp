@@ -0,0 +1,74 @@
+#include <thread>
+#include <chrono>
+#include <hexsuite/async.hpp>
+#include "test.hpp"
+
+// Awaitable resuming the coroutine on a new thread, joined by the owner.
+//
+struct resume_on_worker
+{
+	std::thread& thread;
+	bool await_ready() { return false; }
+	void await_suspend( std::coroutine_handle<> handle ) { thread = std::thread( [ handle ] { handle.resume(); } ); }
+	void await_resume() {}
+};
+
+TEST( main_thread_reserve_wakes_on_stop )
+{
+	// With no capacity every request blocks until its token is cancelled.
+	//
+	stub::run_requests();
+	hex::main_thread::set_capacity( 0 );
+	std::stop_source source;
+	auto request = [ ] ( std::stop_token token ) -> hex::task<bool> { co_return co_await hex::main_thread{ token }; };
+
+	bool result = true;
+	std::thread worker( [ & ] { result = request( source.get_token() ).get(); } );
+	std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+	source.request_stop();
+	worker.join();
+	CHECK( !result );
+	hex::main_thread::set_capacity( 4096 );
+}
+
+TEST( main_thread_reserve_wakes_on_capacity )
+{
+	// A request blocked on a full queue proceeds once the capacity is raised from another thread.
+	//
+	stub::run_requests();
+	hex::main_thread::set_capacity( 0 );
+	auto request = [ ] () -> hex::task<bool> { co_return co_await hex::main_thread{}; };
+
+	std::atomic<bool> done = false;
+	bool result = false;
+	std::thread worker( [ & ] { result = request().get(); done = true; } );
+	std::this_thread::sleep_for( std::chrono::milliseconds( 20 ) );
+	CHECK( !done && hex::main_thread::pending() == 0 );
+	hex::main_thread::set_capacity( 4096 );
+	while ( !done )
+	{
+		stub::run_requests();
+		std::this_thread::yield();
+	}
+	worker.join();
+	CHECK( result && hex::main_thread::pending() == 0 );
+}
+
+TEST( task_get_on_main_thread_drains )
+{
+	// The task leaves for a worker and switches back, get() on the main thread has to run the switch itself.
+	//
+	stub::run_requests();
+	std::thread worker;
+	auto body = [ & ] () -> hex::task<bool>
+	{
+		co_await resume_on_worker{ worker };
+		bool ok = co_await hex::main_thread{};
+		co_return ok && is_main_thread();
+	};
+	CHECK( is_main_thread() );
+	CHECK( body().get() );
+	worker.join();
+	stub::run_requests();
+	CHECK( hex::main_thread::pending() == 0 );
+}
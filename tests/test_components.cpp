@@ -0,0 +1,90 @@
+#include <hexsuite/components.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+static int run_all( mba_t* mba )
+{
+	int changes = 0;
+	for ( int i = 0; i != mba->qty; i++ )
+		for ( minsn_t* ins = mba->get_mblock( i )->head; ins; ins = ins->next )
+			changes += stub::run_optinsn( mba->get_mblock( i ), ins );
+	return changes;
+}
+
+TEST( dispatcher_filters_by_opcode )
+{
+	int xors = 0, adds = 0;
+	auto a = hex::insn_optimizer_for<m_xor>( [ & ] ( mblock_t*, minsn_t* ins, int ) { xors += ins->opcode == m_xor; return 0; } );
+	auto b = hex::insn_optimizer_for<m_add, m_xor>( [ & ] ( mblock_t*, minsn_t* ins, int ) { adds += ins->opcode == m_add || ins->opcode == m_xor; return 0; } );
+	a.install();
+	b.install();
+	CHECK( stub::optinsn_count() == 1 );
+
+	// 16 instructions cycling through mov, add, xor, sub, and, or, mul, shl.
+	//
+	auto mba = fixture::chain( 1, 16 );
+	CHECK( run_all( mba.get() ) == 0 );
+	CHECK( xors == 2 );
+	CHECK( adds == 4 );
+
+	a.uninstall();
+	CHECK( stub::optinsn_count() == 1 );
+	b.uninstall();
+	CHECK( stub::optinsn_count() == 0 );
+}
+
+TEST( dispatcher_changes_during_dispatch )
+{
+	int first = 0, second = 0, late = 0;
+	hex::component* victim = nullptr;
+	hex::component* newcomer = nullptr;
+	auto c = hex::insn_optimizer_for<m_xor>( [ & ] ( mblock_t*, minsn_t*, int ) { late++; return 0; } );
+	auto b = hex::insn_optimizer_for<m_xor>( [ & ] ( mblock_t*, minsn_t*, int ) { second++; return 0; } );
+	auto a = hex::insn_optimizer_for<m_xor>( [ & ] ( mblock_t*, minsn_t*, int )
+	{
+		if ( !first++ )
+		{
+			victim->uninstall();
+			newcomer->install();
+		}
+		return 0;
+	} );
+	victim = &b;
+	newcomer = &c;
+	a.install();
+	b.install();
+
+	// The removed handler is skipped right away, the added one only runs from the next dispatch on.
+	//
+	auto mba = fixture::chain( 1, 3 );
+	minsn_t* ins = mba->get_mblock( 0 )->tail;
+	CHECK( ins->opcode == m_xor );
+	stub::run_optinsn( mba->get_mblock( 0 ), ins );
+	CHECK( first == 1 && second == 0 && late == 0 );
+	stub::run_optinsn( mba->get_mblock( 0 ), ins );
+	CHECK( first == 2 && second == 0 && late == 1 );
+
+	a.uninstall();
+	c.uninstall();
+	CHECK( hex::detail::insn_dispatcher::instance().count == 0 );
+	CHECK( stub::optinsn_count() == 0 );
+}
+
+TEST( filter_owns_itype_set )
+{
+	int applied = 0;
+	hex::microcode_filter filter{ hex::itype_set{ std::in_place, 5, 700 }, [ & ] ( codegen_t& ) { applied++; return true; } };
+	microcode_filter_t& f = filter;
+
+	codegen_t cdg = {};
+	for ( uint16_t itype : { 4, 5, 6, 700, 4095 } )
+	{
+		cdg.insn.itype = itype;
+		if ( f.match( cdg ) )
+			CHECK( f.apply( cdg ) == MERR_OK );
+	}
+	CHECK( applied == 2 );
+
+	hex::microcode_filter any = [ & ] ( codegen_t& ) { return false; };
+	CHECK( ( ( microcode_filter_t& ) any ).match( cdg ) );
+}
@@ -0,0 +1,177 @@
+#include <hexsuite/dataflow.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+static minsn_t* emit_mov( mblock_t* blk, const mop_t& src, const mop_t& dst )
+{
+	minsn_t* ins = new minsn_t( blk->start );
+	ins->opcode = m_mov;
+	ins->l = src;
+	ins->d = dst;
+	ins->d.size = ins->l.size = dst.size;
+	return blk->insert_into_block( ins, blk->tail );
+}
+static mop_t reg( mreg_t r, int size = 4 ) { mop_t op; op.make_reg( r, size ); return op; }
+static mop_t num( uint64 v, int size = 4 ) { mop_t op; op.make_number( v, size ); return op; }
+static mop_t stkvar( mba_t* mba, sval_t off, int size = 4 ) { mop_t op; op.make_stkvar( mba, off ); op.size = size; return op; }
+static mop_t gvar( ea_t ea, int size = 4 ) { mop_t op; op.make_gvar( ea ); op.size = size; return op; }
+
+// Linear function of the given number of blocks whose last block is the stop block using r0.4.
+//
+static fixture::mba_ptr linear( int blocks )
+{
+	fixture::mba_ptr mba{ stub::create_mba( blocks ) };
+	for ( int i = 0; i + 1 != blocks; i++ )
+		stub::add_edge( mba.get(), i, i + 1 );
+	mblock_t* stop = mba->get_mblock( blocks - 1 );
+	stop->type = BLT_STOP;
+	stop->maybuse.reg.add( 0, 4 );
+	return mba;
+}
+
+TEST( liveness_across_calls )
+{
+	// 0: r8 = #1, r16 = #2, r0 = #3, r24 = #4
+	// 1: call $f(pass r8), defines r0, spoils r16
+	// 2: r32 = r16
+	// 3: stop (uses r0)
+	//
+	auto mba = linear( 4 );
+	mblock_t* b0 = mba->get_mblock( 0 );
+	mblock_t* b1 = mba->get_mblock( 1 );
+	for ( auto [r, v] : { std::pair{ 8, 1 }, { 16, 2 }, { 0, 3 }, { 24, 4 } } )
+		emit_mov( b0, num( v ), reg( r ) );
+
+	auto* ci = new mcallinfo_t( 0x2000 );
+	ci->pass_regs.reg.add( 8, 4 );
+	ci->return_regs.reg.add( 0, 4 );
+	ci->spoiled.reg.add( 16, 4 );
+	minsn_t* call = new minsn_t( b1->start );
+	call->opcode = m_call;
+	call->l.make_gvar( 0x2000 );
+	call->d.t = mop_f;
+	call->d.f = ci;
+	b1->insert_into_block( call, nullptr );
+	emit_mov( mba->get_mblock( 2 ), reg( 16 ), reg( 32 ) );
+
+	hex::liveness live{ mba.get() };
+	CHECK( live.is_live_out( b0, reg( 8 ) ) );       // Passed to the call.
+	CHECK( !live.is_live_out( b0, reg( 0 ) ) );      // Must-defined by the call.
+	CHECK( live.is_live_out( b0, reg( 16 ) ) );      // Only may-spoiled, the old value can still be read after it.
+	CHECK( !live.is_live_out( b0, reg( 24 ) ) );
+	CHECK( live.is_live_out( b1, reg( 0 ) ) );       // Returned.
+	CHECK( !live.is_live_out( b1, reg( 8 ) ) );
+
+	// An unresolved call may read every register and all of memory.
+	//
+	call->d.erase();
+	hex::liveness unresolved{ mba.get() };
+	CHECK( unresolved.is_live_out( b0, reg( 24 ) ) );
+	CHECK( unresolved.is_live_out( b0, reg( 0 ) ) );
+}
+
+TEST( liveness_at_return )
+{
+	// 0: r0 = #1, r8 = #2, var_20 = #3, $5000 = #4
+	// 1: r16 = [ds:r8]
+	// 2: var_20 = #5
+	// 3: stop (uses r0)
+	//
+	auto mba = linear( 4 );
+	mblock_t* b0 = mba->get_mblock( 0 );
+	mblock_t* b1 = mba->get_mblock( 1 );
+	mblock_t* b2 = mba->get_mblock( 2 );
+	emit_mov( b0, num( 1 ), reg( 0 ) );
+	emit_mov( b0, num( 2 ), reg( 8 ) );
+	emit_mov( b0, num( 3 ), stkvar( mba.get(), 0x20 ) );
+	emit_mov( b0, num( 4 ), gvar( 0x5000 ) );
+	minsn_t* load = new minsn_t( b1->start );
+	load->opcode = m_ldx;
+	load->l = reg( 40, 2 );
+	load->r = reg( 8 );
+	load->d = reg( 16 );
+	b1->insert_into_block( load, nullptr );
+	emit_mov( b2, num( 5 ), stkvar( mba.get(), 0x20 ) );
+
+	hex::liveness live{ mba.get() };
+	CHECK( live.is_live_out( b0, reg( 0 ) ) );
+	CHECK( live.is_live_out( b0, reg( 8 ) ) );
+	CHECK( !live.is_live_out( b1, reg( 8 ) ) );
+	CHECK( !live.is_live_out( b2, reg( 16 ) ) );
+
+	// The load may read the stack variable before it is overwritten, memory is live at the exit.
+	//
+	CHECK( live.is_live_out( b0, stkvar( mba.get(), 0x20 ) ) );
+	CHECK( !live.is_live_out( b1, stkvar( mba.get(), 0x20 ) ) );
+	CHECK( live.is_live_out( b2, gvar( 0x5000 ) ) );
+
+	// Locations that are never must-defined are not tracked and always live, constants never are.
+	//
+	CHECK( live.is_live_out( b2, gvar( 0x6000 ) ) );
+	CHECK( live.is_live_out( b2, reg( 0x400 ) ) );
+	CHECK( !live.is_live_out( b0, num( 1 ) ) );
+}
+
+TEST( reaching_definitions_of_calls )
+{
+	auto mba = linear( 3 );
+	mblock_t* b0 = mba->get_mblock( 0 );
+	mblock_t* b1 = mba->get_mblock( 1 );
+	emit_mov( b0, num( 1 ), reg( 0 ) );
+	emit_mov( b0, num( 2 ), reg( 8 ) );
+
+	auto* ci = new mcallinfo_t( 0x2000 );
+	ci->return_regs.reg.add( 0, 4 );
+	minsn_t* call = new minsn_t( b1->start );
+	call->opcode = m_call;
+	call->l.make_gvar( 0x2000 );
+	call->d.t = mop_f;
+	call->d.f = ci;
+	b1->insert_into_block( call, nullptr );
+
+	hex::reaching_definitions rd{ mba.get() };
+	CHECK( rd.definitions.size() == 3 );
+	CHECK( rd.definitions[ 2 ].ins == call );
+	CHECK( rd.reach_out[ 1 ].test( 1 ) && rd.reach_out[ 1 ].test( 2 ) );
+	CHECK( !rd.reach_out[ 1 ].test( 0 ) );
+}
+
+TEST( access_lists_match_queries )
+{
+	// Registers spanning several words, stack and global memory and an unresolved call reading everything.
+	//
+	auto mba = linear( 3 );
+	mblock_t* b0 = mba->get_mblock( 0 );
+	mblock_t* b1 = mba->get_mblock( 1 );
+	emit_mov( b0, num( 1 ), reg( 0 ) );
+	emit_mov( b0, reg( 60, 8 ), reg( 130, 8 ) );
+	emit_mov( b0, gvar( 0x5000 ), stkvar( mba.get(), 0x20 ) );
+	minsn_t* call = new minsn_t( b1->start );
+	call->opcode = m_call;
+	call->l.make_gvar( 0x2000 );
+	b1->insert_into_block( call, nullptr );
+	emit_mov( b1, stkvar( mba.get(), 0x20 ), reg( 8 ) );
+
+	hex::access_lists accesses;
+	hex::location_map map = hex::location_map::build( mba.get(), &accesses );
+	CHECK( map.reg_count > 128 && map.size() > map.reg_count );
+	CHECK( hex::location_map::build( mba.get() ).size() == map.size() );
+	CHECK( ( accesses.offsets == std::vector<uint32_t>{ 0, 3, 5, 5 } ) && accesses.uses.size() == 5 && accesses.defs.size() == 5 );
+
+	uint32_t i = 0;
+	for ( mblock_t* blk : hex::basic_blocks( mba.get() ) )
+	{
+		for ( minsn_t* ins = blk->head; ins; ins = ins->next, i++ )
+		{
+			hex::dense_bitset recorded{ map.size() }, queried{ map.size() };
+			map.add( recorded, accesses, accesses.uses[ i ] );
+			map.add( queried, blk->build_use_list( *ins, MAY_ACCESS ) );
+			CHECK( recorded == queried );
+			recorded.clear();
+			queried.clear();
+			map.add( recorded, accesses, accesses.defs[ i ] );
+			map.add( queried, blk->build_def_list( *ins, MUST_ACCESS ) );
+			CHECK( recorded == queried );
+		}
+	}
+}
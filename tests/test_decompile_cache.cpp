@@ -0,0 +1,162 @@
+#include <filesystem>
+#include <hexsuite/decompile_cache.hpp>
+#include "test.hpp"
+
+static func_t* make_function( ea_t start )
+{
+	func_t* pfn = stub::add_func( start, start + 0x10 );
+	for ( ea_t ea = start; ea != start + 0x10; ea++ )
+		stub::db().bytes.emplace_back( ea, ( uint8_t ) ( ea - start ) );
+	return pfn;
+}
+
+TEST( fingerprint_reference_targets )
+{
+	stub::set_name( 0x9000, "g_table" );
+	stub::set_type( 0x9000, tinfo_t{ BT_INT32 } );
+	func_t* pfn = make_function( 0x1000 );
+	hex::fingerprint base = hex::function_fingerprint( pfn );
+
+	// Data reference not backed by a fixup, both its name and type are part of the fingerprint.
+	//
+	stub::db().xrefs.push_back( { 0x1004, 0x9000, false } );
+	hex::fingerprint with_ref = hex::function_fingerprint( pfn );
+	CHECK( with_ref != base );
+	stub::set_name( 0x9000, "g_renamed" );
+	hex::fingerprint renamed = hex::function_fingerprint( pfn );
+	CHECK( renamed != with_ref );
+	stub::set_type( 0x9000, tinfo_t{ BT_INT64 } );
+	CHECK( hex::function_fingerprint( pfn ) != renamed );
+
+	// References within the function do not name anything.
+	//
+	hex::fingerprint before = hex::function_fingerprint( pfn );
+	stub::db().xrefs.push_back( { 0x1008, 0x1002, true } );
+	CHECK( hex::function_fingerprint( pfn ) == before );
+}
+
+TEST( fingerprint_entry )
+{
+	// Identical auto-named functions at different addresses decompile to sub_1000 and sub_2000.
+	//
+	stub::set_name( 0x9000, "callee" );
+	make_function( 0x1000 );
+	make_function( 0x2000 );
+	stub::db().xrefs.push_back( { 0x1004, 0x9000, true } );
+	stub::db().xrefs.push_back( { 0x2004, 0x9000, true } );
+	CHECK( hex::function_fingerprint( get_func( 0x1000 ) ) != hex::function_fingerprint( get_func( 0x2000 ) ) );
+
+	// Naming the entry changes the key as well.
+	//
+	hex::fingerprint unnamed = hex::function_fingerprint( get_func( 0x1000 ) );
+	stub::set_name( 0x1000, "parse_header" );
+	CHECK( hex::function_fingerprint( get_func( 0x1000 ) ) != unnamed );
+}
+
+TEST( fingerprint_user_settings )
+{
+	func_t* pfn = make_function( 0x1000 );
+	auto& db = stub::db();
+	hex::fingerprint last = hex::function_fingerprint( pfn );
+	auto changed = [ & ]
+	{
+		hex::fingerprint f = hex::function_fingerprint( pfn );
+		return f != std::exchange( last, f );
+	};
+
+	lvar_saved_info_t lv;
+	lv.ll.location = { 1, 8 };
+	lv.ll.defea = 0x1002;
+	lv.name = "counter";
+	db.user_lvars[ 0x1000 ].lvvec.push_back( lv );
+	CHECK( changed() );
+	db.user_lvars[ 0x1000 ].lvvec[ 0 ].type = tinfo_t{ BT_INT16 };
+	CHECK( changed() );
+	db.user_lvars[ 0x1000 ].lmaps[ lv.ll ] = lvar_locator_t{ { 0, 0x10 }, 0x1004 };
+	CHECK( changed() );
+
+	db.user_cmts[ 0x1000 ][ treeloc_t{ 0x1006, ITP_SEMI } ] = "note";
+	CHECK( changed() );
+	db.user_cmts[ 0x1000 ][ treeloc_t{ 0x1006, ITP_SEMI } ] = "other note";
+	CHECK( changed() );
+
+	db.user_numforms[ 0x1000 ][ operand_locator_t{ 0x1008, 1 } ].flags32 = 0x1100000;
+	CHECK( changed() );
+	CHECK( !changed() );
+}
+
+TEST( file_cache_keeps_geometry )
+{
+	auto path = ( std::filesystem::temp_directory_path() / "hexsuite_test_cache.bin" ).string();
+	std::filesystem::remove( path );
+	hex::fingerprint key{ 1, 2 };
+	{
+		hex::file_cache cache{ path.c_str(), 4 << 20, 64 };
+		cache.store( key, { "text", "facts" } );
+		CHECK( cache.head()->bucket_count == 64 );
+	}
+	{
+		hex::file_cache cache{ path.c_str(), 4 << 20, 1024 };
+		CHECK( cache.head()->bucket_count == 64 );
+		hex::cache_entry entry;
+		CHECK( cache.find( key, entry ) );
+		CHECK( entry.text == "text" && entry.facts == "facts" );
+	}
+	std::filesystem::remove( path );
+}
+
+TEST( file_cache_rejects_damaged_records )
+{
+	auto path = ( std::filesystem::temp_directory_path() / "hexsuite_test_cache_damaged.bin" ).string();
+	std::filesystem::remove( path );
+	hex::fingerprint key{ 1, 2 };
+	hex::file_cache cache{ path.c_str(), 4 << 20, 64 };
+	cache.store( key, { "text", "facts" } );
+	hex::file_cache::bucket* b = cache.probe( key );
+	hex::cache_entry entry;
+	CHECK( cache.find( key, entry ) );
+
+	// Offsets outside of the log and sizes running past its end are misses.
+	//
+	uint64_t offset = b->offset;
+	b->offset = cache.head()->data_end;
+	CHECK( !cache.find( key, entry ) );
+	b->offset = offset;
+	auto* r = ( hex::file_cache::record* ) ( cache.file.data + offset );
+	r->text_size = 1 << 30;
+	CHECK( !cache.find( key, entry ) );
+	r->text_size = 4;
+	CHECK( cache.find( key, entry ) && entry.text == "text" );
+
+	cache.file.close();
+	std::filesystem::remove( path );
+}
+
+TEST( file_cache_rejects_oversized_records )
+{
+	auto path = ( std::filesystem::temp_directory_path() / "hexsuite_test_cache_oversized.bin" ).string();
+	std::filesystem::remove( path );
+	hex::file_cache cache{ path.c_str(), 4 << 20, 64 };
+	size_t log = cache.max_size - cache.head()->data_begin;
+	hex::cache_entry entry;
+
+	// Records above half of the log could not fit next to what compaction keeps.
+	//
+	cache.store( { 1, 1 }, { std::string( log * 45 / 100, 'a' ), {} } );
+	cache.store( { 2, 2 }, { std::string( log * 60 / 100, 'b' ), {} } );
+	CHECK( cache.find( { 1, 1 }, entry ) && entry.text.size() == log * 45 / 100 );
+	CHECK( !cache.find( { 2, 2 }, entry ) );
+	CHECK( cache.head()->data_end <= cache.file.size );
+
+	// Filling the log compacts it down to the most recently used records.
+	//
+	cache.store( { 3, 3 }, { std::string( log * 45 / 100, 'c' ), {} } );
+	cache.store( { 4, 4 }, { std::string( log * 45 / 100, 'd' ), {} } );
+	CHECK( cache.find( { 4, 4 }, entry ) && entry.text.back() == 'd' );
+	CHECK( cache.find( { 3, 3 }, entry ) && entry.text.back() == 'c' );
+	CHECK( !cache.find( { 1, 1 }, entry ) );
+	CHECK( cache.head()->data_end <= cache.max_size );
+
+	cache.file.close();
+	std::filesystem::remove( path );
+}
@@ -0,0 +1,48 @@
+#include <hexsuite/dirty_tracker.hpp>
+#include "test.hpp"
+
+TEST( dirty_tracker_events )
+{
+	stub::reset();
+	stub::add_func( 0x1000, 0x1010 );
+	stub::add_func( 0x2000, 0x2010 );
+	stub::add_func( 0x3000, 0x3010 );
+	stub::db().xrefs.push_back( { 0x1004, 0x3000, true } );
+	func_t* caller = get_func( 0x1000 );
+
+	hex::dirty_tracker tracker{ true };
+	tracker.install();
+	CHECK( tracker.empty() );
+
+	// Renaming a function dirties its callers, local names do not leave it.
+	//
+	stub::raise_idb( idb_event::renamed, ( ea_t ) 0x3000, "callee", 0 );
+	CHECK( tracker.take() == std::vector<ea_t>{ 0x1000, 0x3000 } );
+	stub::raise_idb( idb_event::renamed, ( ea_t ) 0x3008, "label", 1 );
+	CHECK( tracker.take() == std::vector<ea_t>{ 0x3000 } );
+	stub::raise_idb( idb_event::byte_patched, ( ea_t ) 0x2004, ( uint32 ) 0 );
+	CHECK( tracker.is_dirty( 0x2000 ) && !tracker.is_dirty( 0x1000 ) );
+	tracker.clear();
+
+	// Moving the entry tracks the function under its new start, its stale ctree is still invalidated.
+	//
+	stub::db().dirty_cfuncs.clear();
+	stub::raise_idb( idb_event::set_func_start, caller, ( ea_t ) 0x0FF0 );
+	CHECK( stub::db().dirty_cfuncs == std::vector<ea_t>{ 0x1000 } );
+	caller->start_ea = 0x0FF0;
+	std::vector<ea_t> drained;
+	CHECK( tracker.drain( [ & ] ( func_t* pfn ) { drained.push_back( pfn->start_ea ); } ) == 1 );
+	CHECK( drained == std::vector<ea_t>{ 0x0FF0 } );
+
+	// Type library changes dirty everything and drop every cached ctree.
+	//
+	stub::raise_idb( idb_event::local_types_changed, 0, ( uint32 ) 0, "" );
+	CHECK( tracker.size() == 3 && tracker.is_dirty( 0x2008 ) );
+	CHECK( stub::db().cfunc_cache_clears == 1 );
+	CHECK( tracker.take().size() == 3 );
+
+	tracker.uninstall();
+	stub::raise_idb( idb_event::renamed, ( ea_t ) 0x3000, "other", 0 );
+	CHECK( tracker.empty() );
+	stub::reset();
+}
@@ -0,0 +1,121 @@
+#include <hexsuite/dominators.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+static std::vector<int> frontier_of( const hex::cfg_info& cfg, int b ) { auto f = cfg.frontier[ b ]; return { f.begin(), f.end() }; }
+
+TEST( dominators_of_chain )
+{
+	auto mba = fixture::chain( 5, 1 );
+	hex::cfg_info cfg{ mba.get() };
+	for ( int b = 1; b != 5; b++ )
+	{
+		CHECK( cfg.dom.immediate( b ) == b - 1 );
+		CHECK( cfg.pdom.immediate( b - 1 ) == b );
+		CHECK( frontier_of( cfg, b ).empty() );
+	}
+	CHECK( cfg.dom.immediate( 0 ) == -1 && cfg.pdom.immediate( 4 ) == -1 );
+	CHECK( cfg.dom.dominates( 0, 4 ) && !cfg.dom.dominates( 4, 0 ) && cfg.dom.dominates( 2, 2 ) && !cfg.dom.strictly_dominates( 2, 2 ) );
+	CHECK( cfg.pdom.dominates( 4, 0 ) && !cfg.pdom.dominates( 0, 4 ) );
+	CHECK( cfg.loops.loops.empty() && cfg.loops.depth_of( 2 ) == 0 );
+}
+
+TEST( dominators_of_flattened )
+{
+	// 0 -> 1 (dispatcher) -> 2, 3, 4 (states), 2 and 3 loop back to the dispatcher, 4 leaves to 5 (exit).
+	//
+	auto mba = fixture::flattened( 3, 1 );
+	hex::cfg_info cfg{ mba.get() };
+	CHECK( cfg.dom.immediate( 1 ) == 0 );
+	for ( int b : { 2, 3, 4 } )
+		CHECK( cfg.dom.immediate( b ) == 1 );
+	CHECK( cfg.dom.immediate( 5 ) == 4 );
+	std::vector<int> children{ cfg.dom.children_of( 1 ).begin(), cfg.dom.children_of( 1 ).end() };
+	std::sort( children.begin(), children.end() );
+	CHECK( ( children == std::vector<int>{ 2, 3, 4 } ) );
+
+	CHECK( cfg.pdom.immediate( 4 ) == 5 && cfg.pdom.immediate( 1 ) == 4 && cfg.pdom.immediate( 0 ) == 1 );
+	CHECK( cfg.pdom.immediate( 2 ) == 1 && cfg.pdom.immediate( 3 ) == 1 );
+
+	CHECK( frontier_of( cfg, 1 ) == std::vector<int>{ 1 } );
+	CHECK( frontier_of( cfg, 2 ) == std::vector<int>{ 1 } );
+	CHECK( frontier_of( cfg, 3 ) == std::vector<int>{ 1 } );
+	CHECK( frontier_of( cfg, 0 ).empty() && frontier_of( cfg, 4 ).empty() );
+
+	CHECK( cfg.loops.loops.size() == 1 );
+	const auto& l = cfg.loops.loops[ 0 ];
+	CHECK( l.header == 1 && l.depth == 1 && l.parent == -1 );
+	CHECK( l.blocks == std::vector<int>{ 1, 2, 3 } );
+	CHECK( l.latches == std::vector<int>{ 2, 3 } );
+	CHECK( cfg.loops.depth_of( 4 ) == 0 && cfg.loops.loop_of( 3 ) == &l );
+}
+
+TEST( dominators_of_nested_loops )
+{
+	// 0 -> 1, diamond 1 -> 2 | 3 -> 4, inner loop 4 <-> 5, outer back edge 5 -> 1, 5 -> 7 (exit). Block 6 is only
+	// a predecessor of the exit and unreachable from the entry.
+	//
+	fixture::mba_ptr mba{ stub::create_mba( 8 ) };
+	for ( auto [from, to] : { std::pair{ 0, 1 }, { 1, 2 }, { 1, 3 }, { 2, 4 }, { 3, 4 }, { 4, 5 }, { 5, 4 }, { 5, 1 }, { 5, 7 }, { 6, 7 } } )
+		stub::add_edge( mba.get(), from, to );
+	hex::cfg_info cfg{ mba.get() };
+
+	int idom[] = { -1, 0, 1, 1, 1, 4, -1, 5 };
+	for ( int b = 0; b != 8; b++ )
+		CHECK( cfg.dom.immediate( b ) == idom[ b ] );
+	CHECK( !cfg.dom.reachable( 6 ) && !cfg.dom.dominates( 0, 6 ) );
+
+	int ipdom[] = { 1, 4, 4, 4, 5, 7, 7, -1 };
+	for ( int b = 0; b != 8; b++ )
+		CHECK( cfg.pdom.immediate( b ) == ipdom[ b ] );
+	CHECK( cfg.pdom.dominates( 4, 2 ) && !cfg.pdom.dominates( 2, 1 ) );
+
+	CHECK( frontier_of( cfg, 0 ).empty() );
+	CHECK( frontier_of( cfg, 1 ) == std::vector<int>{ 1 } );
+	CHECK( frontier_of( cfg, 2 ) == std::vector<int>{ 4 } );
+	CHECK( frontier_of( cfg, 3 ) == std::vector<int>{ 4 } );
+	CHECK( ( frontier_of( cfg, 4 ) == std::vector<int>{ 1, 4 } ) );
+	CHECK( ( frontier_of( cfg, 5 ) == std::vector<int>{ 1, 4 } ) );
+	CHECK( frontier_of( cfg, 6 ).empty() && frontier_of( cfg, 7 ).empty() );
+
+	CHECK( cfg.loops.loops.size() == 2 );
+	const auto& outer = cfg.loops.loops[ 0 ];
+	const auto& inner = cfg.loops.loops[ 1 ];
+	CHECK( outer.header == 1 && outer.depth == 1 && outer.parent == -1 );
+	CHECK( ( outer.blocks == std::vector<int>{ 1, 2, 3, 4, 5 } ) );
+	CHECK( inner.header == 4 && inner.depth == 2 && inner.parent == 0 );
+	CHECK( ( inner.blocks == std::vector<int>{ 4, 5 } ) && inner.latches == std::vector<int>{ 5 } );
+	int depth[] = { 0, 1, 1, 1, 2, 2, 0, 0 };
+	for ( int b = 0; b != 8; b++ )
+		CHECK( cfg.loops.depth_of( b ) == depth[ b ] );
+	CHECK( outer.contains( 3 ) && !inner.contains( 3 ) );
+}
+
+TEST( cfg_cache_revalidates )
+{
+	auto mba = fixture::chain( 4, 2 );
+	auto cfg = hex::cfg_analysis( mba.get() );
+	CHECK( stub::hexrays_callback_count() == 1 );
+	CHECK( cfg->dom.dominates( 1, 3 ) );
+	CHECK( hex::cfg_analysis( mba.get() ) == cfg );
+
+	// Edits in the middle of a phase are seen by the next lookup, including retargeted edges keeping the edge count.
+	//
+	stub::add_edge( mba.get(), 0, 3 );
+	auto updated = hex::cfg_analysis( mba.get() );
+	CHECK( updated != cfg && !updated->dom.dominates( 1, 3 ) );
+	CHECK( hex::cfg_analysis( mba.get() ) == updated );
+	mba->get_mblock( 0 )->succset.back() = 2;
+	mba->get_mblock( 3 )->predset.pop_back();
+	mba->get_mblock( 2 )->predset.push_back( 0 );
+	auto retargeted = hex::cfg_analysis( mba.get() );
+	CHECK( retargeted != updated && retargeted->dom.immediate( 2 ) == 0 && retargeted->dom.dominates( 2, 3 ) );
+
+	// Analyses stay valid after they are dropped, release unsubscribes from the bus.
+	//
+	stub::raise_hexrays( hxe_microcode, mba.get() );
+	CHECK( hex::cfg_analysis( mba.get() ) != retargeted );
+	CHECK( cfg->dom.dominates( 1, 3 ) );
+	hex::release_cfg_analysis();
+	CHECK( stub::hexrays_callback_count() == 0 );
+}
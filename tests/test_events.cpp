@@ -0,0 +1,59 @@
+#include <memory>
+#include <hexsuite/events.hpp>
+#include <hexsuite/scheduler.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+TEST( listeners_share_decoder )
+{
+	int calls = 0;
+	mba_t* seen[ 2 ] = {};
+	auto a = hex::event_listener_for<hxe_microcode>( [ & ] ( mba_t* mba ) { seen[ 0 ] = mba; calls++; } );
+	auto b = hex::event_listener_for<hxe_microcode>( [ & ] ( mba_t* mba ) { seen[ 1 ] = mba; calls++; return 0; } );
+	a.install();
+	b.install();
+
+	auto& list = hex::event_bus::instance().table[ hxe_microcode ];
+	CHECK( list.size() == 2 );
+	CHECK( list[ 0 ].decoder == list[ 1 ].decoder );
+	CHECK( list[ 0 ].decoder == &hex::detail::decode_args<std::tuple<mba_t*>> );
+
+	auto mba = fixture::chain( 1, 1 );
+	stub::raise_hexrays( hxe_microcode, mba.get() );
+	CHECK( calls == 2 );
+	CHECK( seen[ 0 ] == mba.get() && seen[ 1 ] == mba.get() );
+
+	a.uninstall();
+	b.uninstall();
+	CHECK( stub::hexrays_callback_count() == 0 );
+}
+
+TEST( unsubscribe_during_dispatch )
+{
+	int first = 0, second = 0;
+	auto on_event = [ & ] ( mba_t* ) { second++; };
+	auto victim = std::make_unique<hex::event_listener<hxe_microcode, decltype( on_event )>>( std::move( on_event ) );
+
+	// One-shot listener pattern, the higher priority listener destroys the other one mid-dispatch.
+	//
+	auto a = hex::event_listener_for<hxe_microcode>( [ & ] ( mba_t* )
+	{
+		first++;
+		if ( victim )
+		{
+			victim->uninstall();
+			victim.reset();
+		}
+	}, 10 );
+	a.install();
+	victim->install();
+
+	auto mba = fixture::chain( 1, 1 );
+	stub::raise_hexrays( hxe_microcode, mba.get() );
+	CHECK( first == 1 && second == 0 );
+	CHECK( hex::event_bus::instance().table[ hxe_microcode ].size() == 1 );
+	CHECK( hex::event_bus::instance().count == 1 );
+
+	a.uninstall();
+	CHECK( stub::hexrays_callback_count() == 0 );
+}
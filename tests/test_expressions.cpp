@@ -0,0 +1,47 @@
+#include <hexsuite/expressions.hpp>
+#include "test.hpp"
+
+TEST( shift_count_width )
+{
+	auto e = hex::x<4>( hex::reg( 8, 4 ) ) << 3;
+	CHECK( e.r.width() == 1 );
+	CHECK( e.width() == 4 );
+	static_assert( decltype( e )::static_width == 4 );
+
+	auto ins = hex::build( 0x1000, hex::x<8>( hex::reg( 8, 8 ) ) >> 5, hex::reg( 16, 8 ) );
+	CHECK( ins->opcode == m_shr );
+	CHECK( ins->l.size == 8 && ins->r.size == 1 && ins->d.size == 8 );
+	CHECK( ins->r.nnn->value == 5 );
+
+	auto sar = hex::binary<m_sar>( hex::x( hex::reg( 8, 2 ) ), 1 );
+	CHECK( sar.r.width() == 1 && sar.width() == 2 );
+}
+
+TEST( constant_width_follows_operand )
+{
+	auto e = hex::x<4>( hex::reg( 8, 4 ) ) + 3;
+	CHECK( e.r.width() == 4 );
+	auto ins = hex::build( 0x1000, e );
+	CHECK( ins->opcode == m_add && ins->r.size == 4 && ins->d.size == 4 );
+}
+
+template<typename L, typename R>
+concept can_shl = requires( L l, R r ) { l << r; };
+template<typename L, typename R>
+concept can_sar = requires( L l, R r ) { hex::binary<m_sar>( l, r ); };
+template<typename L, typename R>
+concept can_add = requires( L l, R r ) { l + r; };
+
+TEST( shift_value_needs_width )
+{
+	using count_t = decltype( hex::x<4>( hex::reg( 8, 4 ) ) );
+	static_assert( !can_shl<int, count_t> );
+	static_assert( !can_sar<int, count_t> );
+	static_assert( can_shl<count_t, int> );
+	static_assert( can_add<int, count_t> );
+
+	auto e = hex::imm<4>( 1 ) << hex::x<1>( hex::reg( 8, 1 ) );
+	CHECK( e.width() == 4 && e.r.width() == 1 );
+	auto ins = hex::build( 0x1000, e );
+	CHECK( ins->opcode == m_shl && ins->l.size == 4 && ins->r.size == 1 && ins->d.size == 4 );
+}
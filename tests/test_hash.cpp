@@ -0,0 +1,105 @@
+#include <hexsuite/hash.hpp>
+#include "test.hpp"
+
+// "opcode reg, #value, reg" at the given address, with the right operand optionally being a nested "add reg, #1".
+//
+static minsn_t make( ea_t ea, mcode_t opcode, mreg_t l, uint64 value, mreg_t d, int size = 4, bool nested = false )
+{
+	minsn_t ins{ ea };
+	ins.opcode = opcode;
+	ins.l.make_reg( l, size );
+	if ( nested )
+	{
+		minsn_t* sub = new minsn_t( ea );
+		sub->opcode = m_add;
+		sub->l.make_reg( l, size );
+		sub->r.make_number( value, size );
+		sub->d.size = size;
+		ins.r.make_insn( sub );
+		ins.r.size = size;
+	}
+	else
+	{
+		ins.r.make_number( value, size );
+	}
+	ins.d.make_reg( d, size );
+	return ins;
+}
+
+TEST( hash_is_structural )
+{
+	minsn_t a = make( 0x1000, m_xor, 8, 5, 16 );
+	minsn_t b = make( 0x2000, m_xor, 8, 5, 16 );
+	CHECK( hex::hash_insn( a ) == hex::hash_insn( b ) );
+	CHECK( hex::structural_hash{}( a ) == hex::structural_hash{}( &b ) );
+	CHECK( hex::hash_mop( a.r ) == hex::hash_mop( b.r ) );
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 8, 5, 16, 4, true ) ) == hex::hash_insn( make( 0x3000, m_xor, 8, 5, 16, 4, true ) ) );
+
+	uint64_t h = hex::hash_insn( a );
+	CHECK( hex::hash_insn( make( 0x1000, m_or, 8, 5, 16 ) ) != h );             // Opcode.
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 8, 5, 16, 8 ) ) != h );          // Size.
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 24, 5, 16 ) ) != h );            // Register.
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 8, 6, 16 ) ) != h );             // Constant.
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 8, 5, 24 ) ) != h );             // Destination.
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 8, 5, 16, 4, true ) ) != h );    // Nested instruction.
+	CHECK( hex::hash_insn( make( 0x1000, m_xor, 8, 5, 16, 4, true ) ) != hex::hash_insn( make( 0x1000, m_xor, 8, 6, 16, 4, true ) ) );
+}
+
+TEST( memo_cache_accounting )
+{
+	hex::memo_cache cache{ 64 };
+	minsn_t a = make( 0x1000, m_xor, 8, 5, 16 );
+	CHECK( !cache.find( a ) );
+	cache.insert( a, hex::hash_insn( a ), std::make_unique<minsn_t>( make( 0, m_mov, 8, 0, 16 ) ) );
+	CHECK( cache.find( make( 0x2000, m_xor, 8, 5, 16 ) ) );
+	CHECK( !cache.find( make( 0x1000, m_xor, 8, 6, 16 ) ) );
+	CHECK( cache.stats.hits == 1 && cache.stats.misses == 2 && cache.stats.insertions == 1 && cache.stats.evictions == 0 );
+
+	// Simplification computes the result once and rewrites later instances keeping their address.
+	//
+	int calls = 0;
+	auto functor = [ & ] ( const minsn_t* ins ) { calls++; minsn_t r = *ins; r.opcode = m_or; return std::make_unique<minsn_t>( r ); };
+	minsn_t x = make( 0x3000, m_and, 8, 1, 16 );
+	minsn_t y = make( 0x4000, m_and, 8, 1, 16 );
+	CHECK( cache.simplify( &x, functor ) && cache.simplify( &y, functor ) );
+	CHECK( calls == 1 && y.opcode == m_or && y.ea == 0x4000 );
+
+	// A null result is remembered as well.
+	//
+	minsn_t z = make( 0x5000, m_sub, 8, 1, 16 );
+	CHECK( !cache.simplify( &z, [ & ] ( const minsn_t* ) { calls++; return std::unique_ptr<minsn_t>{}; } ) );
+	CHECK( !cache.simplify( &z, functor ) && calls == 2 && z.opcode == m_sub );
+}
+
+TEST( memo_cache_replacement )
+{
+	// A single set of four ways, the hashes are forced so that every entry maps to it.
+	//
+	hex::memo_cache cache{ 4 };
+	CHECK( cache.set_mask == 0 );
+	std::vector<minsn_t> keys;
+	for ( uint64 i = 0; i != 5; i++ )
+		keys.push_back( make( 0x1000, m_add, 8, i, 16 ) );
+	for ( uint64 i = 0; i != 4; i++ )
+		cache.insert( keys[ i ], i, nullptr );
+	CHECK( cache.find( keys[ 0 ], 0 ) );
+
+	// Entry 1 is now the least recently used and is replaced first, then entry 2.
+	//
+	cache.insert( keys[ 4 ], 4, nullptr );
+	CHECK( cache.stats.evictions == 1 );
+	CHECK( !cache.find( keys[ 1 ], 1 ) );
+	CHECK( cache.find( keys[ 0 ], 0 ) && cache.find( keys[ 3 ], 3 ) && cache.find( keys[ 4 ], 4 ) );
+	cache.insert( keys[ 1 ], 1, nullptr );
+	CHECK( !cache.find( keys[ 2 ], 2 ) );
+	CHECK( cache.find( keys[ 1 ], 1 ) );
+
+	// Equal hashes of different expressions are collisions, never hits.
+	//
+	hex::memo_cache::statistics before = cache.stats;
+	CHECK( !cache.find( keys[ 2 ], 0 ) );
+	CHECK( cache.stats.collisions == before.collisions + 1 && cache.stats.misses == before.misses + 1 && cache.stats.hits == before.hits );
+
+	cache.clear();
+	CHECK( !cache.find( keys[ 0 ], 0 ) );
+}
@@ -0,0 +1,158 @@
+#include <hexsuite/opcodes.hpp>
+#include <hexsuite/evaluator.hpp>
+#include "test.hpp"
+
+// Evaluates "op r8.4, r16.4" for the given operand values.
+//
+static uint64_t evaluate_condition( mcode_t op, uint64_t x, uint64_t y )
+{
+	minsn_t ins{ 0 };
+	ins.opcode = op;
+	ins.l.make_reg( 8, 4 );
+	ins.r.make_reg( 16, 4 );
+	ins.d.make_reg( 24, 1 );
+	hex::evaluator ev{ &ins };
+	uint64_t values[] = { x, y };
+	return ev.valid ? ev.evaluate( values ) : ~0ull;
+}
+
+TEST( condition_tables )
+{
+	static constexpr uint64_t values[] = { 0, 1, 2, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF };
+	for ( int i = m_setnz; i <= m_setle; i++ )
+	{
+		mcode_t op = mcode_t( i );
+		mcode_t inverse = hex::inverted_setcc( op );
+		mcode_t swapped = hex::swapped_condition( op );
+		CHECK( inverse != m_nop && hex::inverted_setcc( inverse ) == op );
+		CHECK( swapped != m_nop && hex::swapped_condition( swapped ) == op );
+
+		// The jump forms mirror the setcc forms.
+		//
+		mcode_t jcc = hex::setcc_to_jump( op );
+		CHECK( hex::jump_to_setcc( jcc ) == op );
+		CHECK( hex::inverted_jump( jcc ) == hex::setcc_to_jump( inverse ) );
+		CHECK( hex::swapped_condition( jcc ) == hex::setcc_to_jump( swapped ) );
+
+		for ( uint64_t x : values )
+		{
+			for ( uint64_t y : values )
+			{
+				uint64_t result = evaluate_condition( op, x, y );
+				CHECK( result <= 1 );
+				CHECK( evaluate_condition( inverse, x, y ) == ( result ^ 1 ) );
+				CHECK( evaluate_condition( swapped, y, x ) == result );
+			}
+		}
+	}
+
+	// Opcodes without a condition have no counterparts.
+	//
+	CHECK( hex::inverted_setcc( m_add ) == m_nop && hex::inverted_jump( m_goto ) == m_nop );
+	CHECK( hex::swapped_condition( m_sub ) == m_nop );
+	CHECK( hex::inverted_jump( m_setz ) == m_nop && hex::inverted_setcc( m_jz ) == m_nop );
+}
+
+// Evaluates "op r8.size, r16.size => r24.dsize", or "op r8.size, #y.size" if constant is set.
+//
+static uint64_t evaluate_binary( mcode_t op, int size, uint64_t x, uint64_t y, int dsize = 0, bool constant = false )
+{
+	minsn_t ins{ 0 };
+	ins.opcode = op;
+	ins.l.make_reg( 8, size );
+	if ( constant )
+		ins.r.make_number( y, size );
+	else
+		ins.r.make_reg( 16, size );
+	ins.d.make_reg( 24, dsize ? dsize : size );
+	hex::evaluator ev{ &ins };
+	uint64_t values[] = { x, y };
+	return ev.valid ? ev.evaluate( values ) : ~0ull;
+}
+
+template<typename T>
+static void check_kernels()
+{
+	using S = std::make_signed_t<T>;
+	constexpr int size = sizeof( T );
+	constexpr uint64_t bits = size * 8;
+	static constexpr uint64_t values[] = { 0, 1, 2, 3, 7, 0x7F, 0x80, 0xFF, 0x7FFF, 0x8000, 0xFFFF, 0x7FFFFFFF, 0x80000000, 0xFFFFFFFF,
+		0x123456789ABCDEF0, 0x8000000000000000, ~0ull };
+	for ( uint64_t vx : values )
+	{
+		for ( uint64_t vy : values )
+		{
+			// Inputs are truncated to the operand width, results to the destination width.
+			//
+			T x = ( T ) vx, y = ( T ) vy;
+			S sx = ( S ) x, sy = ( S ) y;
+			CHECK( evaluate_binary( m_add, size, vx, vy ) == ( T ) ( x + y ) );
+			CHECK( evaluate_binary( m_sub, size, vx, vy ) == ( T ) ( x - y ) );
+			CHECK( evaluate_binary( m_mul, size, vx, vy ) == ( T ) ( ( uint64_t ) x * y ) );
+			CHECK( evaluate_binary( m_and, size, vx, vy ) == ( T ) ( x & y ) );
+			CHECK( evaluate_binary( m_or, size, vx, vy ) == ( T ) ( x | y ) );
+			CHECK( evaluate_binary( m_xor, size, vx, vy ) == ( T ) ( x ^ y ) );
+			CHECK( evaluate_binary( m_add, size, vx, vy, 0, true ) == ( T ) ( x + y ) );
+
+			// Division by zero yields zero, the overflowing signed division wraps.
+			//
+			CHECK( evaluate_binary( m_udiv, size, vx, vy ) == ( y ? x / y : 0 ) );
+			CHECK( evaluate_binary( m_umod, size, vx, vy ) == ( y ? x % y : 0 ) );
+			T sdiv = sy == 0 ? 0 : sy == -1 ? ( T ) ( 0 - ( uint64_t ) x ) : ( T ) ( sx / sy );
+			T smod = sy == 0 || sy == -1 ? 0 : ( T ) ( sx % sy );
+			CHECK( evaluate_binary( m_sdiv, size, vx, vy ) == sdiv );
+			CHECK( evaluate_binary( m_smod, size, vx, vy ) == smod );
+
+			// Shift counts of the operand width or more.
+			//
+			uint64_t n = vy % ( bits + 4 );
+			CHECK( evaluate_binary( m_shl, size, vx, n ) == ( n >= bits ? 0 : ( T ) ( ( uint64_t ) x << n ) ) );
+			CHECK( evaluate_binary( m_shr, size, vx, n ) == ( n >= bits ? 0 : ( T ) ( x >> n ) ) );
+			CHECK( evaluate_binary( m_sar, size, vx, n ) == ( T ) ( n >= bits ? ( sx < 0 ? -1 : 0 ) : sx >> n ) );
+
+			CHECK( evaluate_binary( m_cfadd, size, vx, vy, 1 ) == ( ( T ) ( x + y ) < x ) );
+			CHECK( evaluate_binary( m_setp, size, vx, vy, 1 ) == ( ( std::popcount( ( uint8_t ) ( x - y ) ) & 1 ) == 0 ) );
+		}
+	}
+}
+
+TEST( arithmetic_kernels )
+{
+	check_kernels<uint8_t>();
+	check_kernels<uint16_t>();
+	check_kernels<uint32_t>();
+	check_kernels<uint64_t>();
+
+	// Width changes.
+	//
+	auto unary = [ ] ( mcode_t op, int size, int dsize, uint64_t x )
+	{
+		minsn_t ins{ 0 };
+		ins.opcode = op;
+		ins.l.make_reg( 8, size );
+		ins.d.make_reg( 24, dsize );
+		hex::evaluator ev{ &ins };
+		uint64_t values[] = { x };
+		return ev.valid ? ev.evaluate( values ) : ~0ull;
+	};
+	CHECK( unary( m_xds, 1, 4, 0x180 ) == 0xFFFFFF80 );
+	CHECK( unary( m_xdu, 1, 4, 0x180 ) == 0x80 );
+	CHECK( unary( m_low, 8, 4, 0x1122334455667788 ) == 0x55667788 );
+	CHECK( unary( m_high, 8, 4, 0x1122334455667788 ) == 0x11223344 );
+	CHECK( unary( m_high, 8, 2, 0x1122334455667788 ) == 0x1122 );
+	CHECK( unary( m_neg, 2, 2, 1 ) == 0xFFFF );
+	CHECK( unary( m_bnot, 1, 1, 0x0F ) == 0xF0 );
+	CHECK( unary( m_lnot, 4, 1, 0x100000000 ) == 1 );
+
+	// Missing inputs and unsupported operand widths.
+	//
+	minsn_t ins{ 0 };
+	ins.opcode = m_add;
+	ins.l.make_reg( 8, 4 );
+	ins.r.make_reg( 16, 4 );
+	ins.d.make_reg( 24, 4 );
+	hex::evaluator ev{ &ins };
+	uint64_t one[] = { 5 };
+	CHECK( ev.valid && ev.evaluate( one ) == 0 );
+	CHECK( evaluate_binary( m_add, 3, 1, 2 ) == ~0ull );
+}
@@ -0,0 +1,83 @@
+#include <hexsuite/patterns.hpp>
+#include <hexsuite/expressions.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+using namespace hex::pat;
+
+// x ^ x => 0 and (x ^ y) + 2 * (x & y) => x + y.
+//
+static auto make_rules( int& zeroed, int& folded )
+{
+	return rule_set{
+		rule<insn<m_xor, cap<0>, cap<0>>>( [ &zeroed ] ( minsn_t* ins, captures& )
+		{
+			ins->opcode = m_mov;
+			ins->l.make_number( 0, ins->l.size );
+			ins->r.erase();
+			zeroed++;
+			return true;
+		} ),
+		rule<insn<m_add, insn<m_xor, cap<0>, cap<1>>, insn<m_mul, num<2>, insn<m_and, cap<0>, cap<1>>>>>( [ &folded ] ( minsn_t* ins, captures& c )
+		{
+			mop_t x = c[ 0 ], y = c[ 1 ];
+			ins->l = x;
+			ins->r = y;
+			folded++;
+			return true;
+		} ),
+	};
+}
+
+TEST( rules_match_top_level )
+{
+	int zeroed = 0, folded = 0;
+	auto rules = make_rules( zeroed, folded );
+	auto opt = rules.optimizer();
+	opt.install();
+
+	auto mba = fixture::chain( 1, 0 );
+	mblock_t* blk = mba->get_mblock( 0 );
+	hex::insn_sequence seq{ 0x1000 };
+	minsn_t* same = seq.emit( m_xor, hex::reg( 8, 4 ), hex::reg( 8, 4 ), hex::reg( 16, 4 ) );
+	minsn_t* other = seq.emit( m_xor, hex::reg( 8, 4 ), hex::reg( 24, 4 ), hex::reg( 16, 4 ) );
+	minsn_t* add = seq.emit( m_add, hex::reg( 8, 4 ), hex::reg( 24, 4 ), hex::reg( 16, 4 ) );
+	seq.append_to( blk );
+
+	CHECK( stub::run_optinsn( blk, other ) == 0 );
+	CHECK( stub::run_optinsn( blk, add ) == 0 );
+	CHECK( stub::run_optinsn( blk, same ) == 1 );
+	CHECK( same->opcode == m_mov && same->l.t == mop_n && same->l.nnn->value == 0 && same->r.t == mop_z );
+	CHECK( zeroed == 1 && folded == 0 );
+	opt.uninstall();
+}
+
+TEST( rules_match_nested )
+{
+	int zeroed = 0, folded = 0;
+	auto rules = make_rules( zeroed, folded );
+
+	// mov ((r1 ^ r2) + 2 * (r1 & r2)), r4
+	//
+	mop_t r1, r2;
+	r1.make_reg( 8, 4 );
+	r2.make_reg( 16, 4 );
+	auto e = ( hex::x( r1 ) ^ hex::x( r2 ) ) + 2 * ( hex::x( r1 ) & hex::x( r2 ) );
+	auto mov = hex::make_mov( 0x1000, hex::build_operand( 0x1000, e ), hex::reg( 32, 4 ) );
+
+	// The opcode dispatched optimizer never sees the nested add, the nested one does.
+	//
+	auto top = rules.optimizer();
+	top.install();
+	CHECK( stub::run_optinsn( nullptr, mov.get() ) == 0 );
+	top.uninstall();
+
+	auto nested = rules.nested_optimizer();
+	nested.install();
+	CHECK( stub::run_optinsn( nullptr, mov.get() ) == 1 );
+	CHECK( folded == 1 && zeroed == 0 );
+	CHECK( mov->opcode == m_mov && mov->l.is_insn( m_add ) );
+	CHECK( mov->l.d->l.equal_mops( r1, 0 ) && mov->l.d->r.equal_mops( r2, 0 ) );
+	CHECK( stub::run_optinsn( nullptr, mov.get() ) == 0 );
+	nested.uninstall();
+}
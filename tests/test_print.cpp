@@ -0,0 +1,97 @@
+#include <hexsuite/print.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+// Printable with color tags around the opcode.
+//
+struct tagged
+{
+	const char* text;
+	void print( qstring* out ) const { out->cat_sprnt( "\x01\x0c" "insn\x02\x0c %s", text ); }
+};
+
+static const char* const chain_text =
+	"; 1-WAY-BLOCK 0 [START=1000 END=1010]\n"
+	"0. 0 \x01\x0c" "00001000\x02\x0c mov r0.4, r8.4\n"
+	"0. 1 \x01\x0c" "00001004\x02\x0c add r8.4, #0x2.4, r32.4\n"
+	"; 0-WAY-BLOCK 1 [START=1010 END=1020]\n"
+	"1. 0 \x01\x0c" "00001010\x02\x0c add r8.4, #0x1.4, r16.4\n"
+	"1. 1 \x01\x0c" "00001014\x02\x0c xor r16.4, #0x2.4, r40.4\n";
+static const char* const chain_plain =
+	"; 1-WAY-BLOCK 0 [START=1000 END=1010]\n"
+	"0. 0 00001000 mov r0.4, r8.4\n"
+	"0. 1 00001004 add r8.4, #0x2.4, r32.4\n"
+	"; 0-WAY-BLOCK 1 [START=1010 END=1020]\n"
+	"1. 0 00001010 add r8.4, #0x1.4, r16.4\n"
+	"1. 1 00001014 xor r16.4, #0x2.4, r40.4\n";
+
+TEST( print_strings )
+{
+	qstring s{ "\x01\x0c" "mov\x02\x0c r0.4" };
+	CHECK( hex::to_string( hex::strip_tags( s ) ) == "mov r0.4" );
+	qstring plain{ "mov r0.4" };
+	CHECK( hex::to_string( hex::strip_tags( plain ) ) == "mov r0.4" );
+
+	auto mba = fixture::chain( 2, 2 );
+	minsn_t* ins = mba->get_mblock( 1 )->tail;
+	CHECK( hex::to_string( ins ) == "xor r16.4, #0x2.4, r40.4" );
+	CHECK( hex::to_string( *ins ) == hex::to_string( ins ) );
+	CHECK( hex::to_string( tagged{ "r0.4" } ) == "\x01\x0c" "insn\x02\x0c r0.4" );
+
+	// The buffer overloads append and only strip tags on request.
+	//
+	std::string out = "> ";
+	hex::to_string( tagged{ "r0.4" }, out );
+	CHECK( out == "> \x01\x0c" "insn\x02\x0c r0.4" );
+	out = "> ";
+	hex::to_string( tagged{ "r8.4" }, out, true );
+	hex::to_string( ins, out.append( "; " ), true );
+	CHECK( out == "> insn r8.4; xor r16.4, #0x2.4, r40.4" );
+}
+
+TEST( print_dump )
+{
+	auto mba = fixture::chain( 2, 2 );
+	std::vector<std::string> chunks;
+	auto sink = [ & ] ( std::string_view chunk ) { chunks.emplace_back( chunk ); };
+
+	hex::dump( mba.get(), sink );
+	CHECK( chunks.size() == 1 && chunks[ 0 ] == chain_plain );
+	chunks.clear();
+	hex::dump( *mba, sink, false );
+	CHECK( chunks.size() == 1 && chunks[ 0 ] == chain_text );
+
+	// A small threshold flushes at every line boundary.
+	//
+	chunks.clear();
+	hex::dump( mba.get(), sink, true, 1 );
+	CHECK( chunks.size() == 6 && chunks[ 1 ] == "0. 0 00001000 mov r0.4, r8.4\n" );
+	std::string joined;
+	for ( auto& c : chunks )
+		joined += c;
+	CHECK( joined == chain_plain );
+
+	// Indentation is expanded and a missing newline is added.
+	//
+	chunks.clear();
+	{
+		hex::stream_printer printer{ sink, false, 1024 };
+		CHECK( printer.print( 2, "%s", "a" ) == 4 );
+		printer.print( 0, "b %d\n", 1 );
+		CHECK( chunks.empty() );
+	}
+	CHECK( chunks.size() == 1 && chunks[ 0 ] == "  a\nb 1\n" );
+}
+
+#if __cpp_lib_format
+TEST( print_format )
+{
+	auto mba = fixture::chain( 2, 2 );
+	minsn_t* ins = mba->get_mblock( 1 )->tail;
+	CHECK( std::format( "{}", *ins ) == "xor r16.4, #0x2.4, r40.4" );
+	CHECK( std::format( "[{}]", ins ) == "[xor r16.4, #0x2.4, r40.4]" );
+	CHECK( std::format( "{}", tagged{ "r0.4" } ) == "insn r0.4" );
+	CHECK( std::format( "{:>10}", tagged{ "r0" } ) == "   insn r0" );
+	CHECK( std::format( "{}", ( minsn_t* ) nullptr ) == "(null)" );
+}
+#endif
@@ -0,0 +1,91 @@
+// Built into its own executable with HEXSUITE_PROFILE and HEXSUITE_PROFILE_HISTOGRAM defined project-wide.
+//
+#include <hexsuite/components.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+static_assert( HEXSUITE_PROFILE && HEXSUITE_PROFILE_HISTOGRAM, "The profiled tests must be built with profiling enabled." );
+
+TEST( profile_records_invocations )
+{
+	hex::component_stats stats;
+	stats.set_name( "manual" );
+	stats.record( 0, false );
+	stats.record( 1, true );
+	stats.record( 1000, true );
+	stats.record( ~0ull, false );
+	CHECK( stats.invocations == 4 && stats.changes == 2 );
+	CHECK( stats.max_ns == ~0ull );
+
+	// Bucket n counts [2^(n-1), 2^n) nanoseconds, the last bucket everything above.
+	//
+	CHECK( stats.histogram[ 0 ] == 1 && stats.histogram[ 1 ] == 1 && stats.histogram[ 10 ] == 1 );
+	CHECK( stats.histogram.back() == 1 );
+	uint64_t total = 0;
+	for ( uint64_t n : stats.histogram )
+		total += n;
+	CHECK( total == stats.invocations );
+
+	CHECK( hex::profile( stats, [ ] { return 3; } ) == 3 );
+	CHECK( hex::profile( stats, [ ] { return 0; } ) == 0 );
+	CHECK( stats.invocations == 6 && stats.changes == 3 );
+
+	hex::profiling::reset();
+	CHECK( stats.invocations == 0 && stats.changes == 0 && stats.max_ns == 0 && stats.histogram[ 10 ] == 0 );
+}
+
+TEST( profile_registry )
+{
+	size_t before = 0;
+	hex::profiling::for_each( [ & ] ( hex::component_stats& ) { before++; } );
+	{
+		hex::component_stats a;
+		hex::component_stats copy = a;
+		size_t live = 0;
+		hex::profiling::for_each( [ & ] ( hex::component_stats& ) { live++; } );
+		CHECK( live == before + 2 );
+	}
+	size_t after = 0;
+	hex::profiling::for_each( [ & ] ( hex::component_stats& ) { after++; } );
+	CHECK( after == before );
+}
+
+TEST( profile_components )
+{
+	auto opt = hex::insn_optimizer_for<m_xor>( [ ] ( mblock_t*, minsn_t*, int ) { return 1; } );
+	opt.named( "xor-folder" ).install();
+	auto mba = fixture::chain( 1, 16 );
+	mblock_t* blk = mba->get_mblock( 0 );
+	for ( minsn_t* ins = blk->head; ins; ins = ins->next )
+		stub::run_optinsn( blk, ins );
+	opt.uninstall();
+
+	hex::component_stats* stats = opt.statistics();
+	CHECK( stats && stats->name && std::string{ stats->name } == "xor-folder" );
+	CHECK( stats->invocations == 2 && stats->changes == 2 );
+}
+
+TEST( profile_report )
+{
+	hex::component_stats slow, fast, odd;
+	slow.set_name( "slow" );
+	fast.set_name( "fast" );
+	odd.set_name( "say \"hi\"\\\n" );
+	slow.record( 5000000, true );
+	slow.record( 1000000, false );
+	fast.record( 1000, false );
+
+	// The table is sorted by cumulative time.
+	//
+	std::string report = hex::profiling::report();
+	size_t header = report.find( "Component" ), s = report.find( "slow" ), f = report.find( "fast" );
+	CHECK( header == 0 && s != std::string::npos && f != std::string::npos && s < f );
+	CHECK( report.find( "50.00%" ) != std::string::npos );
+	CHECK( report.find( "6.000" ) != std::string::npos );    // Total milliseconds of slow.
+
+	std::string json = hex::profiling::dump_json();
+	CHECK( json.front() == '[' && json.back() == ']' );
+	CHECK( json.find( "{\"name\": \"slow\", \"invocations\": 2, \"changes\": 1, \"total_ns\": 6000000, \"max_ns\": 5000000, \"histogram\": [" ) != std::string::npos );
+	CHECK( json.find( "\"name\": \"say \\\"hi\\\"\\\\\\u000a\"" ) != std::string::npos );
+	CHECK( json.find( '\n', json.find( "say" ) ) > json.find( "}", json.find( "say" ) ) );
+}
@@ -0,0 +1,57 @@
+#include <hexsuite/ranges.hpp>
+#include <hexsuite/visitors.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+TEST( instruction_range )
+{
+	auto mba = fixture::chain( 3, 5 );
+	mblock_t* blk = mba->get_mblock( 1 );
+	CHECK( hex::instructions( blk ).size() == 5 );
+
+	minsn_t* prev = nullptr;
+	for ( minsn_t* ins : hex::instructions( blk ) )
+		CHECK( std::exchange( prev, ins ) == ins->prev );
+	CHECK( prev == blk->tail );
+	CHECK( hex::collect_instructions( blk ).back() == blk->tail );
+}
+
+TEST( block_orders )
+{
+	auto mba = fixture::flattened( 4, 2 );
+	CHECK( hex::basic_blocks( mba.get() ).size() == 7 );
+
+	auto rpo = hex::reverse_post_order( mba.get() );
+	CHECK( rpo.size() == 7 );
+	CHECK( rpo[ 0 ] == mba->get_mblock( 0 ) );
+	CHECK( rpo[ 1 ] == mba->get_mblock( 1 ) );
+
+	std::vector<int> succ;
+	for ( mblock_t* blk : hex::successors( mba->get_mblock( 1 ) ) )
+		succ.push_back( blk->serial );
+	CHECK( succ == std::vector<int>{ 2, 3, 4, 5 } );
+}
+
+TEST( walk_matches_visitor )
+{
+	auto tree = fixture::body( 32 );
+	size_t walked = 0, visited = 0;
+	hex::walk_ctree<cot_var>( tree->root, [ & ] ( cexpr_t* ) { walked++; } );
+
+	struct counter : ctree_visitor_t
+	{
+		size_t& n;
+		counter( size_t& n ) : ctree_visitor_t( CV_FAST ), n( n ) {}
+		int idaapi visit_expr( cexpr_t* e ) override { n += e->op == cot_var; return 0; }
+	} v{ visited };
+	v.apply_to( tree->root, nullptr );
+	CHECK( walked == visited );
+	CHECK( walked == 32 / 4 * 3 * 2 + 32 / 4 * 5 );
+}
+
+TEST( walk_null_root )
+{
+	size_t n = 0;
+	CHECK( hex::walk_ctree<cot_var>( nullptr, [ & ] ( cexpr_t* ) { n++; } ) );
+	CHECK( n == 0 );
+}
@@ -0,0 +1,53 @@
+#include <string>
+#include <hexsuite/scheduler.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+TEST( scheduler_install_order_and_backoff )
+{
+	std::string trace;
+	auto make = [ & ] ( char name, bool changes )
+	{
+		return hex::insn_optimizer{ [ &trace, name, changes ] ( mblock_t*, minsn_t*, int ) { trace += name; return changes ? 1 : 0; } };
+	};
+	hex::insn_optimizer low = make( 'a', true ), high = make( 'b', true ), late = make( 'c', false );
+
+	hex::scheduler sched;
+	sched.add( low, { .priority = 1 } );
+	sched.add( late, { .min_maturity = MMAT_LOCOPT, .priority = 5, .backoff = 2 } );
+	sched.add( high, { .priority = 10 } );
+	sched.install();
+
+	auto mba = fixture::chain( 1, 1 );
+	mblock_t* blk = mba->get_mblock( 0 );
+	auto phase = [ & ] ( hexrays_event_t evt, mba_maturity_t maturity )
+	{
+		mba->maturity = maturity;
+		stub::raise_hexrays( evt, mba.get() );
+		trace.clear();
+		stub::run_optinsn( blk, blk->head, 0 );
+		return trace;
+	};
+
+	// Installed by priority, the late component only from MMAT_LOCOPT on.
+	//
+	CHECK( phase( hxe_microcode, MMAT_GENERATED ) == "ba" );
+	CHECK( phase( hxe_preoptimized, MMAT_PREOPTIMIZED ) == "ba" );
+	CHECK( phase( hxe_locopt, MMAT_LOCOPT ) == "bca" );
+
+	// Two phases without changes back the late component off for the rest of the function.
+	//
+	CHECK( phase( hxe_calls_done, MMAT_CALLS ) == "bca" );
+	CHECK( phase( hxe_prealloc, MMAT_GLBOPT2 ) == "ba" );
+	CHECK( phase( hxe_glbopt, MMAT_GLBOPT3 ) == "ba" );
+
+	// A new function resets the back off, the ctree uninstalls everything.
+	//
+	CHECK( phase( hxe_microcode, MMAT_GENERATED ) == "ba" );
+	CHECK( phase( hxe_locopt, MMAT_LOCOPT ) == "bca" );
+	stub::raise_hexrays( hxe_maturity, ( cfunc_t* ) nullptr, 0 );
+	CHECK( stub::optinsn_count() == 0 );
+
+	sched.uninstall();
+	CHECK( stub::hexrays_callback_count() == 0 );
+}
@@ -0,0 +1,170 @@
+#include <hexsuite/snapshot.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+// Checks the block, instruction and operand columns against the source for every top-level instruction.
+//
+static bool matches( const hex::mba_snapshot& s, mba_t* mba )
+{
+	bool ok = s.block_count() == ( size_t ) mba->qty && s.entry_ea == mba->entry_ea && s.maturity == ( int ) mba->maturity;
+	auto operand_matches = [ & ] ( uint32_t idx, const mop_t& op )
+	{
+		if ( op.t == mop_z )
+			return idx == hex::mba_snapshot::none;
+		if ( s.operand_type[ idx ] != op.t || s.operand_size[ idx ] != op.size )
+			return false;
+		switch ( op.t )
+		{
+			case mop_r:
+			case mop_S:
+			case mop_v:   return s.locations[ s.operand_value[ idx ] ] == hex::location_key::of( op );
+			case mop_n:   return s.operand_value[ idx ] == op.nnn->value;
+			default:      return true;
+		}
+	};
+	for ( int b = 0; ok && b != mba->qty; b++ )
+	{
+		mblock_t* blk = mba->get_mblock( b );
+		ok &= s.block_start[ b ] == blk->start && s.block_end[ b ] == blk->end;
+		ok &= std::equal( s.successors( b ).begin(), s.successors( b ).end(), blk->succset.begin(), blk->succset.end() );
+		ok &= std::equal( s.predecessors( b ).begin(), s.predecessors( b ).end(), blk->predset.begin(), blk->predset.end() );
+
+		auto insns = s.instructions( b );
+		size_t n = 0;
+		for ( minsn_t* ins = blk->head; ok && ins; ins = ins->next, n++ )
+		{
+			ok &= n < insns.size();
+			if ( !ok )
+				break;
+			uint32_t i = insns[ n ];
+			ok &= s.opcode[ i ] == ins->opcode && s.ea[ i ] == ins->ea && s.size[ i ] == ins->d.size;
+			ok &= s.block[ i ] == ( uint32_t ) b && s.parent[ i ] == hex::mba_snapshot::none;
+			ok &= operand_matches( s.l[ i ], ins->l ) && operand_matches( s.r[ i ], ins->r ) && operand_matches( s.d[ i ], ins->d );
+		}
+		ok &= n == insns.size();
+	}
+	return ok;
+}
+
+TEST( snapshot_of_fixtures )
+{
+	for ( auto& mba : { fixture::chain( 4, 6 ), fixture::flattened( 5, 3 ) } )
+	{
+		auto s = hex::snapshot( mba.get() );
+		CHECK( matches( *s, mba.get() ) );
+		CHECK( s->unsupported_operands == 0 );
+	}
+	auto mba = fixture::flattened( 5, 3 );
+	auto s = hex::snapshot( mba.get() );
+	CHECK( s->successors( 1 ).size() == 5 && s->predecessors( 1 ).size() == 5 );
+
+	// Registers are interned once.
+	//
+	std::vector<hex::location_key> sorted = s->locations;
+	std::sort( sorted.begin(), sorted.end(), [ ] ( auto& a, auto& b ) { return std::tie( a.t, a.value, a.size ) < std::tie( b.t, b.value, b.size ); } );
+	CHECK( std::adjacent_find( sorted.begin(), sorted.end() ) == sorted.end() );
+}
+
+TEST( snapshot_nested_operands )
+{
+	// 0: r0.8 = add( r8.4 pair r16.4, #3 ) ; 1: call $1000( r24.4, mul r8.4, #2 ) ; 2: jtbl r32.4, cases ; 3: fp ; 4: scattered
+	//
+	fixture::mba_ptr mba{ stub::create_mba( 1 ) };
+	mblock_t* blk = mba->get_mblock( 0 );
+	auto insert = [ & ] ( mcode_t opcode ) { minsn_t* ins = new minsn_t( blk->start + ( blk->tail ? 4 : 0 ) ); ins->opcode = opcode; return blk->insert_into_block( ins, blk->tail ); };
+
+	minsn_t* add = insert( m_mov );
+	minsn_t* sub = new minsn_t( add->ea );
+	sub->opcode = m_add;
+	sub->l.make_reg_pair( 8, 16, 4 );
+	sub->r.make_number( 3, 8 );
+	sub->d.size = 8;
+	add->l.make_insn( sub );
+	add->l.size = 8;
+	add->d.make_reg( 0, 8 );
+
+	minsn_t* call = insert( m_call );
+	call->l.make_gvar( 0x1000 );
+	call->d.t = mop_f;
+	call->d.f = new mcallinfo_t( 0x1000 );
+	mcallarg_t arg;
+	arg.make_reg( 24, 4 );
+	call->d.f->args.push_back( arg );
+	minsn_t* mul = new minsn_t( call->ea );
+	mul->opcode = m_mul;
+	mul->l.make_reg( 8, 4 );
+	mul->r.make_number( 2, 4 );
+	mul->d.size = 4;
+	arg.make_insn( mul );
+	arg.size = 4;
+	call->d.f->args.push_back( arg );
+
+	minsn_t* jtbl = insert( m_jtbl );
+	jtbl->l.make_reg( 32, 4 );
+	jtbl->r.t = mop_c;
+	jtbl->r.c = new mcases_t;
+	jtbl->r.c->targets.push_back( 0 );
+	jtbl->r.c->targets.push_back( 0 );
+	jtbl->r.c->values.resize( 2 );
+	jtbl->r.c->values[ 0 ].push_back( 1 );
+	jtbl->r.c->values[ 0 ].push_back( 2 );
+	jtbl->r.c->values[ 1 ].push_back( 7 );
+
+	minsn_t* fp = insert( m_mov );
+	uint32_t one = 0x3F800000;
+	fp->l.make_fpnum( &one, 4 );
+	fp->d.make_reg( 40, 4 );
+
+	minsn_t* scattered = insert( m_mov );
+	scattered->l.t = mop_sc;
+	scattered->l.size = 8;
+	scattered->d.make_reg( 48, 8 );
+
+	auto s = hex::snapshot( mba.get() );
+	CHECK( matches( *s, mba.get() ) );
+	auto top = s->instructions( 0 );
+	CHECK( top.size() == 5 && s->insn_count() == 7 );
+
+	// Sub-instructions point back at their owner, pairs occupy two consecutive operands.
+	//
+	uint32_t l = s->l[ top[ 0 ] ];
+	CHECK( s->operand_type[ l ] == mop_d );
+	uint32_t inner = ( uint32_t ) s->operand_value[ l ];
+	CHECK( s->opcode[ inner ] == m_add && s->parent[ inner ] == top[ 0 ] && s->block[ inner ] == 0 && s->size[ inner ] == 8 );
+	uint32_t pair = ( uint32_t ) s->operand_value[ s->l[ inner ] ];
+	CHECK( s->operand_type[ s->l[ inner ] ] == mop_p && s->operand_size[ s->l[ inner ] ] == 8 );
+	CHECK( s->operand_type[ pair ] == mop_r && s->locations[ s->operand_value[ pair ] ] == ( hex::location_key{ mop_r, 8, 4 } ) );
+	CHECK( s->operand_type[ pair + 1 ] == mop_r && s->locations[ s->operand_value[ pair + 1 ] ] == ( hex::location_key{ mop_r, 16, 4 } ) );
+	CHECK( s->operand_value[ s->r[ inner ] ] == 3 );
+
+	// Calls keep their callee and argument operands, arguments may nest instructions.
+	//
+	uint32_t d = s->d[ top[ 1 ] ];
+	CHECK( s->operand_type[ d ] == mop_f );
+	uint32_t ci = ( uint32_t ) s->operand_value[ d ];
+	CHECK( s->call_callee[ ci ] == 0x1000 );
+	auto args = s->arguments( ci );
+	CHECK( args.size() == 2 );
+	CHECK( s->operand_type[ args[ 0 ] ] == mop_r && s->locations[ s->operand_value[ args[ 0 ] ] ] == ( hex::location_key{ mop_r, 24, 4 } ) );
+	CHECK( s->operand_type[ args[ 1 ] ] == mop_d );
+	uint32_t nested = ( uint32_t ) s->operand_value[ args[ 1 ] ];
+	CHECK( s->opcode[ nested ] == m_mul && s->parent[ nested ] == top[ 1 ] );
+
+	// Switch cases, floating point constants and the unsupported scattered operand.
+	//
+	uint32_t cases = s->r[ top[ 2 ] ];
+	CHECK( s->operand_type[ cases ] == mop_c );
+	uint32_t sw = ( uint32_t ) s->operand_value[ cases ];
+	CHECK( s->targets( sw ).size() == 2 );
+	uint32_t first = s->switch_offsets[ sw ];
+	CHECK( ( std::vector<uint64_t>{ s->values( first ).begin(), s->values( first ).end() } == std::vector<uint64_t>{ 1, 2 } ) );
+	CHECK( ( std::vector<uint64_t>{ s->values( first + 1 ).begin(), s->values( first + 1 ).end() } == std::vector<uint64_t>{ 7 } ) );
+
+	uint32_t fn = s->l[ top[ 3 ] ];
+	CHECK( s->operand_type[ fn ] == mop_fn && s->operand_size[ fn ] == 4 );
+	CHECK( std::equal( fp->l.fpc->fnum, fp->l.fpc->fnum + 6, s->fp_constants[ s->operand_value[ fn ] ].begin() ) );
+
+	uint32_t sc = s->l[ top[ 4 ] ];
+	CHECK( s->operand_type[ sc ] == mop_sc && s->operand_value[ sc ] == hex::mba_snapshot::none );
+	CHECK( s->unsupported_operands == 1 );
+}
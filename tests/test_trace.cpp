@@ -0,0 +1,59 @@
+#include <filesystem>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <hexsuite/trace.hpp>
+#include "test.hpp"
+
+TEST( ring_flushes_after_late_open )
+{
+	using ring_t = hex::trace::thread_ring;
+	auto path = ( std::filesystem::temp_directory_path() / "hexsuite_test_trace.bin" ).string();
+	auto ring = std::make_unique<ring_t>();
+
+	// Overflow the ring before any sink is open, an early flush writes nothing and the backlog is flushed by the first
+	// push once a sink is open.
+	//
+	for ( size_t i = 0; i != ring_t::capacity + 10; i++ )
+		ring->push( { i, 0, 0, m_nop, m_nop } );
+	ring->flush();
+	CHECK( ring->count - ring->flushed == ring_t::capacity );
+	CHECK( hex::trace::open( path.c_str(), 1 << 16 ) );
+	ring->push( { 0, 0, 0, m_nop, m_nop } );
+	CHECK( hex::trace::sink::instance().header.load()->cursor == ring_t::capacity );
+	CHECK( ring->flushed == ring->count );
+	const hex::trace_entry* written = hex::trace::file_entries( hex::trace::sink::instance().header.load() );
+	CHECK( written[ 0 ].ea == 11 && written[ ring_t::capacity - 2 ].ea == ring_t::capacity + 9 && written[ ring_t::capacity - 1 ].ea == 0 );
+
+	hex::trace::sink::instance().close();
+	ring.reset();
+	std::filesystem::remove( path );
+}
+
+TEST( close_waits_for_writers )
+{
+	auto path = ( std::filesystem::temp_directory_path() / "hexsuite_test_trace_close.bin" ).string();
+	auto& sink = hex::trace::sink::instance();
+	CHECK( sink.open( path.c_str(), 1 << 12 ) );
+
+	// Keep writing from another thread while the file is closed, the writer must never touch the unmapped view.
+	//
+	std::atomic<bool> stop = false;
+	std::atomic<size_t> writes = 0;
+	std::thread writer{ [ & ]
+	{
+		hex::trace_entry entries[ 64 ] = {};
+		while ( !stop.load() )
+		{
+			sink.write( entries, std::size( entries ) );
+			writes++;
+		}
+	} };
+	while ( writes.load() < 16 )
+		std::this_thread::yield();
+	sink.close();
+	CHECK( !sink.header.load() );
+	stop = true;
+	writer.join();
+	std::filesystem::remove( path );
+}
@@ -0,0 +1,22 @@
+#include <hexsuite/types.hpp>
+#include "test.hpp"
+
+static_assert( !std::is_copy_constructible_v<hex::type_index> && !std::is_copy_assignable_v<hex::type_index> );
+
+TEST( type_index_survives_moves )
+{
+	stub::reset();
+	stub::db().local_types = { { "first", tinfo_t{ BT_INT32 } }, { "second", tinfo_t{ BT_INT64 } } };
+
+	hex::type_index source{ hex::local_type_lib() };
+	hex::type_index index = std::move( source );
+	CHECK( index.size() == 2 );
+	CHECK( index.name( 2 ) && *index.name( 2 ) == "second" );
+	CHECK( index.ordinal( "first" ) == 1 );
+
+	hex::type_index other;
+	other = std::move( index );
+	CHECK( other.name( 1 ) && *other.name( 1 ) == "first" );
+	CHECK( other.type( "second" ) && *other.type( "second" ) == tinfo_t{ BT_INT64 } );
+	stub::reset();
+}
@@ -0,0 +1,35 @@
+#include <hexsuite/use_def.hpp>
+#include "test.hpp"
+#include "fixtures.hpp"
+
+TEST( use_def_overlapping_sizes )
+{
+	// mov #1, r8.4 ; mov r8.1, r16.1 ; mov r9.2, r24.2 ; mov r12.4, r32.4
+	//
+	auto mba = fixture::chain( 1, 0 );
+	mblock_t* blk = mba->get_mblock( 0 );
+	minsn_t* def = fixture::emit( blk, m_mov, -1, -1, 1 );
+	def->l.make_number( 1, 4 );
+	minsn_t* low = fixture::emit( blk, m_mov, 1, -1, 2, 1 );
+	minsn_t* mid = fixture::emit( blk, m_mov, -1, -1, 3, 2 );
+	mid->l.make_reg( 9, 2 );
+	minsn_t* next = fixture::emit( blk, m_mov, -1, -1, 4 );
+	next->l.make_reg( 12, 4 );
+
+	hex::use_def_index index{ mba.get() };
+	mop_t op;
+	op.make_reg( 8, 4 );
+	auto uses = index.uses( op );
+	CHECK( uses.size() == 2 );
+	CHECK( std::is_sorted( uses.begin(), uses.end() ) );
+	CHECK( std::any_of( uses.begin(), uses.end(), [ & ] ( auto& s ) { return s.ins == low; } ) );
+	CHECK( std::any_of( uses.begin(), uses.end(), [ & ] ( auto& s ) { return s.ins == mid; } ) );
+
+	op.make_reg( 10, 1 );
+	CHECK( index.defs( op ).size() == 1 && index.defs( op )[ 0 ].ins == def );
+	CHECK( index.uses( op ).size() == 1 && index.uses( op )[ 0 ].ins == mid );
+	op.make_reg( 11, 1 );
+	CHECK( index.is_used( op ) == false );
+	op.make_reg( 12, 1 );
+	CHECK( index.is_used( op ) && index.defs( op ).empty() );
+}